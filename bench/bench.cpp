@@ -0,0 +1,305 @@
+#include "progen.h"
+#include "lexer.h"
+#include "myparser.h"
+#include "intercode.h"
+#include "asmgen.h"
+#include "compiler.h"
+#include "threadpool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// 编译器吞吐量基准测试
+// 对每种程序形状和大小：生成程序，分别计时词法分析、语法分析、中间代码生成、汇编生成，
+// 再计时一次完整的 compileSource（包括调用图优化），结果写成 JSON 便于在不同提交之间对比
+// 每个用例在独立的子进程中运行，峰值内存只包含该用例
+
+// 一个用例的结果，只包含定长字段，子进程通过管道原样传回
+struct CaseResult {
+    int shape;
+    uint64_t seed;
+    uint64_t bytes;
+    uint64_t tokens;
+    uint64_t nodes;
+    uint64_t quads;
+    uint64_t asmLines;
+    double lexSec;     // 只做词法分析
+    double parseSec;   // 语法分析（包括其中的词法分析）
+    double irSec;
+    double asmSec;
+    double totalSec;   // compileSource 端到端
+    long peakRssKB;
+    bool ok;
+};
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static long peakRssKB() {
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // Linux 上单位是 KB
+#else
+    return 0;
+#endif
+}
+
+/**
+ * 运行一个用例；repeat > 1 时每个阶段取最短时间
+ */
+static CaseResult runCase(ProgramShape shape, uint64_t seed, size_t size, int repeat, ThreadPool* pool) {
+    CaseResult r;
+    memset(&r, 0, sizeof(r));
+    r.shape = shape;
+    r.seed = seed;
+
+    string source = generateProgram(shape, seed, size);
+    r.bytes = source.size();
+    r.lexSec = r.parseSec = r.irSec = r.asmSec = r.totalSec = 1e30;
+
+    try {
+        for (int k = 0; k < repeat; ++k) {
+            double t0 = now();
+            Lexer lexer(source);
+            uint64_t tokens = 0;
+            while (lexer.nextToken().type != TOK_EOF) tokens++;
+            r.lexSec = min(r.lexSec, now() - t0);
+            r.tokens = tokens;
+
+            t0 = now();
+            Lexer lexer2(source);
+            Parser parser(lexer2);
+            ASTNode* root = parser.parse();
+            r.parseSec = min(r.parseSec, now() - t0);
+
+            t0 = now();
+            InterCodeGenerator interGen;
+            interGen.generate(root);
+            r.irSec = min(r.irSec, now() - t0);
+            r.quads = interGen.getCodes().size();
+            r.nodes = freeAST(root);
+
+            t0 = now();
+            AsmBuffer out;
+            AsmGenerator asmGen(interGen.getCodes());
+            asmGen.generate(out);
+            r.asmSec = min(r.asmSec, now() - t0);
+            uint64_t lines = 0;
+            for (char c : out.str()) lines += (c == '\n');
+            r.asmLines = lines;
+
+            t0 = now();
+            CompileOutput output = compileSource(source, CompileOptions(), pool);
+            r.totalSec = min(r.totalSec, now() - t0);
+            if (!output.success) return r;
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << shapeName(shape) << " " << size << ": " << e.what() << endl;
+        return r;
+    }
+
+    r.peakRssKB = peakRssKB();
+    r.ok = true;
+    return r;
+}
+
+/**
+ * 在子进程中运行用例，父进程的内存不计入峰值
+ */
+static CaseResult runIsolated(ProgramShape shape, uint64_t seed, size_t size, int repeat, int threads) {
+#ifndef _WIN32
+    int fds[2];
+    if (pipe(fds) == 0) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            unique_ptr<ThreadPool> pool;
+            if (threads > 1) pool = make_unique<ThreadPool>(threads);
+            CaseResult r = runCase(shape, seed, size, repeat, pool.get());
+            ssize_t n = write(fds[1], &r, sizeof(r));
+            _exit(n == (ssize_t)sizeof(r) ? 0 : 1);
+        }
+        close(fds[1]);
+        CaseResult r;
+        memset(&r, 0, sizeof(r));
+        size_t got = 0;
+        while (pid > 0 && got < sizeof(r)) {
+            ssize_t n = read(fds[0], (char*)&r + got, sizeof(r) - got);
+            if (n <= 0) break;
+            got += n;
+        }
+        close(fds[0]);
+        if (pid > 0) waitpid(pid, nullptr, 0);
+        if (got == sizeof(r)) return r;
+        memset(&r, 0, sizeof(r));
+        r.shape = shape;
+        r.seed = seed;
+        return r;
+    }
+#endif
+    unique_ptr<ThreadPool> pool;
+    if (threads > 1) pool = make_unique<ThreadPool>(threads);
+    return runCase(shape, seed, size, repeat, pool.get());
+}
+
+static double rate(uint64_t n, double sec) {
+    return sec > 0 ? n / sec : 0;
+}
+
+static void writeJSON(ostream& out, const string& label, int threads, const vector<CaseResult>& results) {
+    out << "{\n";
+    out << "  \"label\": \"" << label << "\",\n";
+    out << "  \"compiler_version\": \"" << COMPILER_VERSION << "\",\n";
+    out << "  \"threads\": " << threads << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const CaseResult& r = results[i];
+        char buf[1024];
+        snprintf(buf, sizeof(buf),
+                 "    {\"shape\": \"%s\", \"seed\": %llu, \"ok\": %s, \"bytes\": %llu, "
+                 "\"tokens\": %llu, \"nodes\": %llu, \"quads\": %llu, \"asm_lines\": %llu, "
+                 "\"lex_s\": %.6f, \"parse_s\": %.6f, \"ir_s\": %.6f, \"asm_s\": %.6f, \"total_s\": %.6f, "
+                 "\"tokens_per_s\": %.0f, \"nodes_per_s\": %.0f, \"quads_per_s\": %.0f, "
+                 "\"asm_lines_per_s\": %.0f, \"bytes_per_s\": %.0f, \"peak_rss_kb\": %ld}",
+                 shapeName((ProgramShape)r.shape), (unsigned long long)r.seed, r.ok ? "true" : "false",
+                 (unsigned long long)r.bytes, (unsigned long long)r.tokens, (unsigned long long)r.nodes,
+                 (unsigned long long)r.quads, (unsigned long long)r.asmLines,
+                 r.lexSec, r.parseSec, r.irSec, r.asmSec, r.totalSec,
+                 rate(r.tokens, r.lexSec), rate(r.nodes, r.parseSec), rate(r.quads, r.irSec),
+                 rate(r.asmLines, r.asmSec), rate(r.bytes, r.totalSec), r.peakRssKB);
+        out << buf << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+static bool parseSize(const string& s, size_t& bytes) {
+    char* end;
+    unsigned long long v = strtoull(s.c_str(), &end, 10);
+    if (end == s.c_str()) return false;
+    string suffix = end;
+    if (suffix == "K" || suffix == "k") v <<= 10;
+    else if (suffix == "M" || suffix == "m") v <<= 20;
+    else if (suffix == "G" || suffix == "g") v <<= 30;
+    else if (!suffix.empty()) return false;
+    bytes = (size_t)v;
+    return true;
+}
+
+static vector<string> splitList(const string& s) {
+    vector<string> items;
+    stringstream in(s);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options]" << endl;
+    cerr << "  --sizes <list>    Comma separated program sizes, K/M/G suffixes allowed (default: 64K,1M)" << endl;
+    cerr << "  --shapes <list>   mixed,funcs,deep,straight,nested,idents (default: all)" << endl;
+    cerr << "  --seed <n>        Generator seed (default: 1)" << endl;
+    cerr << "  --repeat <n>      Runs per case, the fastest is reported (default: 1)" << endl;
+    cerr << "  -j <n>            Worker threads for the end-to-end compile (default: 1)" << endl;
+    cerr << "  --label <text>    Stored in the JSON output, e.g. the commit id" << endl;
+    cerr << "  -o <file>         JSON output file (default: bench.json)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    vector<size_t> sizes = {64 << 10, 1 << 20};
+    vector<ProgramShape> shapes;
+    for (int i = 0; i < SHAPE_COUNT; ++i) shapes.push_back((ProgramShape)i);
+    uint64_t seed = 1;
+    int repeat = 1;
+    int threads = 1;
+    string label;
+    string output = "bench.json";
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--sizes") {
+            sizes.clear();
+            for (auto& s : splitList(value)) {
+                size_t bytes;
+                if (!parseSize(s, bytes)) {
+                    cerr << "Error: Invalid size '" << s << "'" << endl;
+                    return 1;
+                }
+                sizes.push_back(bytes);
+            }
+        } else if (arg == "--shapes") {
+            shapes.clear();
+            for (auto& s : splitList(value)) {
+                ProgramShape shape;
+                if (!parseShape(s, shape)) {
+                    cerr << "Error: Unknown shape '" << s << "'" << endl;
+                    return 1;
+                }
+                shapes.push_back(shape);
+            }
+        } else if (arg == "--seed") seed = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--repeat") repeat = max(1, atoi(value.c_str()));
+        else if (arg == "-j") threads = max(1, atoi(value.c_str()));
+        else if (arg == "--label") label = value;
+        else if (arg == "-o") output = value;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    vector<CaseResult> results;
+    printf("%-9s %10s %12s %12s %12s %12s %10s %10s\n",
+           "shape", "bytes", "tokens/s", "nodes/s", "quads/s", "lines/s", "MB/s", "peak MB");
+    for (size_t size : sizes) {
+        for (ProgramShape shape : shapes) {
+            CaseResult r = runIsolated(shape, seed, size, repeat, threads);
+            results.push_back(r);
+            if (!r.ok) {
+                printf("%-9s %10zu failed\n", shapeName(shape), size);
+                continue;
+            }
+            printf("%-9s %10llu %12.0f %12.0f %12.0f %12.0f %10.2f %10.1f\n",
+                   shapeName(shape), (unsigned long long)r.bytes,
+                   rate(r.tokens, r.lexSec), rate(r.nodes, r.parseSec), rate(r.quads, r.irSec),
+                   rate(r.asmLines, r.asmSec), rate(r.bytes, r.totalSec) / (1 << 20), r.peakRssKB / 1024.0);
+            fflush(stdout);
+        }
+    }
+
+    ofstream out(output);
+    writeJSON(out, label, threads, results);
+    if (!out) {
+        cerr << "Error: Cannot write file '" << output << "'" << endl;
+        return 1;
+    }
+    printf("Results written to %s\n", output.c_str());
+
+    for (auto& r : results) {
+        if (!r.ok) return 1;
+    }
+    return 0;
+}
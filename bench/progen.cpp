@@ -0,0 +1,214 @@
+#include "progen.h"
+#include <vector>
+
+static const char* SHAPE_NAMES[SHAPE_COUNT] = {
+    "mixed", "funcs", "deep", "straight", "nested", "idents"
+};
+
+const char* shapeName(ProgramShape shape) {
+    return (shape >= 0 && shape < SHAPE_COUNT) ? SHAPE_NAMES[shape] : "?";
+}
+
+bool parseShape(const string& name, ProgramShape& shape) {
+    for (int i = 0; i < SHAPE_COUNT; ++i) {
+        if (name == SHAPE_NAMES[i]) { shape = (ProgramShape)i; return true; }
+    }
+    return false;
+}
+
+namespace {
+
+// splitmix64：结果不依赖标准库实现，不同平台上生成的程序相同
+class Random {
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    int below(int n) { return (int)(next() % (uint64_t)n); }
+    bool chance(int percent) { return below(100) < percent; }
+};
+
+class Generator {
+private:
+    Random rng;
+    ProgramShape shape;
+    string out;
+    vector<string> vars;     // 当前函数中可以读写的变量
+    int funcCount = 0;
+    int loopCount = 0;       // 循环计数器编号，函数内唯一
+    int loopDepth = 0;
+
+    void indent(int level) { out.append(level * 4, ' '); }
+
+    string constant() {
+        // 偶尔使用超过 16 位的常量，覆盖 lui / ori
+        if (rng.chance(5)) return to_string(40000 + rng.below(1000000));
+        return to_string(rng.below(100));
+    }
+
+    string operand() {
+        if (!vars.empty() && rng.chance(70)) return vars[rng.below((int)vars.size())];
+        return constant();
+    }
+
+    char binop() {
+        static const char ops[] = {'+', '-', '*', '/'};
+        return ops[rng.below(4)];
+    }
+
+    // 随机表达式，depth 限制递归深度
+    void expr(int depth) {
+        if (depth <= 0 || rng.chance(35)) {
+            out += operand();
+            return;
+        }
+        bool paren = rng.chance(40);
+        if (paren) out += '(';
+        expr(depth - 1);
+        out += ' ';
+        out += binop();
+        out += ' ';
+        expr(depth - 1);
+        if (paren) out += ')';
+    }
+
+    // 深度为 depth 的括号链：((((a + 1) * b) - 2) ...)，不使用递归
+    void deepExpr(int depth) {
+        out.append(depth, '(');
+        out += operand();
+        for (int i = 0; i < depth; ++i) {
+            out += ' ';
+            out += binop();
+            out += ' ';
+            out += operand();
+            out += ')';
+        }
+    }
+
+    void assign(int level) {
+        indent(level);
+        out += vars[rng.below((int)vars.size())];
+        out += " = ";
+        if (shape == SHAPE_DEEP) deepExpr(100 + rng.below(400));
+        else expr(shape == SHAPE_STRAIGHT ? 3 : 4);
+        out += ";\n";
+    }
+
+    void statement(int level, int nestBudget) {
+        int kind = rng.below(10);
+        if (shape == SHAPE_NESTED && nestBudget > 0) kind = 6 + rng.below(4);
+        if (nestBudget <= 0 || kind < 6) {
+            assign(level);
+        } else if (kind < 8 || loopDepth >= 3) {
+            indent(level);
+            out += "if (";
+            expr(2);
+            out += ")\n";
+            block(level, nestBudget - 1);
+            if (rng.chance(50)) {
+                // else 分支不再继续嵌套，函数大小随嵌套深度线性增长
+                indent(level);
+                out += "else\n";
+                block(level, 0);
+            }
+        } else {
+            // 计数器只在循环体末尾递减，循环体内的其他语句不会写它
+            string counter = "loop" + to_string(loopCount++);
+            indent(level);
+            out += "int " + counter + " = " + to_string(1 + rng.below(3)) + ";\n";
+            indent(level);
+            out += "while (" + counter + ")\n";
+            loopDepth++;
+            block(level, nestBudget - 1, counter);
+            loopDepth--;
+        }
+    }
+
+    void block(int level, int nestBudget, const string& counter = "") {
+        indent(level);
+        out += "{\n";
+        // 只有一条语句可以继续嵌套，避免语句数随深度指数增长
+        int n = 1 + rng.below(shape == SHAPE_NESTED ? 3 : 4);
+        int nestAt = rng.below(n);
+        for (int i = 0; i < n; ++i) statement(level + 1, i == nestAt ? nestBudget : 0);
+        if (!counter.empty()) {
+            indent(level + 1);
+            out += counter + " = " + counter + " - 1;\n";
+        }
+        indent(level);
+        out += "}\n";
+    }
+
+    void function() {
+        vars.clear();
+        loopCount = 0;
+        out += "int f" + to_string(funcCount++) + "()\n{\n";
+
+        int varCount = (shape == SHAPE_IDENTS) ? 200 + rng.below(300) : 3 + rng.below(6);
+        for (int i = 0; i < varCount; ++i) {
+            string name;
+            if (shape == SHAPE_IDENTS) {
+                name = "identifier_" + to_string(rng.next() % 1000000000ULL) + "_value_" + to_string(i);
+            } else {
+                name = string(1, (char)('a' + i % 26)) + to_string(i);
+            }
+            out += "    int " + name + " = " + constant() + ";\n";
+            vars.push_back(name);
+        }
+
+        int stmts = 0;
+        int nest = 2;
+        switch (shape) {
+            case SHAPE_FUNCS: stmts = 1 + rng.below(4); nest = 1; break;
+            case SHAPE_DEEP: stmts = 2 + rng.below(3); nest = 0; break;
+            case SHAPE_STRAIGHT: stmts = 2000 + rng.below(2000); nest = 0; break;
+            case SHAPE_NESTED: stmts = 2 + rng.below(3); nest = 30; break;
+            case SHAPE_IDENTS: stmts = 100 + rng.below(200); nest = 1; break;
+            default: stmts = 5 + rng.below(30); nest = 1 + rng.below(4); break;
+        }
+        for (int i = 0; i < stmts; ++i) statement(1, nest);
+
+        out += "    return ";
+        expr(3);
+        out += ";\n}\n";
+    }
+
+    // 每个函数都恰好被调用一次，调用图优化不会把它们当作不可达删除
+    void mainFunction() {
+        out += "int main()\n{\n    int sum = 0;\n";
+        for (int i = 0; i < funcCount; ++i) out += "    sum = sum + f" + to_string(i) + "();\n";
+        out += "    return sum;\n}\n";
+    }
+
+public:
+    Generator(ProgramShape s, uint64_t seed) : rng(seed), shape(s) {}
+
+    string run(size_t targetBytes) {
+        out.reserve(targetBytes + 4096);
+        while (out.size() < targetBytes) {
+            // 混合形状：每个函数随机选择一种结构
+            ProgramShape base = shape;
+            if (base == SHAPE_MIXED) shape = (ProgramShape)(1 + rng.below(SHAPE_COUNT - 1));
+            function();
+            shape = base;
+        }
+        mainFunction();
+        return move(out);
+    }
+};
+
+}
+
+string generateProgram(ProgramShape shape, uint64_t seed, size_t targetBytes) {
+    Generator gen(shape, seed);
+    return gen.run(targetBytes);
+}
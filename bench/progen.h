@@ -0,0 +1,30 @@
+#ifndef PROGEN_H
+#define PROGEN_H
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// 基准测试用的合成程序生成器
+// 同一个种子和大小总是生成完全相同的程序；生成的程序一定会终止（循环计数器只在循环末尾递减），
+// 因此也可以交给解释器 / 模拟器执行做差分测试
+// 最后生成的 main 依次调用其余每个函数并累加结果，执行 main 即覆盖全部函数
+
+enum ProgramShape {
+    SHAPE_MIXED,     // 各种结构的随机组合
+    SHAPE_FUNCS,     // 大量很小的函数
+    SHAPE_DEEP,      // 深度嵌套的括号表达式
+    SHAPE_STRAIGHT,  // 很长的无分支赋值序列
+    SHAPE_NESTED,    // 深度嵌套的 if / while
+    SHAPE_IDENTS,    // 大量不同的长标识符
+    SHAPE_COUNT
+};
+
+const char* shapeName(ProgramShape shape);
+bool parseShape(const string& name, ProgramShape& shape);
+
+// 生成约 targetBytes 字节的源程序（以完整的函数为单位，最后一个函数和 main 可能略微超出）
+string generateProgram(ProgramShape shape, uint64_t seed, size_t targetBytes);
+
+#endif
@@ -0,0 +1,72 @@
+#include "progen.h"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+using namespace std;
+
+// 大小可以带 K / M / G 后缀
+static bool parseSize(const string& s, size_t& bytes) {
+    char* end;
+    unsigned long long v = strtoull(s.c_str(), &end, 10);
+    if (end == s.c_str()) return false;
+    string suffix = end;
+    if (suffix == "K" || suffix == "k") v <<= 10;
+    else if (suffix == "M" || suffix == "m") v <<= 20;
+    else if (suffix == "G" || suffix == "g") v <<= 30;
+    else if (!suffix.empty()) return false;
+    bytes = (size_t)v;
+    return true;
+}
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [--shape <shape>] [--seed <n>] [--size <bytes>[K|M|G]] [-o <file>]" << endl;
+    cerr << "Shapes: mixed (default), funcs, deep, straight, nested, idents" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    ProgramShape shape = SHAPE_MIXED;
+    uint64_t seed = 1;
+    size_t size = 64 << 10;
+    string output;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--shape") {
+            if (!parseShape(value, shape)) {
+                cerr << "Error: Unknown shape '" << value << "'" << endl;
+                return 1;
+            }
+        } else if (arg == "--seed") {
+            seed = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--size") {
+            if (!parseSize(value, size)) {
+                cerr << "Error: Invalid size '" << value << "'" << endl;
+                return 1;
+            }
+        } else if (arg == "-o") {
+            output = value;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    string program = generateProgram(shape, seed, size);
+    if (output.empty()) {
+        cout.write(program.data(), program.size());
+        return 0;
+    }
+    ofstream out(output, ios::binary);
+    out.write(program.data(), program.size());
+    if (!out) {
+        cerr << "Error: Cannot write file '" << output << "'" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef ASMBUFFER_H
+#define ASMBUFFER_H
+
+#include <string>
+
+using namespace std;
+
+// 汇编输出缓冲区：所有指令先格式化到一块可增长的内存中，最后一次性写出
+// 提供与 ostream 相同的 << 写法，但不做本地化、格式状态和逐行刷新
+class AsmBuffer {
+private:
+    string data;
+
+public:
+    AsmBuffer& operator<<(const char* s);
+    AsmBuffer& operator<<(const string& s);
+    AsmBuffer& operator<<(char c);
+    AsmBuffer& operator<<(int v);
+
+    void append(const AsmBuffer& other);
+    void reserve(size_t n);
+    void clear();
+    size_t size() const;
+    const string& str() const;
+    string take();  // 取走内容并清空缓冲区
+
+    bool writeFile(const string& path) const; // 一次写入整个文件
+};
+
+#endif
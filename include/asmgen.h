@@ -2,46 +2,61 @@
 #define ASMGEN_H
 
 #include "intercode.h"
+#include "asmbuffer.h"
+#include "backend.h"
 #include <vector>
 #include <string>
 #include <map>
 #include <set>
-#include <fstream>
 
 using namespace std;
 
+// MIPS 32个寄存器的标准名称，下标为寄存器编号
+extern const string REG_NAMES[32];
+
+// MIPS 后端（汇编文本和机器码）的可分配寄存器，按分配的优先顺序
+vector<int> mipsAllocatableRegs();
+
+// MIPS 汇编文本：栈帧以 $sp 为基址，乘除法结果从 LO 取出
+// 调用为 jal，返回地址保存在调用者的栈帧中；return 把结果放入 $v0 后 jr $ra
+class MipsAsmEmitter : public TargetEmitter {
+private:
+    AsmBuffer& out;
+
+public:
+    explicit MipsAsmEmitter(AsmBuffer& buffer);
+
+    vector<int> allocatableRegs() const override;
+    void funcBegin(const string& name) override;
+    void label(const string& name) override;
+    void loadImm(int reg, int32_t val) override;
+    void load(int reg, int offset) override;
+    void store(int reg, int offset) override;
+    void arith(QuadOp op, int rd, int rs, int rt) override;
+    void jump(const string& target) override;
+    void branch(QuadOp op, int rs, int rt, const string& target) override;
+    void ret(int reg) override;
+    void call(const string& name, int frameBytes, int raOffset) override;
+    void result(int reg) override;
+};
+
 class AsmGenerator {
 private:
     const vector<Quad>& quads;
-    
-    // 变量到栈偏移的映射
-    map<string, int> stackOffset;
-    int currentStackSize;
-
-    // 寄存器描述符: 记录哪个变量在哪个寄存器
-    string regContent[32];
-    map<string, int> varInReg;
-
-    // 寄存器池
-    vector<int> availRegs;
-
-    // 替换策略索引
-    int nextVictimIndex; 
-
-    // 辅助函数
-    bool isNumber(string s);
-    int getOffset(string var); // 获取相对于 SP 的偏移
-    
-    // 寄存器分配
-    int getReg(string var);
-    void spillAll();
-    
-    // 输出指令辅助
-    void emitImm(int reg, int val, ofstream& out);
+
+    // 变量的热度（profile 中的执行次数），为空时按轮询法置换
+    const map<string, long long>* varWeights = nullptr;
 
 public:
     AsmGenerator(const vector<Quad>& codes);
+    void setVarWeights(const map<string, long long>* weights); // 置换时优先保留热的变量
     void generate(string filename);
+    void generate(AsmBuffer& out);      // 头部 + 所有函数 + 尾部
+    void generateBody(AsmBuffer& out);  // 只输出函数代码，用于按函数独立生成后拼接
+
+    static void emitHeader(AsmBuffer& out); // 数据段 / 代码段声明、运行时初始化及入口调用
+    // 入口跳板 Program_Entry（跳到 entry）以及程序终止用的 Program_End 死循环
+    static void emitFooter(AsmBuffer& out, const string& entry);
 };
 
 #endif
\ No newline at end of file
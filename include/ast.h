@@ -4,22 +4,27 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include "instrument.h"
 
 using namespace std;
 
 enum NodeType {
     NODE_PROGRAM, NODE_VAR_DECL, NODE_FUNC_DEF, NODE_BLOCK,
     NODE_IF_STMT, NODE_WHILE_STMT, NODE_RETURN_STMT, NODE_ASSIGN_STMT,
-    NODE_BINARY_EXPR, NODE_NUMBER, NODE_IDENTIFIER
+    NODE_BINARY_EXPR, NODE_NUMBER, NODE_IDENTIFIER, NODE_CALL_EXPR, NODE_EXPR_STMT
 };
 
 class ASTNode {
 public:
     NodeType nodeType;
+    ASTNode() { INSTR_COUNT(CNT_AST_NODES, 1); }
     virtual ~ASTNode() {}
 };
 
-class ExprNode : public ASTNode {};
+class ExprNode : public ASTNode {
+public:
+    int need = 0; // Sethi-Ullman 标号：求值该子树所需的寄存器数，0 表示尚未计算
+};
 class StmtNode : public ASTNode {};
 
 // --- 表达式 ---
@@ -44,6 +49,15 @@ public:
         : op(o), left(l), right(r) { nodeType = NODE_BINARY_EXPR; }
 };
 
+// 函数调用 f(a, b)，实参从左到右求值
+class CallExpr : public ExprNode {
+public:
+    string funcName;
+    vector<ExprNode*> args;
+    CallExpr(string fn, vector<ExprNode*> a) 
+        : funcName(fn), args(a) { nodeType = NODE_CALL_EXPR; }
+};
+
 // --- 语句 ---
 class VarDeclStmt : public StmtNode {
 public:
@@ -68,6 +82,13 @@ public:
     ReturnStmt(ExprNode* val) : retVal(val) { nodeType = NODE_RETURN_STMT; }
 };
 
+// 表达式语句：以函数调用开头，如 f(x);，结果被丢弃
+class ExprStmt : public StmtNode {
+public:
+    ExprNode* expr;
+    ExprStmt(ExprNode* e) : expr(e) { nodeType = NODE_EXPR_STMT; }
+};
+
 class BlockStmt : public StmtNode {
 public:
     vector<StmtNode*> stmts;
@@ -96,8 +117,9 @@ class FuncDef : public ASTNode {
 public:
     string returnType;
     string funcName;
-    vector<string> args; 
+    vector<string> args; // 形参名
     BlockStmt* body;
+    unsigned long long tokenHash = 0; // 函数全部记号的哈希，用于增量编译缓存
     FuncDef(string rt, string fn, BlockStmt* b) 
         : returnType(rt), funcName(fn), body(b) { nodeType = NODE_FUNC_DEF; }
 };
@@ -108,4 +130,7 @@ public:
     ProgramNode() { nodeType = NODE_PROGRAM; }
 };
 
+// 释放整棵语法树（使用显式栈，任意嵌套深度都不会耗尽调用栈），返回释放的结点数
+size_t freeAST(ASTNode* root);
+
 #endif
\ No newline at end of file
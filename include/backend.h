@@ -0,0 +1,96 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include "intercode.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdint>
+
+using namespace std;
+
+// 后端分为两层：
+//   Lowering      与目标无关的降级决策：栈帧布局（每个变量一个相对栈顶的负偏移）、寄存器描述符、
+//                 每条四元式读哪些操作数、何时写回、在基本块边界清空寄存器
+//   TargetEmitter 与目标相关的指令输出，只接收已经分配好的寄存器编号和栈偏移
+// MIPS 汇编（AsmGenerator）和 x86-64 JIT 共用同一个 Lowering，因此两者执行的是同一份分配结果
+//
+// 调用约定：每个函数的栈帧大小 F 在函数开头由整个函数体确定
+//   [栈顶 - 4(k+1)]    第 k 个形参（形参排在栈帧最前面）
+//   [栈顶 - F ...]     其余变量、临时变量以及调用时保存返回地址的槽位
+//   [栈顶 - F - 4(d+1)] 第 d 个尚未被 CALL 取走的实参，即被调函数的第 k 个形参
+// 调用时栈顶下移 F + 4s（s 为更早压入、不属于本次调用的实参个数），返回后恢复
+// 返回值在目标的返回值寄存器中；执行到函数尾返回 0
+
+class TargetEmitter {
+public:
+    virtual ~TargetEmitter() = default;
+
+    // 可分配的寄存器编号，按分配的优先顺序；编号小于 32
+    virtual vector<int> allocatableRegs() const = 0;
+
+    virtual void funcBegin(const string& name) = 0;
+    virtual void label(const string& name) = 0;
+    virtual void loadImm(int reg, int32_t val) = 0;
+    virtual void load(int reg, int offset) = 0;   // reg = 栈顶 + offset 处的字
+    virtual void store(int reg, int offset) = 0;
+    virtual void arith(QuadOp op, int rd, int rs, int rt) = 0; // ADD / SUB / MUL / DIV
+    virtual void jump(const string& target) = 0;
+    virtual void branch(QuadOp op, int rs, int rt, const string& target) = 0; // JEQ / JNE
+    virtual void ret(int reg) = 0;                // 返回调用者，reg < 0 表示没有返回值（返回 0）
+    // 栈顶下移 frameBytes 后调用 name，返回后恢复栈顶；raOffset 为调用者栈帧中保存返回地址的槽位
+    virtual void call(const string& name, int frameBytes, int raOffset) = 0;
+    virtual void result(int reg) = 0;             // reg = 刚返回的调用的返回值
+};
+
+class Lowering {
+private:
+    TargetEmitter& target;
+
+    // 变量到栈偏移的映射
+    map<string, int> stackOffset;
+    int currentStackSize;
+    int maxStackSize;
+
+    // 当前函数的调用信息：栈帧大小（不含实参区）、返回地址槽位、已压入尚未被取走的实参个数
+    int frameBytes;
+    int raOffset;
+    int pendingArgs;
+
+    // 寄存器描述符: 记录哪个变量在哪个寄存器
+    string regContent[32];
+    map<string, int> varInReg;
+
+    // 寄存器池
+    vector<int> availRegs;
+
+    // 替换策略索引
+    int nextVictimIndex;
+
+    // 当前四元式已经使用的寄存器，置换时不能选中
+    bool pinned[32];
+
+    // 变量的热度（profile 中的执行次数），为空时按轮询法置换
+    const map<string, long long>* varWeights = nullptr;
+
+    bool isNumber(const string& s);
+    int getOffset(const string& var); // 获取相对于栈顶的偏移
+    // 函数开头：确定整个栈帧的布局，返回可能未赋值就被读取的变量（需要清零）
+    vector<string> layoutFrame(const vector<Quad>& quads, size_t begin);
+
+    // 寄存器分配
+    int getReg(const string& var);
+    void spillAll();
+    int useOperand(const string& s);  // 分配寄存器并装入立即数或变量的值
+
+    void emitStore(int reg, const string& var);
+
+public:
+    explicit Lowering(TargetEmitter& target);
+    void setVarWeights(const map<string, long long>* weights); // 置换时优先保留热的变量
+
+    void lower(const vector<Quad>& quads);
+    int frameSize() const;            // 所有函数中最大的栈帧（字节，含实参区）
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <iostream>
+
+using namespace std;
+
+// 缓存键：函数记号哈希和配置字符串（版本 + 选项）
+// 文件名取二者的 64 位哈希，条目中保存原文，读取时比对，哈希碰撞按未命中处理
+struct CacheKey {
+    unsigned long long tokenHash = 0;
+    string config;
+    unsigned long long hash = 0;
+};
+
+// 增量编译缓存（函数粒度、按内容寻址）
+// 每个函数的汇编以 <hash>.fc 文件保存在缓存目录中，key 由记号序列、编译器版本和选项共同决定
+// 文件修改时间作为最近使用时间，超过容量上限时按 LRU 删除
+class CompileCache {
+private:
+    string dir;
+    unsigned long long maxBytes;
+
+    atomic<long> hits;
+    atomic<long> misses;
+    atomic<long> stores;
+    atomic<long> evictions;
+    mutex evictLock;
+
+    string pathFor(unsigned long long key) const;
+
+public:
+    CompileCache(string directory, unsigned long long maxSizeBytes);
+
+    // 由函数记号哈希和配置字符串（版本 + 选项）构造缓存键
+    static CacheKey makeKey(unsigned long long tokenHash, const string& config);
+
+    // 命中时返回该函数的汇编和它调用的函数列表（用于删除不可达函数）
+    bool lookup(const CacheKey& key, string& asmText, vector<string>& callees);
+    void store(const CacheKey& key, const string& asmText, const vector<string>& callees);
+
+    void evict(); // 总大小超过上限时删除最久未使用的条目
+    void printStats(ostream& out);
+};
+
+#endif
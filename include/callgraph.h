@@ -0,0 +1,68 @@
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include "intercode.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <iostream>
+
+using namespace std;
+
+// 调用约定（四元式层面）:
+//   FUNC_BEGIN arg1, result  arg1 = 以逗号分隔的形参名, result = 函数名
+//   PARAM  arg1          压入一个实参，按出现顺序对应第 0,1,2... 个参数
+//   CALL   arg1, arg2, result
+//          arg1 = 被调函数名, arg2 = 实参个数, result = 接收返回值的变量（可为空）
+
+// 单个函数的分析结果
+struct FuncInfo {
+    string name;
+    int begin = -1;              // FUNC_BEGIN 在四元式列表中的下标
+    int end = -1;                // FUNC_END 在四元式列表中的下标
+    set<string> callees;         // 直接调用的函数
+    set<string> callers;         // 直接调用本函数的函数
+    bool reachable = false;      // 是否可从入口函数到达
+    bool isLeaf = true;          // 不调用任何函数
+    bool isPure = true;          // 无副作用（仅依赖参数，且只调用纯函数）
+    bool hasConstReturn = false; // 所有 return 都返回同一个常量
+    int constReturn = 0;
+    int callSites = 0;           // 被调用的次数（静态）
+    // 每个参数位置在所有调用点上是否都是同一个常量
+    vector<bool> argIsConst;
+    vector<int> argConst;
+};
+
+class CallGraph {
+private:
+    map<string, FuncInfo> funcs;
+    vector<string> order;        // 函数在源码中的顺序
+    string entry;                // 入口函数名（main）
+
+    bool isNumber(const string& s);
+    void scanFunctions(const vector<Quad>& codes);
+    void computeReachable();
+    void computePurity();
+    bool computeConstReturns(const vector<Quad>& codes);
+    void computeConstArgs(const vector<Quad>& codes);
+
+public:
+    CallGraph(string entryName = "main");
+
+    void build(const vector<Quad>& codes);        // 构建调用图并完成所有分析
+    int propagateConstants(vector<Quad>& codes);  // 常量返回值替换调用点，返回替换数量
+    int propagateConstArgs(vector<Quad>& codes);  // 常量实参赋给形参，返回赋值数量
+    int eliminateDeadFunctions(vector<Quad>& codes); // 删除不可达函数，返回删除数量
+    int run(vector<Quad>& codes);                 // 完整流程：分析 -> 传播 -> 重建 -> 实参传播 -> 删除
+
+    bool hasFunction(const string& name) const;
+    const FuncInfo& getInfo(const string& name) const;
+    bool isPure(const string& name) const;
+    bool isLeaf(const string& name) const;
+    const vector<string>& getOrder() const;
+
+    void print(ostream& out) const; // 调试用
+};
+
+#endif
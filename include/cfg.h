@@ -0,0 +1,148 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include "intercode.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+
+using namespace std;
+
+// 单个函数（FUNC_BEGIN ... FUNC_END）上的分析：控制流图、活跃变量、支配树
+// 分析结果缓存在 FunctionIR 中，遍修改了中间代码后按声明保留的分析使其余失效
+
+// 四元式操作数的分类与读写关系
+bool isConstOperand(const string& s);           // 立即数（如 "12"、"-3"）
+bool isVarOperand(const string& s);             // 非空且不是立即数
+bool isBranch(QuadOp op);                       // JMP / JEQ / JNE / JGT / JLT
+bool isArith(QuadOp op);                        // ADD / SUB / MUL / DIV
+void quadUses(const Quad& q, vector<const string*>& uses); // 读取的变量（不含 PHI 的操作数）
+const string* quadDef(const Quad& q);           // 写入的变量，没有时为空
+
+// 基本块：四元式下标区间 [first, last]
+struct BasicBlock {
+    int first;
+    int last;
+    vector<int> succs;
+    vector<int> preds;
+};
+
+class CFG {
+private:
+    vector<BasicBlock> blocks;
+    vector<int> blockOf;       // 每条四元式所在的块
+    map<string, int> labelBlock;
+    vector<int> rpo;           // 从入口可达的块的逆后序
+    vector<bool> isReachable;
+
+public:
+    explicit CFG(const vector<Quad>& codes);
+
+    int size() const;
+    const BasicBlock& block(int b) const;
+    int blockOfQuad(int i) const;
+    int blockOfLabel(const string& label) const; // 不存在时为 -1
+    const vector<int>& reversePostOrder() const;
+    bool reachable(int b) const;
+};
+
+// 变量编号：函数内出现的所有变量编为 0..n-1
+class VarIndex {
+private:
+    map<string, int> ids;
+    vector<string> names;
+
+public:
+    explicit VarIndex(const vector<Quad>& codes);
+    int size() const;
+    int id(const string& name) const;            // 不是变量时为 -1
+    const string& name(int id) const;
+};
+
+// 位集合，用于数据流分析
+class BitSet {
+private:
+    vector<uint64_t> words;
+
+public:
+    explicit BitSet(int n = 0) : words((n + 63) / 64, 0) {}
+    bool test(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    void set(int i) { words[i >> 6] |= 1ULL << (i & 63); }
+    void reset(int i) { words[i >> 6] &= ~(1ULL << (i & 63)); }
+    bool unite(const BitSet& o);                 // 并入 o，有变化时返回 true
+    // 置为 use ∪ (out - def)，有变化时返回 true
+    bool assignTransfer(const BitSet& use, const BitSet& out, const BitSet& def);
+    bool operator==(const BitSet& o) const { return words == o.words; }
+    // 按从小到大的顺序访问所有置位的下标
+    template <class F>
+    void forEach(F f) const {
+        for (size_t w = 0; w < words.size(); ++w) {
+            for (uint64_t bits = words[w]; bits; bits &= bits - 1) f((int)(w * 64 + __builtin_ctzll(bits)));
+        }
+    }
+};
+
+// 活跃变量分析（后向数据流，按逆后序的反向迭代到不动点）
+class Liveness {
+private:
+    VarIndex vars;
+    vector<BitSet> liveIn;
+    vector<BitSet> liveOut;
+
+public:
+    Liveness(const vector<Quad>& codes, const CFG& cfg);
+
+    const VarIndex& getVars() const;
+    const BitSet& in(int b) const;
+    const BitSet& out(int b) const;
+};
+
+// 支配树与支配边界（Cooper-Harvey-Kennedy 迭代算法）
+class Dominators {
+private:
+    vector<int> idom;                 // 直接支配者，入口为自身，不可达块为 -1
+    vector<int> order;                // 块在逆后序中的位置
+    vector<vector<int>> children;
+    vector<vector<int>> frontier;
+
+public:
+    explicit Dominators(const CFG& cfg);
+
+    int getIdom(int b) const;
+    bool dominates(int a, int b) const;
+    const vector<int>& getChildren(int b) const;
+    const vector<int>& getFrontier(int b) const;
+};
+
+// 分析种类，遍用位掩码声明自己保留了哪些分析
+enum AnalysisKind {
+    ANALYSIS_CFG = 1,
+    ANALYSIS_LIVENESS = 2,
+    ANALYSIS_DOMINATORS = 4,
+    ANALYSIS_ALL = 7
+};
+
+// 一个函数的中间代码及其分析缓存
+class FunctionIR {
+private:
+    unique_ptr<CFG> cfg;
+    unique_ptr<Liveness> liveness;
+    unique_ptr<Dominators> dominators;
+
+public:
+    vector<Quad> codes;
+    bool inSSA = false;          // codes 是否为 SSA 形式（见 ssa.h）
+
+    explicit FunctionIR(vector<Quad> codes);
+
+    const CFG& getCFG();
+    const Liveness& getLiveness();
+    const Dominators& getDominators();
+
+    // 中间代码被修改后调用，preserved 中列出的分析保留
+    void invalidate(int preserved = 0);
+};
+
+#endif
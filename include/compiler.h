@@ -0,0 +1,116 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "ast.h"
+#include "intercode.h"
+#include "threadpool.h"
+#include "cache.h"
+#include "passes.h"
+#include "profile.h"
+#include "mipsenc.h"
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+// 可嵌入的编译器接口：从内存中的源代码编译，返回汇编和结构化诊断信息
+// 不会结束进程，不写文件，也不向 cout / cerr 输出任何内容
+
+// 编译器版本：生成代码的方式发生变化时必须修改，旧的缓存条目随之失效
+#define COMPILER_VERSION "0.7.0"
+
+// 输出文件的格式
+enum OutputFormat {
+    FORMAT_ASM,  // MIPS 汇编文本
+    FORMAT_ELF,  // 可重定位的 ELF32 目标文件
+    FORMAT_BIN,  // 从地址 0 开始的裸二进制映像
+};
+
+// 编译选项
+struct CompileOptions {
+    // 流式编译：每解析完一个函数就立即生成并写出它的汇编，随后释放其语法树和中间代码
+    // 峰值内存只与最大的函数有关；需要整个程序的调用图优化在此模式下不执行
+    bool stream = false;
+
+    // --emit-ir: 只运行前端，输出二进制中间代码文件（.qir）而不是汇编
+    bool emitIR = false;
+    // --from-ir: 输入是 .qir 文件，跳过前端直接生成汇编
+    bool fromIR = false;
+
+    // 调试输出：把语法树 / 中间代码和调用图写入 CompileOutput::log
+    // 未开启时不做任何格式化
+    bool dumpAST = false;
+    bool dumpIR = false;
+    // --format=asm|elf|bin: elf / bin 不经过汇编文本，直接编码 MIPS 机器码（见 mipsenc.h）
+    OutputFormat format = FORMAT_ASM;
+    // 是否生成汇编；只需要调试输出时关闭，编译在最后一个被要求的阶段之后结束
+    bool emitAsm = true;
+    // -q: 驱动程序不输出进度信息，只输出诊断
+    bool quiet = false;
+    // --simulate: 生成汇编后在内置的 MIPS 模拟器上运行，报告结果和性能计数
+    bool simulate = false;
+    // --interp: 在调用图优化之后用四元式解释器执行中间代码，报告结果和最热的基本块
+    bool interpret = false;
+    // --run: 用 x86-64 JIT 把中间代码编译为机器码并直接执行，不生成汇编
+    bool run = false;
+
+    // 优化流水线（-O0/-O1/-O2/-Os、-fpass=、-fno-pass=、-fverify-ir）
+    PassOptions passes;
+    // -fpass-stats: 各个遍的执行次数、修改数量和耗时，为空表示不统计；多个任务共享
+    PassStatistics* passStats = nullptr;
+
+    // --profile-generate=<file>: 用解释器执行优化后的中间代码，计数放入 CompileOutput::profile，
+    // 由驱动程序写到该文件；为空表示不生成
+    string profileGenerate;
+    // --profile-use=<file>: 按已有的计数排列基本块并选择寄存器的换出对象，为空表示不使用；多个任务共享
+    const Profile* profileUse = nullptr;
+
+    // 增量编译缓存，为空表示不使用；多个任务共享同一个缓存对象
+    CompileCache* cache = nullptr;
+};
+
+// 诊断信息，行列号从 1 开始，0 表示没有位置
+struct Diagnostic {
+    enum Severity { ERROR, WARNING };
+    Severity severity;
+    int line;
+    int column;
+    string message;
+};
+
+struct CompileOutput {
+    bool success = false;
+    string assembly;                // 生成的汇编（emitIR 时为空）
+    MipsObject object;              // format 为 elf / bin 时链接好的机器码
+    vector<Quad> ir;                // emitIR 时为优化后的中间代码
+    vector<Diagnostic> diagnostics;
+    string log;                     // 调试输出
+
+    // interpret 时解释器的执行结果，供与模拟器的结果对比
+    bool interpreted = false;
+    bool interpReturned = false;    // 入口函数是否返回了值
+    int interpResult = 0;
+
+    // run 时 JIT 的执行结果
+    bool ran = false;
+    bool runReturned = false;
+    int runResult = 0;
+
+    // profileGenerate 时收集到的执行计数
+    Profile profile;
+};
+
+// 编译一段源代码；给定线程池时各个函数并行生成中间代码和汇编
+CompileOutput compileSource(const string& source, const CompileOptions& options = CompileOptions(),
+                            ThreadPool* pool = nullptr);
+
+// 格式化为 "file:line:col: error: message"
+string formatDiagnostic(const Diagnostic& d, const string& file = "");
+
+// 缓存配置字符串：编译器版本以及所有影响生成代码的选项
+string cacheConfig(const CompileOptions& options);
+
+void printAST(ASTNode* root, ostream& out, int level = 0);
+
+#endif
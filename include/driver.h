@@ -0,0 +1,29 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "compiler.h"
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+// 一个编译任务：一个源文件对应一个输出文件
+struct CompileJob {
+    string input;
+    string output;
+};
+
+// 编译结果：输出与诊断信息先缓存在内存中，由调用者按输入顺序统一打印
+struct CompileResult {
+    bool success = false;
+    string log;         // 原本输出到 stdout 的内容（AST、中间代码等）
+    string diagnostics; // 原本输出到 stderr 的内容
+};
+
+// 编译单个文件；所有状态（词法、语法、中间代码、汇编生成器）都属于本次调用
+// 给定线程池时，文件内的各个函数会作为独立任务并行生成中间代码和汇编
+CompileResult compileFile(const CompileJob& job, const CompileOptions& options = CompileOptions(),
+                          ThreadPool* pool = nullptr);
+
+#endif
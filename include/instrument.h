@@ -0,0 +1,72 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <string>
+#include <ostream>
+
+using namespace std;
+
+// 性能插桩：按阶段 / 函数记录墙钟时间、CPU 时间、内存分配次数与字节数、峰值内存，以及各种计数器
+// 只有定义了 COMPILER_INSTRUMENT（make INSTRUMENT=1）时才编译进来，否则所有宏展开为空，没有任何开销
+//
+//   INSTR_SCOPE("parse");                    从此处到作用域结束计为一次 parse 阶段
+//   INSTR_SCOPE_DETAIL("codegen", funcName); 同上，并记录函数名（Chrome trace 中可见，报告中列出最慢的函数）
+//   INSTR_COUNT(CNT_TOKENS, 1);              计数器加 n
+
+enum InstrCounter {
+    CNT_TOKENS,       // 词法分析产生的记号
+    CNT_AST_NODES,    // 创建的语法树结点
+    CNT_QUADS,        // 生成的四元式
+    CNT_SPILLS,       // 寄存器置换时被挤出的变量
+    CNT_SPILL_ALL,    // spillAll() 清空寄存器的次数
+    CNT_LOADS,        // 生成的 lw 指令
+    CNT_STORES,       // 生成的 sw 指令
+    CNT_ALLOCS,       // operator new 调用次数
+    CNT_ALLOC_BYTES,  // operator new 分配的字节数
+    CNT_COUNT
+};
+
+// 是否编译了插桩代码
+bool instrumentEnabled();
+
+// 人类可读的报告（-ftime-report）：各阶段的次数、时间、分配和峰值内存，计数器，最慢的函数
+void instrPrintReport(ostream& out);
+
+// Chrome trace 格式（chrome://tracing 或 Perfetto 打开），失败时返回 false
+bool instrWriteTrace(const string& path);
+
+#ifdef COMPILER_INSTRUMENT
+
+class InstrScope {
+private:
+    const char* phase;
+    string detail;
+    double startWall;
+    double startCpu;
+    long long startAllocs;
+    long long startBytes;
+
+public:
+    explicit InstrScope(const char* phase, const string& detail = "");
+    ~InstrScope();
+    InstrScope(const InstrScope&) = delete;
+    InstrScope& operator=(const InstrScope&) = delete;
+};
+
+void instrCount(InstrCounter counter, long long n);
+
+#define INSTR_CONCAT2(a, b) a##b
+#define INSTR_CONCAT(a, b) INSTR_CONCAT2(a, b)
+#define INSTR_SCOPE(phase) InstrScope INSTR_CONCAT(instrScope, __LINE__)(phase)
+#define INSTR_SCOPE_DETAIL(phase, detail) InstrScope INSTR_CONCAT(instrScope, __LINE__)(phase, detail)
+#define INSTR_COUNT(counter, n) instrCount(counter, n)
+
+#else
+
+#define INSTR_SCOPE(phase) ((void)0)
+#define INSTR_SCOPE_DETAIL(phase, detail) ((void)0)
+#define INSTR_COUNT(counter, n) ((void)0)
+
+#endif
+
+#endif
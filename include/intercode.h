@@ -4,6 +4,8 @@
 #include "ast.h"
 #include <string>
 #include <vector>
+#include <set>
+#include <map>
 #include <iostream>
 
 using namespace std;
@@ -18,8 +20,9 @@ enum QuadOp {
     OP_PARAM,                       // 参数传递
     OP_CALL,                        // 函数调用
     OP_RETURN,                      // 返回
-    OP_FUNC_BEGIN,                  // 函数头
-    OP_FUNC_END                     // 函数尾
+    OP_FUNC_BEGIN,                  // 函数头 result = 函数名，arg1 = 以逗号分隔的形参名
+    OP_FUNC_END,                    // 函数尾
+    OP_PHI                          // SSA 汇合 result = phi(phi...)，只在优化遍内部出现，见 ssa.h
 };
 
 // 四元式结构
@@ -28,6 +31,7 @@ struct Quad {
     string arg1; // 第一个参数
     string arg2; // 第二个参数
     string result; // 结果/目标/标签
+    vector<pair<string, string>> phi; // 仅 PHI：(值, 前驱块) 列表，arg1/arg2 为空
 
     Quad(QuadOp o, string a1, string a2, string res) 
         : op(o), arg1(a1), arg2(a2), result(res) {}
@@ -38,19 +42,34 @@ private:
     vector<Quad> codes; // 生成的四元式列表
     int tempCount = 0; // 临时变量计数器，用于生成唯一临时变量名
     int labelCount = 0; // 标签计数器，用于生成唯一标签名
+    string currentFunc; // 当前函数名，标签以函数名为前缀，临时变量和标签按函数独立编号
+    vector<string> freeTemps; // 已死亡、可复用的临时变量
+    set<string> liveTemps; // 当前仍然存活的临时变量
 
-    string newTemp(); // 生成新的临时变量名
+    string newTemp(); // 生成新的临时变量名（优先复用已死亡的临时变量）
+    void releaseTemp(const string& name); // 临时变量被使用后释放，供后续复用
     string newLabel(); // 生成新的标签名
     void emit(QuadOp op, string arg1, string arg2, string result); // 添加四元式到codes
 
     void genNode(ASTNode* node); // 生成节点的中间代码
     string genExpr(ExprNode* node); //  生成表达式的中间代码
+    int labelExpr(ExprNode* node); // 计算 Sethi-Ullman 标号
 
 public:
     InterCodeGenerator();
     void generate(ASTNode* root);
+    void generateFunction(FuncDef* func); // 只生成一个函数，结果与整体生成时该函数的部分相同
     const vector<Quad>& getCodes() const;
-    void printCodes(); // 调试用
+    void printCodes(ostream& out = cout); // 调试用
 };
 
+// 把四元式列表按 FUNC_BEGIN / FUNC_END 切分为每个函数一段
+vector<vector<Quad>> splitFunctions(const vector<Quad>& codes);
+vector<string> funcParams(const Quad& begin);            // FUNC_BEGIN 中的形参名
+string entryFunction(const vector<string>& names);        // 程序入口：有 main 时为 main，否则为第一个函数
+// 检查一个函数中的调用，arity 为程序中每个函数的形参个数；有错误时返回错误信息，否则为空
+string checkCalls(const vector<Quad>& codes, const map<string, int>& arity);
+void printQuads(const vector<Quad>& codes, ostream& out); // 调试用
+const char* quadOpName(QuadOp op);                        // 操作码的名字，如 "ADD"
+
 #endif
\ No newline at end of file
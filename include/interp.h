@@ -0,0 +1,75 @@
+#ifndef INTERP_H
+#define INTERP_H
+
+#include "intercode.h"
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+using namespace std;
+
+// 四元式解释器：直接执行中间代码，用作优化前后语义对比的基准以及执行计数的来源
+// 加载时把四元式预解码为紧凑的指令数组：
+//   - 每个函数的变量和常量编号为连续的槽位（形参在最前面），执行时不做字符串查找
+//   - 标签解析为指令下标，被调函数解析为函数编号
+// 语义与 MIPS 模拟器一致：算术按补码回绕，除数为 0 时结果为 0，未赋值的变量为 0，执行到函数尾返回 0
+// 入口默认是 main（没有时为第一个函数，与汇编相同），执行到它返回为止
+
+// 基本块执行计数
+struct IRBlockCount {
+    string name;       // 函数名或标签名，块不以标签开头时为 "函数名+下标"
+    int first;         // 块内第一条和最后一条四元式的下标
+    int last;
+    long long count;
+};
+
+class IRInterpreter {
+private:
+    // 预解码的指令，a / b / r 为当前栈帧中的槽位，-1 表示没有
+    struct Inst {
+        QuadOp op;
+        int a, b, r;
+        int target;    // 跳转目标（指令下标）或被调函数编号
+    };
+    struct Function {
+        string name;
+        int entry;                // FUNC_BEGIN 的下标
+        int params;               // 形参个数，形参为槽位 0..params-1
+        vector<int32_t> frame;    // 栈帧初值：变量为 0，常量槽位为常量值
+    };
+
+    vector<Inst> code;            // 与输入的四元式一一对应
+    vector<Function> funcs;
+    vector<int> blockStart;       // 每个基本块第一条四元式的下标
+    vector<string> blockName;
+    vector<long long> counts;     // 每条四元式的执行次数
+    vector<long long> taken;      // 条件跳转成功跳转的次数
+    long long steps;
+    long long maxSteps;
+    int maxDepth;
+    int32_t value;
+    bool returned;
+
+public:
+    IRInterpreter();
+
+    // 预解码四元式，引用了不存在的标签或函数时返回 false
+    bool load(const vector<Quad>& codes, string& error);
+    // 从 entry 函数（为空时为 main，没有 main 时为第一个函数）开始执行；超过步数或调用深度上限时返回 false
+    bool run(string& error, const string& entry = "");
+
+    void setMaxSteps(long long n);          // 默认 10 亿条四元式
+    void setMaxDepth(int n);                // 默认调用深度 10000
+    int32_t result() const;                 // 入口函数的返回值
+    bool hasReturned() const;               // 入口函数是否执行了带值的 RETURN
+    long long getSteps() const;
+    const vector<long long>& quadCounts() const;  // 下标与输入的四元式相同
+    const vector<long long>& takenCounts() const; // 同上，只有条件跳转不为 0
+    vector<IRBlockCount> blockCounts() const;
+
+    // 结果、执行的四元式条数以及最热的 top 个基本块
+    void printReport(ostream& out, int top = 10) const;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef IRFILE_H
+#define IRFILE_H
+
+#include "intercode.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// 二进制中间代码文件（.qir）
+// 所有字段为小端 32 位整数，文件可以直接 mmap 后按偏移访问，不需要解析：
+//   文件头    magic "QIR\0", version, stringCount, funcCount, quadCount, stringDataSize, 保留 x2
+//   字符串表  offsets[stringCount + 1]，第 i 个字符串为 data[offsets[i], offsets[i+1])
+//   字符串数据 stringDataSize 字节，之后填充到 4 字节对齐
+//   函数索引  每个函数 { nameId, firstQuad, quadCount, 保留 }
+//   四元式    每条 { op, arg1Id, arg2Id, resultId }
+// 0 号字符串固定为空串
+const uint32_t IR_FILE_VERSION = 1;
+
+struct IRFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t stringCount;
+    uint32_t funcCount;
+    uint32_t quadCount;
+    uint32_t stringDataSize;
+    uint32_t reserved[2];
+};
+
+struct IRFuncEntry {
+    uint32_t nameId;
+    uint32_t firstQuad;
+    uint32_t quadCount;
+    uint32_t reserved;
+};
+
+struct IRQuadRecord {
+    uint32_t op;
+    uint32_t arg1;
+    uint32_t arg2;
+    uint32_t result;
+};
+
+// 把四元式列表写为二进制中间代码文件，失败时返回 false
+bool writeIRFile(const string& path, const vector<Quad>& codes);
+
+// 只读映射一个中间代码文件，按需把函数还原为四元式
+class IRFile {
+private:
+    const char* data;
+    size_t size;
+    bool mapped;       // true: mmap 得到; false: 读入堆内存（不支持 mmap 的平台）
+
+    const IRFileHeader* header;
+    const uint32_t* stringOffsets;
+    const char* stringData;
+    const IRFuncEntry* funcs;
+    const IRQuadRecord* quads;
+
+    void close();
+
+public:
+    IRFile();
+    ~IRFile();
+    IRFile(const IRFile&) = delete;
+    IRFile& operator=(const IRFile&) = delete;
+
+    bool open(const string& path, string& error);
+
+    int functionCount() const;
+    string functionName(int index) const;
+    string getString(uint32_t id) const;
+    vector<Quad> functionQuads(int index) const;
+    vector<Quad> allQuads() const;
+};
+
+#endif
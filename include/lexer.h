@@ -10,21 +10,36 @@ enum TokenType {
     TOK_INT, TOK_VOID, TOK_RETURN, TOK_IF, TOK_ELSE, TOK_WHILE,
     TOK_ID, TOK_NUM,
     TOK_PLUS, TOK_MINUS, TOK_STAR, TOK_SLASH, TOK_ASSIGN,
-    TOK_LPAREN, TOK_RPAREN, TOK_LBRACE, TOK_RBRACE, TOK_SEMI,
+    TOK_LPAREN, TOK_RPAREN, TOK_LBRACE, TOK_RBRACE, TOK_SEMI, TOK_COMMA,
     TOK_EOF, TOK_ERROR
 };
 
 struct Token {
     TokenType type;
     string value;
+    int line = 0;   // 记号起始位置（从 1 开始）
+    int column = 0;
 };
 
+// 记号的可读名称，用于诊断信息
+string tokenName(TokenType type);
+
 class Lexer {
 private:
     string src;
     int pos;
+    istream* in;     // 流式输入；为空时 src 就是完整的源代码
+    int line;        // 下一个字符的位置
+    int column;
+    int tokLine;     // 当前记号的起始位置
+    int tokColumn;
+
+    bool hasChar();  // 还有未读字符（流式输入时按块补充缓冲区）
+    char advanceChar(); // 消费一个字符并更新行列号
+    Token scanToken();
 public:
-    Lexer(string source);
+    Lexer(string source, int startLine = 1, int startColumn = 1); // 源代码片段及其在文件中的起始位置
+    Lexer(istream& input); // 从流中按块读取，缓冲区只保留尚未消费的部分
     Token nextToken();
 };
 
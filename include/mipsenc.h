@@ -0,0 +1,56 @@
+#ifndef MIPSENC_H
+#define MIPSENC_H
+
+#include "intercode.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+using namespace std;
+
+// MIPS32 机器码编码器（--format=elf / bin）：不经过汇编文本，由与 AsmGenerator 相同的 Lowering
+// 直接生成指令字，代码与 .asm 输出逐条对应（同样没有延迟槽，与模拟器的约定一致）
+//   - 每个函数独立编码，跳转目标保留为标签，链接时统一解析
+//   - beq / bne 的偏移只有 16 位，超出范围时改写为反向的条件分支跳过一条 j（分支松弛）
+//   - 程序的布局与 .asm 相同：.data 为空，.text 依次为 $sp 初始化和入口调用、各函数、
+//     Program_Entry 跳板、Program_End
+// 输出为大端序：可重定位的 ELF32 目标文件（j / jal 使用 R_MIPS_26 重定位）或从地址 0 开始的裸二进制映像
+
+// 一条待链接的指令
+struct MipsInstr {
+    enum Kind { FIXED, BRANCH, JUMP };
+    Kind kind;
+    uint32_t word;          // BRANCH / JUMP 的偏移字段为 0，JUMP 为 j 或 jal
+    string target;          // BRANCH / JUMP 的目标标签
+};
+
+// 一段四元式的指令，标签为指令下标
+struct MipsFunction {
+    vector<MipsInstr> code;
+    map<string, int> labels;
+    vector<pair<string, int>> functions; // 函数名及其第一条指令的下标
+};
+
+// 链接后的 .text
+struct MipsObject {
+    vector<uint32_t> text;                     // 指令字
+    vector<uint32_t> jumpRelocs;               // 需要 R_MIPS_26 重定位的 j / jal 的字节偏移
+    vector<pair<string, uint32_t>> functions;  // 函数名及其字节偏移
+    uint32_t programEntry = 0;                 // Program_Entry 的字节偏移
+    uint32_t programEnd = 0;                   // Program_End 的字节偏移
+    int relaxedBranches = 0;                   // 被松弛为长跳转的分支数
+};
+
+// 翻译一个或多个完整的函数；不访问共享状态，可以并行调用
+MipsFunction mipsEncode(const vector<Quad>& codes, const map<string, long long>* weights = nullptr);
+
+// 加上程序头尾并按顺序拼接，解析标签并松弛越界的分支；入口为 main（没有时为第一个函数）
+// 标签重复或未定义时返回 false
+bool mipsLink(const vector<MipsFunction>& parts, MipsObject& out, string& error);
+
+// 序列化
+string mipsElfObject(const MipsObject& obj);
+string mipsRawImage(const MipsObject& obj);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef MIPSSIM_H
+#define MIPSSIM_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+using namespace std;
+
+// MIPS 模拟器：汇编 AsmGenerator 输出的指令子集并执行，统计动态指令数和流水线周期
+// 约定：
+//   - 从第一条指令开始执行，跳转到自身的 j（Program_End 死循环）视为程序结束
+//   - 不模拟延迟槽，算术溢出按补码回绕，不产生异常
+//   - 除数为 0 时商和余数都定义为 0
+
+enum MipsOp {
+    MOP_ADDI, MOP_LUI, MOP_ORI,
+    MOP_ADD, MOP_SUB,
+    MOP_MULT, MOP_DIV, MOP_MFLO, MOP_MFHI,
+    MOP_LW, MOP_SW,
+    MOP_BEQ, MOP_BNE,
+    MOP_J, MOP_JAL, MOP_JR,
+    MOP_COUNT
+};
+
+// 预先解码的指令，标签已解析为指令下标
+struct MipsInst {
+    MipsOp op;
+    int rd, rs, rt;  // 目的 / 源寄存器编号，未使用为 0
+    int32_t imm;     // 立即数或访存偏移
+    int target;      // 跳转目标（指令下标）
+    int line;        // 源文件行号，用于报错
+};
+
+// 执行统计
+struct SimStats {
+    long long instructions = 0;
+    long long opCounts[MOP_COUNT] = {};
+    long long loads = 0;
+    long long stores = 0;
+    long long branches = 0;       // 条件分支
+    long long takenBranches = 0;
+    long long jumps = 0;          // j / jal / jr（不含结束时的死循环）
+
+    // 经典 5 级流水线（IF ID EX MEM WB），带旁路，分支在 ID 级判定、预测不跳转
+    long long cycles = 0;
+    long long loadUseStalls = 0;  // lw 之后紧接着使用其结果
+    long long branchStalls = 0;   // 分支在 ID 级比较，操作数尚未就绪
+    long long flushStalls = 0;    // 跳转或分支成立时冲刷已取的一条指令
+    long long mulDivStalls = 0;   // mflo / mfhi 等待乘除法单元
+};
+
+class MipsSimulator {
+private:
+    vector<MipsInst> program;
+    int32_t regs[32];
+    int32_t hi, lo;
+    vector<int32_t> memory;  // 按字寻址，覆盖地址 0 上下各 2MB（栈从 1024 向下增长）
+    SimStats stats;
+    long long maxSteps;
+
+public:
+    MipsSimulator();
+
+    // 汇编文本，失败时返回 false 并给出 "line N: ..." 形式的错误
+    bool assemble(const string& text, string& error);
+    // 解码机器码（mipsenc 的 .text，从地址 0 开始），错误中的行号为指令的序号
+    bool load(const vector<uint32_t>& words, string& error);
+    // 执行到 Program_End；超出步数上限或访存越界时返回 false
+    bool run(string& error);
+
+    void setMaxSteps(long long n);  // 默认 10 亿条指令
+    int32_t result() const;         // $v0
+    const SimStats& getStats() const;
+    void printReport(ostream& out) const;
+
+    static const char* opName(MipsOp op);
+};
+
+#endif
@@ -3,35 +3,56 @@
 
 #include "lexer.h"
 #include "ast.h"
+#include <stdexcept>
+
+// 语法错误：由调用者捕获并报告，不再直接结束进程
+class SyntaxError : public runtime_error {
+public:
+    int line;
+    int column;
+    SyntaxError(const string& msg, int l = 0, int c = 0) : runtime_error(msg), line(l), column(c) {}
+};
 
 class Parser {
 private:
     Lexer& lexer;
     Token currentToken;
+    unsigned long long tokenHash;   // 当前函数已消费记号的 FNV-1a 哈希
+    void advance();                 // 消费当前记号（计入哈希）并读取下一个
     void eat(TokenType type);
+    [[noreturn]] void error(const string& msg); // 在当前记号处报告语法错误
+    ExprNode* parseCondition();     // ( expr )
+    StmtNode* parseSimpleStatement(); // 不含嵌套语句的语句
 
 public:
     Parser(Lexer& lex);
     
     ASTNode* parse();               // 程序入口
+    FuncDef* parseNextFunction();   // 流式解析：读取下一个函数，文件结束时返回 nullptr
     
     // 顶层结构
     ASTNode* parseGlobal();         // 解析全局变量或函数
     FuncDef* parseFuncDef();        // 解析函数
     
-    // 语句
+    // 语句（if / while / 块使用显式栈解析，嵌套深度不受调用栈限制）
     StmtNode* parseStatement();     // 语句分发器
     BlockStmt* parseBlock();        // { ... }
     StmtNode* parseVarDecl();       // int a = 1;
-    StmtNode* parseAssign();        // a = 1;
-    StmtNode* parseIf();            // if
-    StmtNode* parseWhile();         // while
+    StmtNode* parseAssign();        // a = 1; 或 f(a);
     StmtNode* parseReturn();        // return
 
-    // 表达式
-    ExprNode* parseExpression();
-    ExprNode* parseTerm();
-    ExprNode* parseFactor();
+    // 表达式（调度场算法，括号嵌套深度不受调用栈限制）
+    // leading 不为空时表示表达式开头的标识符已经被读入（调用语句 f(...);）
+    ExprNode* parseExpression(const string& leading = "");
+    ExprNode* parseFactor();        // NUM | ID
 };
 
+class ThreadPool;
+
+// 解析整个源文件。pool 不为空且文件较大时先按顶层花括号切分（函数定义的边界），
+// 各段由独立的 Lexer / Parser 并行解析，再按源代码顺序合并到 ProgramNode::elements
+// 每段的 Lexer 从该段在文件中的行列号开始计数；任何一段出错时整个文件串行重新解析，
+// 因此报告的语法错误与串行解析完全一致
+ASTNode* parseProgram(const string& source, ThreadPool* pool);
+
 #endif
\ No newline at end of file
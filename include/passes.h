@@ -0,0 +1,106 @@
+#ifndef PASSES_H
+#define PASSES_H
+
+#include "intercode.h"
+#include "cfg.h"
+#include "callgraph.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+
+using namespace std;
+
+// 中间代码优化遍与遍管理器
+// 函数级遍只读写单个函数，可以在线程池中并行执行；模块级遍（调用图）需要整个程序
+
+// 各个遍共用的工具
+int compactQuads(vector<Quad>& codes, const vector<bool>& removed); // 删除标记的四元式，返回删除数量
+bool foldArith(QuadOp op, int a, int b, int& r); // 常量折叠，除数为 0 时不折叠
+bool evalCond(QuadOp op, int a, int b);           // 条件跳转在常量操作数上是否成立
+
+// Os 反复执行函数级遍的安全上限：正常情况下几轮就没有修改了，达到上限说明遍之间在来回改写
+const int OS_MAX_ROUNDS = 64;
+
+// 优化级别
+enum OptLevel {
+    OPT_O0, // 不做任何优化
+    OPT_O1, // 只做调用图优化（过程间常量传播、删除不可达函数），默认
+    OPT_O2, // 函数级遍（含 SSA 上的稀疏优化）-> 调用图 -> 再执行一轮函数级遍
+    OPT_OS  // 同 O2，函数级遍反复执行直到没有变化，代码最短
+};
+
+// 遍的选择：先按优化级别确定流水线，再用 -fpass= / -fno-pass= 增删
+struct PassOptions {
+    OptLevel level = OPT_O1;
+    vector<string> enable;
+    vector<string> disable;
+    bool verify = false;         // -fverify-ir: 每个遍之后校验中间代码，出错时抛出 runtime_error
+};
+
+// 每个遍的执行次数、修改数量和耗时，多个线程共享
+class PassStatistics {
+private:
+    struct Entry {
+        long long runs = 0;
+        long long changes = 0;
+        double seconds = 0;
+    };
+    mutex lock;
+    map<string, Entry> entries;
+    vector<string> order;        // 第一次执行的顺序
+
+public:
+    void record(const string& pass, int changes, double seconds);
+    void print(ostream& out);
+};
+
+// 一个函数级遍：返回修改的四元式数量，preserved 为修改后仍然有效的分析
+// ssa 为 true 的遍在 SSA 形式上执行，遍管理器在需要时构造或还原 SSA
+struct FunctionPass {
+    const char* name;
+    int (*run)(FunctionIR& func);
+    int preserved;
+    bool ssa;
+};
+
+// 函数级遍，按固定顺序执行
+const vector<FunctionPass>& functionPasses();
+// 是否是已知的遍名（包括模块级的 "callgraph"）
+bool isKnownPass(const string& name);
+// 可用遍名列表，用于帮助信息
+string knownPassNames();
+
+class PassManager {
+private:
+    vector<const FunctionPass*> passes;
+    bool callGraph;
+    int maxRounds;               // 函数级遍的最大轮数（Os 迭代到不动点，以 OS_MAX_ROUNDS 为安全上限）
+    atomic<int> unconverged;     // 达到上限仍有修改的次数（对一个函数执行一次流水线计一次）
+    bool verify;
+    PassStatistics* stats;
+
+    void runPass(const FunctionPass& pass, FunctionIR& func, int& changes);
+    void convertSSA(FunctionIR& func, bool toSSA);
+    void check(const vector<Quad>& codes, const string& after, bool ssa = false) const;
+
+public:
+    explicit PassManager(const PassOptions& options, PassStatistics* stats = nullptr);
+
+    bool hasFunctionPasses() const;
+    bool hasModulePasses() const;
+
+    // 对单个函数执行所有函数级遍，返回修改数量；不同函数可以在多个线程中同时调用
+    int runFunctionPasses(vector<Quad>& codes);
+    // Os 下达到轮数上限、没有到达不动点的次数，调用者据此给出警告
+    int unconvergedRuns() const;
+    // 对整个程序执行模块级遍（调用图分析），返回修改数量
+    int runModulePasses(vector<Quad>& codes, CallGraph& graph);
+
+    // 流水线的描述，如 "constprop,simplifycfg,dce,callgraph"（Os 加 "Os:" 前缀），用于缓存配置
+    string describe() const;
+};
+
+#endif
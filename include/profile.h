@@ -0,0 +1,58 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "intercode.h"
+#include "interp.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+using namespace std;
+
+// 基于执行计数的优化（PGO）
+// --profile-generate 用解释器执行最终的中间代码，把每个函数的计数写入 profile 文件：
+//   qprof 1
+//   function <名字> <内容哈希> <调用次数>
+//   block <四元式下标> <执行次数>       下标相对于函数的 FUNC_BEGIN，只记录块的第一条
+//   branch <四元式下标> <跳转次数>      条件跳转成功跳转的次数
+//   end
+// --profile-use 按名字和内容哈希匹配函数：其他函数修改后，没有变化的函数仍然可以使用原来的计数；
+// 函数本身（或影响它的优化选项）变化后哈希不同，该函数的计数被忽略
+
+struct FunctionProfile {
+    string name;
+    uint64_t hash = 0;
+    long long entries = 0;
+    map<int, long long> blocks;
+    map<int, long long> taken;
+};
+
+class Profile {
+private:
+    map<pair<string, uint64_t>, FunctionProfile> funcs;
+
+public:
+    bool empty() const;
+    size_t size() const;
+    void add(FunctionProfile func);
+    const FunctionProfile* find(const string& name, uint64_t hash) const;
+    bool hasName(const string& name) const;       // 是否有同名函数（不论哈希）
+
+    bool load(const string& path, string& error);
+    bool save(const string& path) const;
+};
+
+// 函数中间代码（FUNC_BEGIN ... FUNC_END）的内容哈希，FNV-1a 64
+uint64_t hashFunction(const vector<Quad>& codes);
+
+// 从解释器的计数生成每个函数的 profile，codes 为解释器执行的整个程序
+void collectProfile(const vector<Quad>& codes, const IRInterpreter& interp, Profile& out);
+
+// 按 profile 重排一个函数的基本块：沿最热的边把块连成链，入口链在前，其余链按热度排列
+// 条件跳转的目标被放在下一块时把 JEQ / JNE 取反，其余失去直落的边补上跳转
+// weights 返回每个变量的热度（读写它的四元式的执行次数之和），供寄存器分配使用
+// 返回被移动的块数
+int layoutFunction(vector<Quad>& codes, const FunctionProfile& profile, map<string, long long>& weights);
+
+#endif
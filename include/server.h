@@ -0,0 +1,26 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "driver.h"
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+// 常驻编译服务：通过本地 Unix 套接字接收编译请求，进程、线程池和缓存在请求之间保持常驻
+// 一个连接上可以依次发送多个请求，协议中的整数均为小端 32 位：
+//   请求: 长度 + 源代码；长度为 SERVER_STOP 表示关闭服务
+//   应答: 状态 (0 成功 / 1 失败) + 长度 + 汇编 + 长度 + 诊断信息（每行一条）
+const unsigned SERVER_STOP = 0xFFFFFFFFu;
+// 单个字符串（源代码、汇编、诊断信息）的长度上限，超过时断开连接
+const unsigned SERVER_MAX_MESSAGE = 1u << 30;
+
+// 运行服务直到收到关闭请求或 SIGINT / SIGTERM，退出时断开仍然打开的连接并报告处理的请求数
+int runServer(const string& socketPath, const CompileOptions& options, ThreadPool& pool);
+
+// 把每个任务的源文件发送给服务，写出返回的汇编并报告吞吐量
+// stopServer 为真时在所有任务完成后请求服务退出
+int runClient(const string& socketPath, const vector<CompileJob>& jobs, bool stopServer);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "cfg.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// SSA 形式：每个变量只被赋值一次
+// 变量 x 的第 n 个定值改名为 x.n，没有定值就被读取的 x 保留原名（表示入口处的值）
+// 汇合点用块开头的 PHI 四元式选择来自各个前驱的值：
+//   PHI  phi = {(x.1, f.B0), (x.3, f.L2)}  值（变量或常量）和对应的前驱块，
+//                                          前驱块用块开头的标签标识，入口块用函数名
+//        result = x.4                      arg1、arg2 为空，打印时值和前驱各自用逗号连接
+// 构造时删除不可达的块，并给没有标签的块补上标签 <函数名>.B<n>，之后 SSA 遍不改变控制流
+// SSA 形式只存在于遍管理器内部，交给后端、解释器或写出之前总会被还原
+
+// 构造剪枝 SSA（支配边界放置 PHI，只在变量活跃的汇合点），返回插入的 PHI 数量
+int buildSSA(FunctionIR& func);
+
+// 还原：每条边上的 PHI 化为并行复制并串行化，跳转块的出边先拆分
+// 之后同一变量互不干扰的版本合并回原来的名字，返回插入的复制数量
+int destroySSA(FunctionIR& func);
+
+// 以下遍要求 SSA 形式，都不改变控制流图
+int sparseConstProp(FunctionIR& func); // sccp：稀疏条件常量传播
+int valueNumbering(FunctionIR& func);  // gvn：沿支配树的全局值编号与复制传播
+int sparseDeadCode(FunctionIR& func);  // ssadce：从有副作用的语句出发标记，删除其余定值
+
+#endif
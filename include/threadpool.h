@@ -0,0 +1,55 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+// 工作窃取线程池
+// 每个工作线程有自己的双端队列：自己从队尾取任务，空闲时从其他线程的队头窃取
+class ThreadPool {
+private:
+    struct WorkQueue {
+        deque<function<void()>> tasks;
+        mutex lock;
+    };
+
+    vector<unique_ptr<WorkQueue>> queues;
+    vector<thread> workers;
+
+    mutex sleepLock;
+    condition_variable wakeUp;   // 有新任务或需要退出
+    condition_variable allDone;  // 所有任务完成
+    atomic<int> pending;         // 已提交但未完成的任务数
+    atomic<int> queued;          // 仍在队列中等待执行的任务数
+    atomic<unsigned> nextQueue;  // 外部线程提交任务时轮流选择队列
+    bool stopping;
+
+    bool popLocal(int id, function<void()>& task);
+    bool steal(int id, function<void()>& task);
+    bool runOne();  // 当前线程取一个任务执行（自己的队列优先，否则窃取）
+    void finishTask();
+    void workerLoop(int id);
+
+public:
+    explicit ThreadPool(int threadCount = 0); // 0 表示使用 CPU 核心数
+    ~ThreadPool();
+
+    void submit(function<void()> task);
+    void wait();  // 阻塞直到所有已提交任务完成
+
+    // 并行执行 body(0) .. body(n-1)，返回时全部完成
+    // 调用线程在等待期间也会执行队列中的任务，因此可以在池内任务中嵌套调用而不会死锁
+    // body 抛出异常时其余任务照常完成，之后在调用线程上重新抛出第一个异常
+    void parallelFor(int n, const function<void(int)>& body);
+    int size() const;
+};
+
+#endif
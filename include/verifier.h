@@ -0,0 +1,22 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include "intercode.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 中间代码校验：检查函数边界、标签和操作数是否合法
+// 用于在优化遍之间及早发现遍产生的错误代码（-fverify-ir）
+
+// 校验单个函数（FUNC_BEGIN ... FUNC_END），失败时返回 false 并给出错误信息
+bool verifyFunction(const vector<Quad>& codes, string& error);
+
+// 校验整个程序：每个函数分别校验，且函数名不能重复
+bool verifyProgram(const vector<Quad>& codes, string& error);
+
+// SSA 形式的额外检查：每个变量只有一个定值
+bool verifySSA(const vector<Quad>& codes, string& error);
+
+#endif
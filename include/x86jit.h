@@ -0,0 +1,67 @@
+#ifndef X86JIT_H
+#define X86JIT_H
+
+#include "intercode.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <cstdint>
+
+using namespace std;
+
+// x86-64 JIT（--run）：四元式经过与 MIPS 后端相同的 Lowering（栈帧布局、寄存器分配）翻译为机器码，
+// 映射到可执行内存中直接调用。执行模型与生成的 MIPS 汇编一致：
+//   - 栈帧区初始清零，大小与模拟器的栈相同，变量位于 rbx + 偏移，对应汇编中的 $sp + 偏移
+//   - 调用约定与汇编相同（见 backend.h），从 main（没有时为第一个函数）开始执行，它返回时程序结束
+//   - 算术按补码回绕，除数为 0 时结果为 0，INT_MIN / -1 为 INT_MIN
+// 每次执行向后的跳转消耗一次迭代预算，用尽时报告错误而不是死循环；调用超出栈帧区时报告栈溢出
+// 机器码可以在任何平台上生成，只有 x86-64 Linux 上才能链接和执行
+
+// 一段四元式的机器码，跳转目标在链接时解析
+struct JitFunction {
+    vector<uint8_t> code;
+    map<string, size_t> labels;           // 函数名、标签在 code 中的偏移
+    vector<pair<size_t, string>> fixups;  // 需要填写 rel32 的位置及目标标签
+    vector<string> functions;             // 其中的函数名
+    int frameSize = 0;                    // 最大的栈帧字节数（含实参区）
+};
+
+// 翻译一个或多个完整的函数；不访问共享状态，可以并行调用
+// weights 为变量热度（见 profile.h），为空时按轮询法置换寄存器
+JitFunction jitCompile(const vector<Quad>& codes, const map<string, long long>* weights = nullptr);
+
+class X86JIT {
+private:
+    void* mem;              // 可执行的映射，未链接时为空
+    size_t memSize;
+    size_t codeBytes;
+    int frameBytes;
+    int functions;
+    long long maxIterations;
+    int32_t value;
+    bool returned;
+    double runMillis;
+
+public:
+    X86JIT();
+    ~X86JIT();
+    X86JIT(const X86JIT&) = delete;
+    X86JIT& operator=(const X86JIT&) = delete;
+
+    // 按顺序拼接各段机器码，解析跳转和调用后映射为只读可执行内存
+    // 标签重复或未定义、平台不支持或映射失败时返回 false
+    bool link(const vector<JitFunction>& parts, string& error);
+    // 执行一次；迭代预算用尽或栈溢出时返回 false
+    bool run(string& error);
+
+    void setMaxIterations(long long n);     // 默认 2^32 次向后跳转
+    int32_t result() const;
+    bool hasReturned() const;               // 入口函数是否执行了带值的 return
+    size_t codeSize() const;
+
+    // 结果、机器码大小和执行时间
+    void printReport(ostream& out) const;
+};
+
+#endif
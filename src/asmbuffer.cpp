@@ -0,0 +1,59 @@
+#include "asmbuffer.h"
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+
+AsmBuffer& AsmBuffer::operator<<(const char* s) {
+    data.append(s, strlen(s));
+    return *this;
+}
+
+AsmBuffer& AsmBuffer::operator<<(const string& s) {
+    data.append(s);
+    return *this;
+}
+
+AsmBuffer& AsmBuffer::operator<<(char c) {
+    data.push_back(c);
+    return *this;
+}
+
+AsmBuffer& AsmBuffer::operator<<(int v) {
+    char buf[16];
+    auto res = to_chars(buf, buf + sizeof(buf), v);
+    data.append(buf, res.ptr - buf);
+    return *this;
+}
+
+void AsmBuffer::append(const AsmBuffer& other) {
+    data.append(other.data);
+}
+
+void AsmBuffer::reserve(size_t n) {
+    data.reserve(n);
+}
+
+void AsmBuffer::clear() {
+    data.clear();
+}
+
+size_t AsmBuffer::size() const {
+    return data.size();
+}
+
+const string& AsmBuffer::str() const {
+    return data;
+}
+
+string AsmBuffer::take() {
+    string out;
+    out.swap(data);
+    return out;
+}
+
+bool AsmBuffer::writeFile(const string& path) const {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    return fclose(f) == 0 && ok;
+}
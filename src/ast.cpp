@@ -0,0 +1,66 @@
+#include "ast.h"
+
+/**
+ * 释放整棵语法树
+ * 结点的析构函数不释放子结点，这里用显式栈逐个收集子结点后再删除自身
+ */
+size_t freeAST(ASTNode* root) {
+    size_t count = 0;
+    vector<ASTNode*> stack;
+    if (root) stack.push_back(root);
+
+    while (!stack.empty()) {
+        ASTNode* node = stack.back();
+        stack.pop_back();
+
+        auto push = [&](ASTNode* child) { if (child) stack.push_back(child); };
+        switch (node->nodeType) {
+            case NODE_PROGRAM:
+                for (auto el : ((ProgramNode*)node)->elements) push(el);
+                break;
+            case NODE_FUNC_DEF:
+                push(((FuncDef*)node)->body);
+                break;
+            case NODE_BLOCK:
+                for (auto stmt : ((BlockStmt*)node)->stmts) push(stmt);
+                break;
+            case NODE_IF_STMT: {
+                IfStmt* s = (IfStmt*)node;
+                push(s->cond);
+                push(s->thenBlock);
+                push(s->elseBlock);
+                break;
+            }
+            case NODE_WHILE_STMT: {
+                WhileStmt* s = (WhileStmt*)node;
+                push(s->cond);
+                push(s->body);
+                break;
+            }
+            case NODE_RETURN_STMT:
+                push(((ReturnStmt*)node)->retVal);
+                break;
+            case NODE_VAR_DECL:
+                push(((VarDeclStmt*)node)->initVal);
+                break;
+            case NODE_ASSIGN_STMT:
+                push(((AssignStmt*)node)->value);
+                break;
+            case NODE_BINARY_EXPR:
+                push(((BinaryExpr*)node)->left);
+                push(((BinaryExpr*)node)->right);
+                break;
+            case NODE_CALL_EXPR:
+                for (auto arg : ((CallExpr*)node)->args) push(arg);
+                break;
+            case NODE_EXPR_STMT:
+                push(((ExprStmt*)node)->expr);
+                break;
+            default:
+                break;
+        }
+        delete node;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,302 @@
+#include "backend.h"
+#include "cfg.h"
+#include "instrument.h"
+#include <cctype>
+#include <algorithm>
+
+/**
+ * 构造函数：寄存器池由目标给出，其余状态与目标无关
+ */
+Lowering::Lowering(TargetEmitter& t) : target(t) {
+    availRegs = target.allocatableRegs();
+    for (int i = 0; i < 32; ++i) pinned[i] = false;
+    currentStackSize = 0; // 当前栈帧偏移初始化
+    maxStackSize = 0;
+    nextVictimIndex = 0;  // 寄存器置换算法（轮询法）的指针
+    frameBytes = 0;
+    raOffset = 0;
+    pendingArgs = 0;
+}
+
+void Lowering::setVarWeights(const map<string, long long>* weights) {
+    varWeights = weights;
+}
+
+int Lowering::frameSize() const {
+    return maxStackSize;
+}
+
+/**
+ * 判断操作数是否为纯数字字符串（立即数）
+ */
+bool Lowering::isNumber(const string& s) {
+    if (s.empty()) return false;
+    return isdigit((unsigned char)s[0]) || (s[0] == '-' && s.size() > 1);
+}
+
+/**
+ * 简单的栈分配：获取变量在当前栈帧中的偏移地址
+ * 如果变量不在栈上，则为其分配 4 字节空间
+ * @param var 变量名
+ */
+int Lowering::getOffset(const string& var) {
+    auto it = stackOffset.find(var);
+    if (it != stackOffset.end()) return it->second;
+    currentStackSize += 4;
+    if (currentStackSize > maxStackSize) maxStackSize = currentStackSize;
+    // 栈向下增长，因此偏移量为负
+    stackOffset[var] = -currentStackSize;
+    return -currentStackSize;
+}
+
+/**
+ * 清空所有寄存器状态（Spill）
+ * 通常在基本块结束或发生跳转时调用，保证数据一致性（Write-back 后清空）
+ */
+void Lowering::spillAll() {
+    INSTR_COUNT(CNT_SPILL_ALL, 1);
+    for (int i = 0; i < 32; ++i) regContent[i] = "";
+    varInReg.clear();
+    nextVictimIndex = 0;
+}
+
+/**
+ * 寄存器分配逻辑：获取一个可用的寄存器
+ * 1. 如果变量已在寄存器中，直接返回。
+ * 2. 如果有空闲寄存器，进行分配。
+ * 3. 如果已满，使用轮询法挑选一个“受害者”寄存器腾出空间。
+ */
+int Lowering::getReg(const string& var) {
+    // 命中：变量已在寄存器中
+    auto hit = varInReg.find(var);
+    if (hit != varInReg.end()) {
+        pinned[hit->second] = true;
+        return hit->second;
+    }
+
+    // 查找空闲寄存器
+    for (int r : availRegs) {
+        if (regContent[r].empty()) {
+            regContent[r] = var;
+            varInReg[var] = r;
+            pinned[r] = true;
+            return r;
+        }
+    }
+
+    // 置换：选择一个受害者（跳过当前四元式的操作数所在寄存器）
+    int victim;
+    if (varWeights) {
+        // 有 profile 时置换最冷的变量（常量不在表中，热度为 0，最先被置换），相同热度按轮询顺序
+        victim = -1;
+        long long best = 0;
+        for (size_t k = 0; k < availRegs.size(); ++k) {
+            int r = availRegs[(nextVictimIndex + k) % availRegs.size()];
+            if (pinned[r]) continue;
+            auto it = varWeights->find(regContent[r]);
+            long long w = (it == varWeights->end()) ? 0 : it->second;
+            if (victim < 0 || w < best) {
+                victim = r;
+                best = w;
+            }
+        }
+        nextVictimIndex = (nextVictimIndex + 1) % availRegs.size();
+    } else {
+        victim = availRegs[nextVictimIndex];
+        nextVictimIndex = (nextVictimIndex + 1) % availRegs.size();
+        while (pinned[victim]) {
+            victim = availRegs[nextVictimIndex];
+            nextVictimIndex = (nextVictimIndex + 1) % availRegs.size();
+        }
+    }
+
+    string oldVar = regContent[victim];
+    if (!oldVar.empty()) {
+        varInReg.erase(oldVar); // 移除旧变量的映射
+        INSTR_COUNT(CNT_SPILLS, 1);
+    }
+
+    regContent[victim] = var;
+    varInReg[var] = victim;
+    pinned[victim] = true;
+
+    return victim;
+}
+
+/**
+ * 操作数装入寄存器：立即数直接生成，变量总是从栈中重新读取
+ */
+int Lowering::useOperand(const string& s) {
+    int r = getReg(s);
+    if (isNumber(s)) {
+        target.loadImm(r, stoi(s));
+    } else {
+        target.load(r, getOffset(s));
+        INSTR_COUNT(CNT_LOADS, 1);
+    }
+    return r;
+}
+
+/**
+ * 函数开头确定栈帧：形参在前，其余变量按第一次出现的顺序（与逐条降级时按需分配的顺序相同），
+ * 函数中有调用时再加一个保存返回地址的槽位（名字中的 '$' 不会出现在标识符里）
+ * 栈帧复用了先前调用留下的内存，函数入口处活跃的非形参变量（可能未赋值就被读取）需要清零，
+ * 与解释器中未赋值的变量为 0 一致；正常的程序中这个集合为空
+ */
+vector<string> Lowering::layoutFrame(const vector<Quad>& quads, size_t begin) {
+    stackOffset.clear();
+    currentStackSize = 0;
+    pendingArgs = 0;
+    raOffset = 0;
+
+    size_t end = begin + 1;
+    while (end < quads.size() && quads[end].op != OP_FUNC_END) end++;
+    vector<Quad> body(quads.begin() + begin, quads.begin() + min(end + 1, quads.size()));
+
+    vector<string> params = funcParams(quads[begin]);
+    for (auto& p : params) getOffset(p);
+    VarIndex vars(body);
+    for (int v = 0; v < vars.size(); ++v) getOffset(vars.name(v));
+
+    // 同时等待 CALL 的实参最多有几个，它们位于栈帧之下
+    bool hasCall = false;
+    int depth = 0, maxDepth = 0;
+    for (auto& q : body) {
+        if (q.op == OP_PARAM) maxDepth = max(maxDepth, ++depth);
+        if (q.op == OP_CALL) {
+            hasCall = true;
+            depth -= min(depth, isNumber(q.arg2) ? stoi(q.arg2) : 0);
+        }
+    }
+    if (hasCall) raOffset = getOffset("$ra");
+    frameBytes = currentStackSize;
+    maxStackSize = max(maxStackSize, frameBytes + 4 * maxDepth);
+
+    vector<string> undefined;
+    CFG cfg(body);
+    Liveness liveness(body, cfg);
+    liveness.in(0).forEach([&](int v) {
+        const string& name = liveness.getVars().name(v);
+        if (find(params.begin(), params.end(), name) == params.end()) undefined.push_back(name);
+    });
+    return undefined;
+}
+
+void Lowering::emitStore(int reg, const string& var) {
+    target.store(reg, getOffset(var));
+    INSTR_COUNT(CNT_STORES, 1);
+}
+
+/**
+ * 遍历四元式，决定寄存器和栈位置后交给目标输出
+ */
+void Lowering::lower(const vector<Quad>& quads) {
+    for (size_t i = 0; i < quads.size(); ++i) {
+        const Quad& q = quads[i];
+        for (int i = 0; i < 32; ++i) pinned[i] = false;
+
+        // 基本块边界处理
+        // 在标签、跳转、函数调用前清空寄存器，将变量写回内存（保证跳转后状态正确）
+        if (q.op == OP_LABEL || q.op == OP_JMP || q.op == OP_JEQ || q.op == OP_JNE || q.op == OP_FUNC_BEGIN ||
+            q.op == OP_CALL) {
+            spillAll();
+        }
+
+        switch (q.op) {
+            case OP_FUNC_BEGIN: {
+                target.funcBegin(q.result);
+                // 函数开始时确定当前函数的栈帧
+                vector<string> undefined = layoutFrame(quads, i);
+                if (!undefined.empty()) {
+                    int zero = useOperand("0");
+                    for (auto& var : undefined) emitStore(zero, var);
+                }
+                break;
+            }
+
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+            case OP_DIV: {
+                int r1 = useOperand(q.arg1);
+                int r2 = useOperand(q.arg2);
+
+                // 准备结果寄存器 r3
+                if (varInReg.count(q.result)) {
+                    regContent[varInReg[q.result]] = "";
+                    varInReg.erase(q.result);
+                }
+                int r3 = getReg(q.result);
+                target.arith(q.op, r3, r1, r2);
+
+                // 写穿（Write-Through）策略：结果立即存回栈，防止溢出丢失
+                emitStore(r3, q.result);
+                break;
+            }
+
+            case OP_ASSIGN: { // 赋值语句：result = arg1
+                int r1 = useOperand(q.arg1);
+                // 更新寄存器描述符，并将结果存回栈
+                // 一个寄存器只记录一个变量：r1 改为保存 result，arg1 之后从栈中重新读取
+                if (varInReg.count(q.result) && varInReg[q.result] != r1) {
+                    regContent[varInReg[q.result]] = "";
+                }
+                varInReg.erase(q.arg1);
+                varInReg[q.result] = r1;
+                regContent[r1] = q.result;
+                emitStore(r1, q.result);
+                break;
+            }
+
+            case OP_LABEL:
+                target.label(q.result);
+                break;
+
+            case OP_JMP:
+                target.jump(q.result);
+                break;
+
+            case OP_JEQ:   // 条件跳转：if (arg1 == arg2) goto result
+            case OP_JNE: { // 条件跳转：if (arg1 != arg2) goto result（profile 调整分支方向后出现）
+                int r1 = useOperand(q.arg1);
+                int r2 = useOperand(q.arg2);
+                target.branch(q.op, r1, r2, q.result);
+                break;
+            }
+
+            case OP_PARAM: {
+                // 实参直接写到被调函数形参的位置
+                int r = useOperand(q.arg1);
+                target.store(r, -(frameBytes + 4 * ++pendingArgs));
+                INSTR_COUNT(CNT_STORES, 1);
+                break;
+            }
+
+            case OP_CALL: {
+                // 取走最近压入的 nargs 个实参，被调函数的栈顶正好在它们之上
+                int nargs = isNumber(q.arg2) ? stoi(q.arg2) : 0;
+                pendingArgs -= min(pendingArgs, nargs);
+                target.call(q.arg1, frameBytes + 4 * pendingArgs, raOffset);
+                if (!q.result.empty()) {
+                    int r = getReg(q.result);
+                    target.result(r);
+                    emitStore(r, q.result);
+                }
+                break;
+            }
+
+            case OP_RETURN: {
+                target.ret(q.arg1.empty() ? -1 : useOperand(q.arg1));
+                break;
+            }
+
+            case OP_FUNC_END: {
+                // 执行到函数尾返回 0；紧跟在 return 或无条件跳转之后时不可达
+                QuadOp prev = i > 0 ? quads[i - 1].op : OP_FUNC_END;
+                if (prev != OP_RETURN && prev != OP_JMP) target.ret(-1);
+                break;
+            }
+            default: break;
+        }
+    }
+}
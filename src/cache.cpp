@@ -0,0 +1,156 @@
+#include "cache.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <functional>
+#include <cstdio>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// 缓存文件格式版本，格式变化时递增
+static const char* CACHE_MAGIC = "QCACHE 2";
+
+CompileCache::CompileCache(string directory, unsigned long long maxSizeBytes)
+    : dir(directory), maxBytes(maxSizeBytes), hits(0), misses(0), stores(0), evictions(0) {
+    error_code ec;
+    fs::create_directories(dir, ec);
+}
+
+string CompileCache::pathFor(unsigned long long key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.fc", key);
+    return (fs::path(dir) / name).string();
+}
+
+CacheKey CompileCache::makeKey(unsigned long long tokenHash, const string& config) {
+    // FNV-1a：先混入配置字符串，再混入记号哈希的 8 个字节
+    unsigned long long h = 14695981039346656037ULL;
+    for (unsigned char c : config) h = (h ^ c) * 1099511628211ULL;
+    for (int i = 0; i < 8; ++i) h = (h ^ ((tokenHash >> (i * 8)) & 0xFF)) * 1099511628211ULL;
+    CacheKey key;
+    key.tokenHash = tokenHash;
+    key.config = config;
+    key.hash = h;
+    return key;
+}
+
+// 条目中保存的键原文：记号哈希（16 位十六进制）和配置字符串
+static string keyLine(const CacheKey& key) {
+    char hash[32];
+    snprintf(hash, sizeof(hash), "%016llx", key.tokenHash);
+    return string("key ") + hash + " " + key.config;
+}
+
+/**
+ * 查找缓存
+ * 文件格式：
+ *   QCACHE 2
+ *   key <记号哈希> <配置字符串>
+ *   callees <n> <name>...
+ *   <汇编文本>
+ * 格式不符或键原文不同（文件名哈希碰撞）的文件视为未命中
+ */
+bool CompileCache::lookup(const CacheKey& key, string& asmText, vector<string>& callees) {
+    string path = pathFor(key.hash);
+    ifstream in(path, ios::binary);
+    string magic, line;
+    if (!in.is_open() || !getline(in, magic) || magic != CACHE_MAGIC ||
+        !getline(in, line) || line != keyLine(key)) {
+        misses++;
+        return false;
+    }
+
+    getline(in, line);
+    istringstream header(line);
+    string tag;
+    int n = -1;
+    header >> tag >> n;
+    if (tag != "callees" || n < 0) {
+        misses++;
+        return false;
+    }
+    callees.clear();
+    for (int i = 0; i < n; ++i) {
+        string name;
+        header >> name;
+        callees.push_back(name);
+    }
+
+    stringstream body;
+    body << in.rdbuf();
+    asmText = body.str();
+
+    // 更新修改时间，作为 LRU 的最近使用时间
+    error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    hits++;
+    return true;
+}
+
+/**
+ * 写入缓存：先写临时文件再重命名，多个线程 / 进程同时写同一条目也不会读到半个文件
+ * 临时文件名含进程号和线程号，不同进程的线程号可能相同
+ */
+void CompileCache::store(const CacheKey& key, const string& asmText, const vector<string>& callees) {
+    string path = pathFor(key.hash);
+    string tmp = path + ".tmp" + to_string(getpid()) + "." + to_string(hash<thread::id>()(this_thread::get_id()));
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out.is_open()) return;
+        out << CACHE_MAGIC << "\n";
+        out << keyLine(key) << "\n";
+        out << "callees " << callees.size();
+        for (auto& c : callees) out << " " << c;
+        out << "\n";
+        out << asmText;
+    }
+    error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) fs::remove(tmp, ec);
+    else stores++;
+}
+
+void CompileCache::evict() {
+    lock_guard<mutex> guard(evictLock);
+
+    struct Entry {
+        fs::file_time_type time;
+        unsigned long long size;
+        fs::path path;
+    };
+    vector<Entry> entries;
+    unsigned long long total = 0;
+
+    error_code ec;
+    for (auto it = fs::directory_iterator(dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec) || it->path().extension() != ".fc") continue;
+        Entry e;
+        e.time = it->last_write_time(ec);
+        e.size = it->file_size(ec);
+        e.path = it->path();
+        total += e.size;
+        entries.push_back(e);
+    }
+    if (total <= maxBytes) return;
+
+    // 最久未使用的在前
+    sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (auto& e : entries) {
+        if (total <= maxBytes) break;
+        if (fs::remove(e.path, ec)) {
+            total -= e.size;
+            evictions++;
+        }
+    }
+}
+
+void CompileCache::printStats(ostream& out) {
+    long h = hits, m = misses;
+    long lookups = h + m;
+    out << "Cache: " << h << " hits, " << m << " misses";
+    if (lookups > 0) out << " (" << (h * 100 / lookups) << "% hit rate)";
+    out << ", " << stores << " stored, " << evictions << " evicted" << endl;
+}
@@ -0,0 +1,402 @@
+#include "callgraph.h"
+#include "passes.h"
+#include <functional>
+#include <algorithm>
+
+CallGraph::CallGraph(string entryName) : entry(entryName) {}
+
+bool CallGraph::isNumber(const string& s) {
+    if (s.empty()) return false;
+    return isdigit(s[0]) || (s[0] == '-' && s.size() > 1);
+}
+
+/**
+ * 在单个函数内做简单的局部常量跟踪
+ * 遇到标签（控制流汇合点）时清空已知常量，保证保守正确
+ * 每处理一条四元式之前调用 visit(下标, 当前常量表)
+ */
+static void walkConsts(const vector<Quad>& codes, int begin, int end,
+                       const map<string, FuncInfo>& funcs,
+                       const function<void(int, const map<string, int>&)>& visit) {
+    map<string, int> consts;
+    auto valueOf = [&](const string& s, int& v) -> bool {
+        if (s.empty()) return false;
+        if (isdigit(s[0]) || (s[0] == '-' && s.size() > 1)) { v = stoi(s); return true; }
+        auto it = consts.find(s);
+        if (it == consts.end()) return false;
+        v = it->second;
+        return true;
+    };
+
+    for (int i = begin; i <= end; ++i) {
+        const Quad& q = codes[i];
+        visit(i, consts);
+
+        switch (q.op) {
+            case OP_LABEL:
+                consts.clear();
+                break;
+            case OP_ASSIGN: {
+                int v;
+                if (valueOf(q.arg1, v)) consts[q.result] = v;
+                else consts.erase(q.result);
+                break;
+            }
+            case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: {
+                int a, b, v;
+                // 与运行时语义一致地折叠（32 位回绕，INT_MIN / -1 不陷入），除零不折叠
+                if (valueOf(q.arg1, a) && valueOf(q.arg2, b) && foldArith(q.op, a, b, v)) consts[q.result] = v;
+                else consts.erase(q.result);
+                break;
+            }
+            case OP_CALL: {
+                if (q.result.empty()) break;
+                auto it = funcs.find(q.arg1);
+                if (it != funcs.end() && it->second.hasConstReturn) consts[q.result] = it->second.constReturn;
+                else consts.erase(q.result);
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
+/**
+ * 扫描四元式，找出每个函数的范围以及直接调用关系
+ */
+void CallGraph::scanFunctions(const vector<Quad>& codes) {
+    funcs.clear();
+    order.clear();
+
+    string current;
+    for (int i = 0; i < (int)codes.size(); ++i) {
+        const Quad& q = codes[i];
+        if (q.op == OP_FUNC_BEGIN) {
+            current = q.result;
+            FuncInfo& fi = funcs[current];
+            fi.name = current;
+            fi.begin = i;
+            order.push_back(current);
+        } else if (q.op == OP_FUNC_END) {
+            if (!current.empty()) funcs[current].end = i;
+            current.clear();
+        } else if (q.op == OP_CALL && !current.empty()) {
+            FuncInfo& fi = funcs[current];
+            fi.callees.insert(q.arg1);
+            fi.isLeaf = false;
+        }
+    }
+
+    for (auto& name : order) {
+        for (auto& callee : funcs[name].callees) {
+            auto it = funcs.find(callee);
+            if (it != funcs.end()) it->second.callers.insert(name);
+        }
+    }
+}
+
+/**
+ * 从入口函数出发做可达性分析
+ * 如果没有入口函数（例如编译的是一个库），则认为所有函数都可达
+ */
+void CallGraph::computeReachable() {
+    if (funcs.find(entry) == funcs.end()) {
+        for (auto& kv : funcs) kv.second.reachable = true;
+        return;
+    }
+
+    vector<string> work = {entry};
+    funcs[entry].reachable = true;
+    while (!work.empty()) {
+        string name = work.back();
+        work.pop_back();
+        for (auto& callee : funcs[name].callees) {
+            auto it = funcs.find(callee);
+            if (it != funcs.end() && !it->second.reachable) {
+                it->second.reachable = true;
+                work.push_back(callee);
+            }
+        }
+    }
+}
+
+/**
+ * 纯函数分析
+ * 语言中没有全局变量和 I/O，函数的副作用只可能来自调用未知（外部）函数
+ * 采用乐观假设 + 不动点迭代，递归函数也能被正确识别
+ */
+void CallGraph::computePurity() {
+    for (auto& kv : funcs) kv.second.isPure = true;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& kv : funcs) {
+            FuncInfo& fi = kv.second;
+            if (!fi.isPure) continue;
+            for (auto& callee : fi.callees) {
+                auto it = funcs.find(callee);
+                if (it == funcs.end() || !it->second.isPure) {
+                    fi.isPure = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * 常量返回值分析：一个函数的所有 return 都返回同一常量时记录下来（执行到函数尾返回 0）
+ * 被调函数的常量返回值会参与调用者的常量跟踪，因此迭代到不动点
+ * @return 本轮是否有新的函数被识别为常量返回
+ */
+bool CallGraph::computeConstReturns(const vector<Quad>& codes) {
+    bool changedAny = false;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& name : order) {
+            FuncInfo& fi = funcs[name];
+            if (fi.hasConstReturn || fi.end < 0) continue;
+
+            bool allConst = true;
+            bool seen = false;
+            int value = 0;
+            walkConsts(codes, fi.begin, fi.end, funcs, [&](int i, const map<string, int>& consts) {
+                const Quad& q = codes[i];
+                // 可能执行到函数尾：返回 0
+                bool fallsOff = q.op == OP_FUNC_END && codes[i - 1].op != OP_RETURN && codes[i - 1].op != OP_JMP;
+                if (q.op != OP_RETURN && !fallsOff) return;
+                int v;
+                if (fallsOff || q.arg1.empty()) v = 0;
+                else if (isNumber(q.arg1)) v = stoi(q.arg1);
+                else if (consts.count(q.arg1)) v = consts.at(q.arg1);
+                else { allConst = false; return; }
+                if (seen && v != value) allConst = false;
+                seen = true;
+                value = v;
+            });
+
+            if (allConst && seen) {
+                fi.hasConstReturn = true;
+                fi.constReturn = value;
+                changed = changedAny = true;
+            }
+        }
+    }
+    return changedAny;
+}
+
+/**
+ * 常量实参分析：统计每个函数在所有调用点上的实参
+ * 某个位置在所有调用点上都是同一常量时，标记为常量参数
+ */
+void CallGraph::computeConstArgs(const vector<Quad>& codes) {
+    map<string, bool> firstSite;
+    for (auto& name : order) firstSite[name] = true;
+
+    for (auto& name : order) {
+        FuncInfo& caller = funcs[name];
+        if (caller.end < 0) continue;
+        // PARAM 压栈，CALL 从栈顶取走自己的 nargs 个实参（与解释器一致）：
+        // f(x, g(y)) 是 PARAM x; PARAM y; CALL g; PARAM t; CALL f，f 的实参是 x 和 t
+        // 实参在 PARAM 处求值；标签处从别处跳来的路径压入的实参未知，清空
+        vector<pair<bool, int>> pending; // (是否常量, 值)
+        walkConsts(codes, caller.begin, caller.end, funcs, [&](int i, const map<string, int>& consts) {
+            const Quad& q = codes[i];
+            if (q.op == OP_LABEL) pending.clear();
+            if (q.op == OP_PARAM) {
+                if (isNumber(q.arg1)) pending.push_back({true, stoi(q.arg1)});
+                else if (consts.count(q.arg1)) pending.push_back({true, consts.at(q.arg1)});
+                else pending.push_back({false, 0});
+            }
+            if (q.op != OP_CALL) return;
+
+            int nargs = isNumber(q.arg2) ? stoi(q.arg2) : 0;
+            size_t taken = min(pending.size(), (size_t)max(nargs, 0));
+            vector<pair<bool, int>> args(pending.end() - taken, pending.end());
+            pending.resize(pending.size() - taken);
+
+            auto it = funcs.find(q.arg1);
+            if (it == funcs.end()) return;
+            FuncInfo& callee = it->second;
+            callee.callSites++;
+
+            if (firstSite[callee.name]) {
+                firstSite[callee.name] = false;
+                callee.argIsConst.assign(args.size(), true);
+                callee.argConst.assign(args.size(), 0);
+                for (size_t k = 0; k < args.size(); ++k) {
+                    callee.argIsConst[k] = args[k].first;
+                    callee.argConst[k] = args[k].second;
+                }
+                return;
+            }
+
+            // 实参个数不一致的调用，整体放弃
+            if (args.size() != callee.argIsConst.size()) {
+                callee.argIsConst.assign(callee.argIsConst.size(), false);
+                return;
+            }
+            for (size_t k = 0; k < args.size(); ++k) {
+                if (!args[k].first || args[k].second != callee.argConst[k]) callee.argIsConst[k] = false;
+            }
+        });
+    }
+}
+
+void CallGraph::build(const vector<Quad>& codes) {
+    scanFunctions(codes);
+    computeReachable();
+    computePurity();
+    computeConstReturns(codes);
+    computeConstArgs(codes);
+}
+
+/**
+ * 过程间常量传播：被调函数返回常量时，把调用结果替换成常量赋值
+ * 纯函数的调用连同它的 PARAM 一起删除；非纯函数保留调用，只替换返回值
+ */
+int CallGraph::propagateConstants(vector<Quad>& codes) {
+    int replaced = 0;
+    vector<Quad> out;
+    out.reserve(codes.size());
+    vector<bool> removed;
+    vector<int> pending; // 尚未被 CALL 取走的 PARAM 在 out 中的下标，规则同 computeConstArgs
+
+    for (auto& q : codes) {
+        if (q.op == OP_FUNC_BEGIN || q.op == OP_LABEL) pending.clear();
+        if (q.op == OP_PARAM) pending.push_back((int)out.size());
+        if (q.op != OP_CALL) { out.push_back(q); continue; }
+
+        int nargs = isNumber(q.arg2) ? stoi(q.arg2) : 0;
+        size_t taken = min(pending.size(), (size_t)max(nargs, 0));
+        vector<int> params(pending.end() - taken, pending.end());
+        pending.resize(pending.size() - taken);
+
+        auto it = funcs.find(q.arg1);
+        if (it == funcs.end() || !it->second.hasConstReturn) { out.push_back(q); continue; }
+
+        const FuncInfo& callee = it->second;
+        string value = to_string(callee.constReturn);
+        if (callee.isPure && (int)params.size() == nargs) {
+            // 删除这次调用自己的 PARAM（实参求值的临时变量由后续死代码删除处理）
+            removed.resize(out.size(), false);
+            for (int j : params) removed[j] = true;
+            if (!q.result.empty()) out.emplace_back(OP_ASSIGN, value, "", q.result);
+        } else {
+            // 找不全自己的 PARAM 时不能删除调用，否则剩下的 PARAM 会被下一次调用取走
+            out.emplace_back(OP_CALL, q.arg1, q.arg2, "");
+            if (!q.result.empty()) out.emplace_back(OP_ASSIGN, value, "", q.result);
+        }
+        replaced++;
+    }
+
+    removed.resize(out.size(), false);
+    compactQuads(out, removed);
+    codes.swap(out);
+    return replaced;
+}
+
+/**
+ * 常量实参传播：某个形参在所有调用点上都是同一常量时，在函数开头把它赋为该常量，
+ * 之后的函数级遍可以据此折叠
+ * 入口函数由程序外部调用，实参未知；没有入口函数时所有函数都可能被外部调用，不做传播
+ */
+int CallGraph::propagateConstArgs(vector<Quad>& codes) {
+    if (funcs.find(entry) == funcs.end()) return 0;
+
+    int replaced = 0;
+    vector<Quad> out;
+    out.reserve(codes.size());
+    for (auto& q : codes) {
+        out.push_back(q);
+        if (q.op != OP_FUNC_BEGIN || q.result == entry) continue;
+        const FuncInfo& fi = funcs[q.result];
+        vector<string> params = funcParams(q);
+        if (fi.callSites == 0 || fi.argIsConst.size() != params.size()) continue;
+        for (size_t k = 0; k < params.size(); ++k) {
+            if (!fi.argIsConst[k]) continue;
+            out.emplace_back(OP_ASSIGN, to_string(fi.argConst[k]), "", params[k]);
+            replaced++;
+        }
+    }
+    if (replaced > 0) codes.swap(out);
+    return replaced;
+}
+
+/**
+ * 删除从入口函数不可达的函数
+ */
+int CallGraph::eliminateDeadFunctions(vector<Quad>& codes) {
+    int removed = 0;
+    vector<Quad> out;
+    out.reserve(codes.size());
+
+    bool skipping = false;
+    for (auto& q : codes) {
+        if (q.op == OP_FUNC_BEGIN) {
+            auto it = funcs.find(q.result);
+            skipping = it != funcs.end() && !it->second.reachable;
+            if (skipping) removed++;
+        }
+        if (!skipping) out.push_back(q);
+        if (q.op == OP_FUNC_END) skipping = false;
+    }
+
+    codes.swap(out);
+    return removed;
+}
+
+int CallGraph::run(vector<Quad>& codes) {
+    build(codes);
+    int changes = propagateConstants(codes);
+    // 常量传播会删除调用边和调用点，重建后再统计实参和可达性
+    if (changes > 0) build(codes);
+    changes += propagateConstArgs(codes);
+    changes += eliminateDeadFunctions(codes);
+    build(codes);
+    return changes;
+}
+
+bool CallGraph::hasFunction(const string& name) const {
+    return funcs.find(name) != funcs.end();
+}
+
+const FuncInfo& CallGraph::getInfo(const string& name) const {
+    return funcs.at(name);
+}
+
+bool CallGraph::isPure(const string& name) const {
+    auto it = funcs.find(name);
+    return it != funcs.end() && it->second.isPure;
+}
+
+bool CallGraph::isLeaf(const string& name) const {
+    auto it = funcs.find(name);
+    return it != funcs.end() && it->second.isLeaf;
+}
+
+const vector<string>& CallGraph::getOrder() const {
+    return order;
+}
+
+void CallGraph::print(ostream& out) const {
+    for (auto& name : order) {
+        const FuncInfo& fi = funcs.at(name);
+        out << name << ":";
+        if (fi.isLeaf) out << " leaf";
+        if (fi.isPure) out << " pure";
+        if (!fi.reachable) out << " dead";
+        if (fi.hasConstReturn) out << " const-return=" << fi.constReturn;
+        out << " calls={";
+        bool first = true;
+        for (auto& c : fi.callees) { out << (first ? "" : ", ") << c; first = false; }
+        out << "}";
+        for (size_t k = 0; k < fi.argIsConst.size(); ++k) {
+            if (fi.argIsConst[k]) out << " arg" << k << "=" << fi.argConst[k];
+        }
+        out << endl;
+    }
+}
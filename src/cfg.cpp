@@ -0,0 +1,324 @@
+#include "cfg.h"
+#include <algorithm>
+
+bool isConstOperand(const string& s) {
+    if (s.empty()) return false;
+    return isdigit((unsigned char)s[0]) || (s[0] == '-' && s.size() > 1);
+}
+
+bool isVarOperand(const string& s) {
+    return !s.empty() && !isConstOperand(s);
+}
+
+bool isBranch(QuadOp op) {
+    return op == OP_JMP || op == OP_JEQ || op == OP_JNE || op == OP_JGT || op == OP_JLT;
+}
+
+bool isArith(QuadOp op) {
+    return op == OP_ADD || op == OP_SUB || op == OP_MUL || op == OP_DIV;
+}
+
+void quadUses(const Quad& q, vector<const string*>& uses) {
+    uses.clear();
+    switch (q.op) {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+        case OP_JEQ: case OP_JNE: case OP_JGT: case OP_JLT:
+            if (isVarOperand(q.arg1)) uses.push_back(&q.arg1);
+            if (isVarOperand(q.arg2)) uses.push_back(&q.arg2);
+            break;
+        case OP_ASSIGN: case OP_PARAM: case OP_RETURN:
+            if (isVarOperand(q.arg1)) uses.push_back(&q.arg1);
+            break;
+        default:
+            break;
+    }
+}
+
+const string* quadDef(const Quad& q) {
+    if (isArith(q.op) || q.op == OP_ASSIGN || q.op == OP_PHI) return &q.result;
+    if (q.op == OP_CALL && !q.result.empty()) return &q.result;
+    return nullptr;
+}
+
+/**
+ * 划分基本块并连接边
+ * 块的开头：第一条四元式、标签、跳转或返回之后的四元式
+ */
+CFG::CFG(const vector<Quad>& codes) {
+    int n = (int)codes.size();
+    blockOf.assign(n, -1);
+    for (int i = 0; i < n; ++i) {
+        bool leader = (i == 0) || codes[i].op == OP_LABEL ||
+                      isBranch(codes[i - 1].op) || codes[i - 1].op == OP_RETURN;
+        if (leader) blocks.push_back({i, i, {}, {}});
+        blocks.back().last = i;
+        blockOf[i] = (int)blocks.size() - 1;
+        if (codes[i].op == OP_LABEL) labelBlock[codes[i].result] = blockOf[i];
+    }
+
+    auto link = [&](int from, int to) {
+        if (to < 0) return;
+        if (find(blocks[from].succs.begin(), blocks[from].succs.end(), to) != blocks[from].succs.end()) return;
+        blocks[from].succs.push_back(to);
+        blocks[to].preds.push_back(from);
+    };
+    for (int b = 0; b < (int)blocks.size(); ++b) {
+        const Quad& last = codes[blocks[b].last];
+        if (isBranch(last.op)) link(b, blockOfLabel(last.result));
+        if (last.op != OP_JMP && last.op != OP_RETURN && last.op != OP_FUNC_END && b + 1 < (int)blocks.size()) {
+            link(b, b + 1);
+        }
+    }
+
+    // 深度优先求逆后序（显式栈）
+    if (blocks.empty()) return;
+    vector<int> state(blocks.size(), 0); // 0 未访问，1 在栈上，2 完成
+    vector<pair<int, int>> stack = {{0, 0}};
+    state[0] = 1;
+    while (!stack.empty()) {
+        int b = stack.back().first;
+        int& next = stack.back().second;
+        if (next < (int)blocks[b].succs.size()) {
+            int s = blocks[b].succs[next++];
+            if (state[s] == 0) {
+                state[s] = 1;
+                stack.push_back({s, 0});
+            }
+            continue;
+        }
+        state[b] = 2;
+        rpo.push_back(b);
+        stack.pop_back();
+    }
+    reverse(rpo.begin(), rpo.end());
+    isReachable.assign(blocks.size(), false);
+    for (int b : rpo) isReachable[b] = true;
+}
+
+int CFG::size() const {
+    return (int)blocks.size();
+}
+
+const BasicBlock& CFG::block(int b) const {
+    return blocks[b];
+}
+
+int CFG::blockOfQuad(int i) const {
+    return blockOf[i];
+}
+
+int CFG::blockOfLabel(const string& label) const {
+    auto it = labelBlock.find(label);
+    return it == labelBlock.end() ? -1 : it->second;
+}
+
+const vector<int>& CFG::reversePostOrder() const {
+    return rpo;
+}
+
+bool CFG::reachable(int b) const {
+    return isReachable[b];
+}
+
+VarIndex::VarIndex(const vector<Quad>& codes) {
+    vector<const string*> uses;
+    auto add = [&](const string& s) {
+        if (!isVarOperand(s) || ids.count(s)) return;
+        ids[s] = (int)names.size();
+        names.push_back(s);
+    };
+    for (auto& q : codes) {
+        quadUses(q, uses);
+        for (auto u : uses) add(*u);
+        if (const string* d = quadDef(q)) add(*d);
+    }
+}
+
+int VarIndex::size() const {
+    return (int)names.size();
+}
+
+int VarIndex::id(const string& name) const {
+    auto it = ids.find(name);
+    return it == ids.end() ? -1 : it->second;
+}
+
+const string& VarIndex::name(int id) const {
+    return names[id];
+}
+
+bool BitSet::unite(const BitSet& o) {
+    bool changed = false;
+    for (size_t i = 0; i < words.size(); ++i) {
+        uint64_t w = words[i] | o.words[i];
+        if (w != words[i]) { words[i] = w; changed = true; }
+    }
+    return changed;
+}
+
+bool BitSet::assignTransfer(const BitSet& use, const BitSet& out, const BitSet& def) {
+    bool changed = false;
+    for (size_t i = 0; i < words.size(); ++i) {
+        uint64_t w = use.words[i] | (out.words[i] & ~def.words[i]);
+        if (w != words[i]) { words[i] = w; changed = true; }
+    }
+    return changed;
+}
+
+/**
+ * in[b] = use[b] ∪ (out[b] - def[b])，out[b] = ∪ in[succ]
+ * 按逆后序的反向遍历，通常两三轮就能收敛
+ */
+Liveness::Liveness(const vector<Quad>& codes, const CFG& cfg) : vars(codes) {
+    int n = cfg.size();
+    int nv = vars.size();
+    vector<BitSet> use(n, BitSet(nv)), def(n, BitSet(nv));
+    liveIn.assign(n, BitSet(nv));
+    liveOut.assign(n, BitSet(nv));
+
+    vector<const string*> uses;
+    for (int b = 0; b < n; ++b) {
+        for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+            quadUses(codes[i], uses);
+            for (auto u : uses) {
+                int v = vars.id(*u);
+                if (!def[b].test(v)) use[b].set(v);
+            }
+            if (const string* d = quadDef(codes[i])) def[b].set(vars.id(*d));
+        }
+    }
+
+    // 不可达的块也参与计算，保证结果对所有块都有定义
+    vector<int> order = cfg.reversePostOrder();
+    for (int b = 0; b < n; ++b) {
+        if (!cfg.reachable(b)) order.push_back(b);
+    }
+    reverse(order.begin(), order.end());
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b : order) {
+            for (int s : cfg.block(b).succs) liveOut[b].unite(liveIn[s]);
+            if (liveIn[b].assignTransfer(use[b], liveOut[b], def[b])) changed = true;
+        }
+    }
+}
+
+const VarIndex& Liveness::getVars() const {
+    return vars;
+}
+
+const BitSet& Liveness::in(int b) const {
+    return liveIn[b];
+}
+
+const BitSet& Liveness::out(int b) const {
+    return liveOut[b];
+}
+
+/**
+ * Cooper, Harvey, Kennedy: "A Simple, Fast Dominance Algorithm"
+ */
+Dominators::Dominators(const CFG& cfg) {
+    int n = cfg.size();
+    idom.assign(n, -1);
+    order.assign(n, -1);
+    children.assign(n, {});
+    frontier.assign(n, {});
+    const vector<int>& rpo = cfg.reversePostOrder();
+    if (rpo.empty()) return;
+    for (int i = 0; i < (int)rpo.size(); ++i) order[rpo[i]] = i;
+
+    int entry = rpo[0];
+    idom[entry] = entry;
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (order[a] > order[b]) a = idom[a];
+            while (order[b] > order[a]) b = idom[b];
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t k = 1; k < rpo.size(); ++k) {
+            int b = rpo[k];
+            int newIdom = -1;
+            for (int p : cfg.block(b).preds) {
+                if (idom[p] < 0) continue;
+                newIdom = (newIdom < 0) ? p : intersect(p, newIdom);
+            }
+            if (newIdom != idom[b]) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    for (int b : rpo) {
+        if (b != entry) children[idom[b]].push_back(b);
+    }
+
+    // 支配边界：汇合点沿每个前驱向上走到其直接支配者为止
+    for (int b : rpo) {
+        const vector<int>& preds = cfg.block(b).preds;
+        if (preds.size() < 2) continue;
+        for (int p : preds) {
+            if (idom[p] < 0) continue;
+            int runner = p;
+            while (runner != idom[b]) {
+                vector<int>& df = frontier[runner];
+                if (df.empty() || df.back() != b) df.push_back(b);
+                runner = idom[runner];
+            }
+        }
+    }
+}
+
+int Dominators::getIdom(int b) const {
+    return idom[b];
+}
+
+bool Dominators::dominates(int a, int b) const {
+    if (idom[b] < 0 || idom[a] < 0) return false;
+    while (true) {
+        if (a == b) return true;
+        if (idom[b] == b) return false;
+        b = idom[b];
+    }
+}
+
+const vector<int>& Dominators::getChildren(int b) const {
+    return children[b];
+}
+
+const vector<int>& Dominators::getFrontier(int b) const {
+    return frontier[b];
+}
+
+FunctionIR::FunctionIR(vector<Quad> codes) : codes(move(codes)) {}
+
+const CFG& FunctionIR::getCFG() {
+    if (!cfg) cfg = make_unique<CFG>(codes);
+    return *cfg;
+}
+
+const Liveness& FunctionIR::getLiveness() {
+    if (!liveness) liveness = make_unique<Liveness>(codes, getCFG());
+    return *liveness;
+}
+
+const Dominators& FunctionIR::getDominators() {
+    if (!dominators) dominators = make_unique<Dominators>(getCFG());
+    return *dominators;
+}
+
+void FunctionIR::invalidate(int preserved) {
+    // 其他分析都依赖控制流图
+    if (!(preserved & ANALYSIS_CFG)) preserved = 0;
+    if (!preserved) cfg.reset();
+    if (!(preserved & ANALYSIS_LIVENESS)) liveness.reset();
+    if (!(preserved & ANALYSIS_DOMINATORS)) dominators.reset();
+}
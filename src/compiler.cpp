@@ -0,0 +1,482 @@
+#include "compiler.h"
+#include "lexer.h"
+#include "myparser.h"
+#include "asmgen.h"
+#include "callgraph.h"
+#include "interp.h"
+#include "x86jit.h"
+#include "mipsenc.h"
+#include "instrument.h"
+#include <sstream>
+#include <set>
+
+// 打印工具：支持所有节点类型
+// 使用显式栈代替递归，任务要么是待打印的结点，要么是一行固定文本（如 "Cond:"）
+void printAST(ASTNode* root, ostream& out, int level) {
+    if (!root) return;
+
+    struct Task {
+        ASTNode* node;
+        int level;
+        string text; // node 为空时直接输出该行
+    };
+    vector<Task> tasks = {{root, level, ""}};
+
+    while (!tasks.empty()) {
+        Task task = tasks.back();
+        tasks.pop_back();
+        ASTNode* node = task.node;
+        int lv = task.level;
+        string indent(lv * 2, ' ');
+
+        if (!node) {
+            if (!task.text.empty()) out << task.text << '\n';
+            continue;
+        }
+
+        // 子任务按输出顺序收集，最后逆序压栈
+        vector<Task> children;
+        switch (node->nodeType) {
+            case NODE_PROGRAM: {
+                out << indent << "Program" << '\n';
+                ProgramNode* prog = (ProgramNode*)node;
+                for (auto el : prog->elements) children.push_back({el, lv + 1, ""});
+                break;
+            }
+            case NODE_FUNC_DEF: {
+                FuncDef* func = (FuncDef*)node;
+                out << indent << "Function: " << func->returnType << " " << func->funcName << "(";
+                for (size_t k = 0; k < func->args.size(); ++k) out << (k ? ", " : "") << func->args[k];
+                out << ")" << '\n';
+                children.push_back({func->body, lv + 1, ""});
+                break;
+            }
+            case NODE_BLOCK: {
+                out << indent << "Block { ... }" << '\n';
+                BlockStmt* block = (BlockStmt*)node;
+                for (auto stmt : block->stmts) children.push_back({stmt, lv + 1, ""});
+                break;
+            }
+            case NODE_IF_STMT: {
+                out << indent << "If Statement" << '\n';
+                IfStmt* s = (IfStmt*)node;
+                children.push_back({nullptr, lv, indent + "  Cond:"});
+                children.push_back({s->cond, lv + 2, ""});
+                children.push_back({nullptr, lv, indent + "  Then:"});
+                children.push_back({s->thenBlock, lv + 2, ""});
+                if (s->elseBlock) {
+                    children.push_back({nullptr, lv, indent + "  Else:"});
+                    children.push_back({s->elseBlock, lv + 2, ""});
+                }
+                break;
+            }
+            case NODE_WHILE_STMT: {
+                out << indent << "While Statement" << '\n';
+                WhileStmt* s = (WhileStmt*)node;
+                children.push_back({nullptr, lv, indent + "  Cond:"});
+                children.push_back({s->cond, lv + 2, ""});
+                children.push_back({nullptr, lv, indent + "  Body:"});
+                children.push_back({s->body, lv + 2, ""});
+                break;
+            }
+            case NODE_RETURN_STMT: {
+                out << indent << "Return" << '\n';
+                children.push_back({((ReturnStmt*)node)->retVal, lv + 1, ""});
+                break;
+            }
+            case NODE_VAR_DECL: {
+                VarDeclStmt* s = (VarDeclStmt*)node;
+                out << indent << "VarDecl: " << s->type << " " << s->name << '\n';
+                if (s->initVal) {
+                    children.push_back({nullptr, lv, indent + "  = "});
+                    children.push_back({s->initVal, lv + 2, ""});
+                }
+                break;
+            }
+            case NODE_ASSIGN_STMT: {
+                AssignStmt* s = (AssignStmt*)node;
+                out << indent << "Assign: " << s->varName << " =" << '\n';
+                children.push_back({s->value, lv + 1, ""});
+                break;
+            }
+            case NODE_BINARY_EXPR: {
+                BinaryExpr* s = (BinaryExpr*)node;
+                out << indent << "Op: " << s->op << '\n';
+                children.push_back({s->left, lv + 1, ""});
+                children.push_back({s->right, lv + 1, ""});
+                break;
+            }
+            case NODE_EXPR_STMT: {
+                out << indent << "Expression Statement" << '\n';
+                children.push_back({((ExprStmt*)node)->expr, lv + 1, ""});
+                break;
+            }
+            case NODE_CALL_EXPR: {
+                CallExpr* s = (CallExpr*)node;
+                out << indent << "Call: " << s->funcName << '\n';
+                for (auto arg : s->args) children.push_back({arg, lv + 1, ""});
+                break;
+            }
+            case NODE_NUMBER: {
+                out << indent << ((NumberNode*)node)->value << '\n';
+                break;
+            }
+            case NODE_IDENTIFIER: {
+                out << indent << "Id: " << ((IdNode*)node)->name << '\n';
+                break;
+            }
+        }
+        for (auto it = children.rbegin(); it != children.rend(); ++it) tasks.push_back(*it);
+    }
+}
+
+/**
+ * 缓存配置字符串
+ * 缓存模式下不做过程间常量传播，因此单独标记；优化流水线不同时生成的代码也不同
+ */
+string cacheConfig(const CompileOptions& options) {
+    return string("version=") + COMPILER_VERSION + ";ipcp=0;passes=" + PassManager(options.passes).describe();
+}
+
+string formatDiagnostic(const Diagnostic& d, const string& file) {
+    ostringstream out;
+    if (!file.empty()) out << file << ":";
+    if (d.line > 0) out << d.line << ":" << d.column << ":";
+    if (!file.empty() || d.line > 0) out << " ";
+    out << (d.severity == Diagnostic::ERROR ? "error: " : "warning: ") << d.message;
+    return out.str();
+}
+
+/**
+ * Os 的函数级遍达到轮数上限仍未到达不动点时给出警告（生成的代码仍然正确，只是可能不是最短）
+ */
+static void warnUnconverged(const PassManager& pm, CompileOutput& result) {
+    int n = pm.unconvergedRuns();
+    if (n == 0) return;
+    result.diagnostics.push_back({Diagnostic::WARNING, 0, 0,
+                                  "function passes stopped after " + to_string(OS_MAX_ROUNDS) +
+                                      " rounds without reaching a fixpoint (" + to_string(n) + " time(s))"});
+}
+
+/**
+ * 从内存中的源代码编译：词法/语法分析 -> 中间代码 -> 优化流水线 -> 汇编
+ * 任何错误都以诊断信息的形式返回，不会结束进程，也不写任何文件或全局输出流
+ */
+CompileOutput compileSource(const string& source, const CompileOptions& options, ThreadPool* pool) {
+    INSTR_SCOPE("compile");
+    CompileOutput result;
+    ostringstream log;
+
+    if (source.empty()) {
+        result.diagnostics.push_back({Diagnostic::WARNING, 0, 0, "source is empty"});
+        return result;
+    }
+
+    try {
+        ASTNode* root;
+        {
+            INSTR_SCOPE("parse");
+            root = parseProgram(source, pool);
+        }
+
+        if (options.dumpAST) {
+            log << "\nGenerated AST Structure:" << '\n';
+            log << "========================" << '\n';
+            printAST(root, log);
+            log << '\n';
+        }
+
+        // 只要求语法树时在此结束，不生成中间代码
+        if (!options.emitAsm && !options.emitIR && !options.dumpIR) {
+            freeAST(root);
+            result.success = true;
+            result.log = log.str();
+            return result;
+        }
+
+        // 收集所有函数
+        vector<FuncDef*> funcs;
+        for (auto el : ((ProgramNode*)root)->elements) {
+            if (el->nodeType == NODE_FUNC_DEF) funcs.push_back((FuncDef*)el);
+        }
+        int n = (int)funcs.size();
+
+        // 查询增量编译缓存：命中的函数直接复用汇编，跳过中间代码和汇编生成
+        // 输出中间代码、解释执行或使用计数时需要每个函数的四元式，不使用缓存
+        // 缓存中保存的是汇编文本，直接输出机器码时也不使用
+        bool needIR = options.emitIR || options.interpret || options.run || !options.profileGenerate.empty() ||
+                      options.profileUse;
+        CompileCache* cache = (needIR || !options.emitAsm || options.format != FORMAT_ASM) ? nullptr : options.cache;
+        vector<CacheKey> keys(n);
+        vector<bool> cached(n, false);
+        vector<string> asmParts(n);
+        vector<vector<string>> cachedCallees(n);
+        if (cache) {
+            string config = cacheConfig(options);
+            for (int i = 0; i < n; ++i) {
+                keys[i] = CompileCache::makeKey(funcs[i]->tokenHash, config);
+                cached[i] = cache->lookup(keys[i], asmParts[i], cachedCallees[i]);
+            }
+        }
+
+        // 未命中的函数作为独立任务生成中间代码（临时变量、标签按函数独立编号）
+        // 并紧接着执行函数级优化遍
+        PassManager pm(options.passes, options.passStats);
+        vector<vector<Quad>> funcCodes(n);
+        vector<string> names(n);
+        map<string, int> arity;
+        for (int i = 0; i < n; ++i) {
+            names[i] = funcs[i]->funcName;
+            arity[names[i]] = (int)funcs[i]->args.size();
+        }
+        // 调用在优化之前检查（纯函数的调用可能被删除）
+        vector<string> callErrors(n);
+        auto lower = [&](int i) {
+            if (cached[i]) return;
+            {
+                INSTR_SCOPE_DETAIL("lower", names[i]);
+                InterCodeGenerator interGen;
+                interGen.generateFunction(funcs[i]);
+                funcCodes[i] = interGen.getCodes();
+            }
+            callErrors[i] = checkCalls(funcCodes[i], arity);
+            if (callErrors[i].empty()) pm.runFunctionPasses(funcCodes[i]);
+        };
+        if (pool) pool->parallelFor(n, lower);
+        else for (int i = 0; i < n; ++i) lower(i);
+
+        // 此后不再需要语法树
+        {
+            INSTR_SCOPE("freeAST");
+            freeAST(root);
+        }
+        for (auto& e : callErrors) {
+            if (e.empty()) continue;
+            result.diagnostics.push_back({Diagnostic::ERROR, 0, 0, e});
+            result.log = log.str();
+            return result;
+        }
+
+        if (options.dumpIR) {
+            // 函数级遍在并行生成中间代码时紧接着执行，此时输出的已经是优化后的结果
+            log << (pm.hasFunctionPasses() ? "\nIntermediate Code after function passes:" : "\nGenerated Intermediate Code:")
+                << '\n';
+            log << "==============================" << '\n';
+            for (int i = 0; i < n; ++i) {
+                if (cached[i]) log << "; " << names[i] << ": cached" << '\n';
+                else printQuads(funcCodes[i], log);
+            }
+        }
+
+        // 每一项是一个需要生成汇编的函数及其结果存放位置
+        vector<pair<const vector<Quad>*, string*>> work;
+        vector<vector<Quad>> parts;
+        vector<int> emitted; // 输出到文件的函数（下标对应 asmParts）
+        CallGraph callGraph;
+
+        if (!cache) {
+            // 调用图分析：过程间常量传播 + 删除不可达函数（需要整个程序，串行执行）
+            vector<Quad> codes;
+            for (auto& fc : funcCodes) codes.insert(codes.end(), fc.begin(), fc.end());
+            funcCodes.clear();
+            int changes = pm.runModulePasses(codes, callGraph);
+            if (options.dumpIR) {
+                log << "\nCall Graph (" << changes << " changes):" << '\n';
+                log << "==============================" << '\n';
+                callGraph.print(log);
+            }
+
+            // 调用图传播的常量返回值可以继续折叠，再对每个函数执行一轮函数级遍
+            if (pm.hasModulePasses() && pm.hasFunctionPasses()) {
+                parts = splitFunctions(codes);
+                auto late = [&](int i) { pm.runFunctionPasses(parts[i]); };
+                if (pool) pool->parallelFor((int)parts.size(), late);
+                else for (int i = 0; i < (int)parts.size(); ++i) late(i);
+                codes.clear();
+                for (auto& part : parts) codes.insert(codes.end(), part.begin(), part.end());
+                if (options.dumpIR) {
+                    log << "\nOptimized Intermediate Code:" << '\n';
+                    log << "==============================" << '\n';
+                    printQuads(codes, log);
+                }
+            }
+            warnUnconverged(pm, result);
+
+            if (options.interpret || !options.profileGenerate.empty()) {
+                INSTR_SCOPE("interp");
+                IRInterpreter interp;
+                string error;
+                if (!interp.load(codes, error) || !interp.run(error)) {
+                    result.diagnostics.push_back({Diagnostic::ERROR, 0, 0, "interpreter: " + error});
+                    result.log = log.str();
+                    return result;
+                }
+                if (!options.profileGenerate.empty()) collectProfile(codes, interp, result.profile);
+                if (options.interpret) {
+                    log << "\nIR Interpreter:" << '\n';
+                    log << "==============================" << '\n';
+                    interp.printReport(log);
+                    result.interpreted = true;
+                    result.interpReturned = interp.hasReturned();
+                    result.interpResult = interp.result();
+                }
+            }
+
+            if (options.emitIR || !options.emitAsm) {
+                if (options.emitIR) result.ir = move(codes);
+                result.success = true;
+                result.log = log.str();
+                return result;
+            }
+
+            if (parts.empty()) parts = splitFunctions(codes);
+            asmParts.assign(parts.size(), "");
+            for (size_t i = 0; i < parts.size(); ++i) {
+                work.push_back({&parts[i], &asmParts[i]});
+                emitted.push_back((int)i);
+            }
+        } else {
+            // 缓存模式：命中的函数没有中间代码，用缓存中记录的调用关系构造调用图
+            // 过程间常量传播会让调用者依赖被调函数的内容，因此此模式下只删除不可达函数
+            warnUnconverged(pm, result);
+            vector<Quad> graph;
+            for (int i = 0; i < n; ++i) {
+                if (!cached[i]) {
+                    graph.insert(graph.end(), funcCodes[i].begin(), funcCodes[i].end());
+                    continue;
+                }
+                graph.emplace_back(OP_FUNC_BEGIN, "", "", names[i]);
+                for (auto& c : cachedCallees[i]) graph.emplace_back(OP_CALL, c, "0", "");
+                graph.emplace_back(OP_FUNC_END, "", "", names[i]);
+            }
+            callGraph.build(graph);
+            if (options.dumpIR) {
+                log << "\nCall Graph:" << '\n';
+                log << "==============================" << '\n';
+                callGraph.print(log);
+            }
+
+            for (int i = 0; i < n; ++i) {
+                if (pm.hasModulePasses() && !callGraph.getInfo(names[i]).reachable) continue;
+                emitted.push_back(i);
+                if (!cached[i]) work.push_back({&funcCodes[i], &asmParts[i]});
+            }
+        }
+
+        // 生成汇编代码（--run 时为 x86-64 机器码，--format=elf / bin 时为 MIPS 机器码）：每个函数独立生成，再按顺序拼接
+        // 有匹配的计数时先重排基本块，寄存器分配按变量的热度选择换出对象
+        vector<char> stale(work.size(), 0);
+        vector<JitFunction> jitParts(options.run ? work.size() : 0);
+        vector<MipsFunction> mipsParts(options.format != FORMAT_ASM ? work.size() : 0);
+        auto codegen = [&](int i) {
+            const vector<Quad>* codes = work[i].first;
+            INSTR_SCOPE_DETAIL("codegen", codes->empty() ? "" : codes->front().result);
+            vector<Quad> laidOut;
+            map<string, long long> weights;
+            const FunctionProfile* fp = nullptr;
+            if (options.profileUse && !codes->empty()) {
+                const string& name = codes->front().result;
+                fp = options.profileUse->find(name, hashFunction(*codes));
+                stale[i] = !fp && options.profileUse->hasName(name);
+            }
+            if (fp) {
+                laidOut = *codes;
+                layoutFunction(laidOut, *fp, weights);
+                codes = &laidOut;
+            }
+            if (options.run) {
+                jitParts[i] = jitCompile(*codes, fp ? &weights : nullptr);
+                return;
+            }
+            if (options.format != FORMAT_ASM) {
+                mipsParts[i] = mipsEncode(*codes, fp ? &weights : nullptr);
+                return;
+            }
+            AsmBuffer part;
+            AsmGenerator asmGen(*codes);
+            if (fp) asmGen.setVarWeights(&weights);
+            asmGen.generateBody(part);
+            *work[i].second = part.take();
+        };
+        if (pool) pool->parallelFor((int)work.size(), codegen);
+        else for (int i = 0; i < (int)work.size(); ++i) codegen(i);
+
+        int staleCount = 0;
+        string staleFirst;
+        for (size_t i = 0; i < work.size(); ++i) {
+            if (!stale[i]) continue;
+            if (staleCount++ == 0) staleFirst = work[i].first->front().result;
+        }
+        if (staleCount > 0) {
+            string message = "profile is out of date for '" + staleFirst + "'";
+            if (staleCount > 1) message += " and " + to_string(staleCount - 1) + " other function(s), their counts were ignored";
+            else message += ", its counts were ignored";
+            result.diagnostics.push_back({Diagnostic::WARNING, 0, 0, message});
+        }
+
+        // 链接机器码并直接执行，不输出汇编
+        if (options.run) {
+            INSTR_SCOPE("run");
+            X86JIT jit;
+            string error;
+            if (!jit.link(jitParts, error) || !jit.run(error)) {
+                result.diagnostics.push_back({Diagnostic::ERROR, 0, 0, "jit: " + error});
+                result.log = log.str();
+                return result;
+            }
+            log << "\nx86-64 JIT:" << '\n';
+            log << "==============================" << '\n';
+            jit.printReport(log);
+            result.ran = true;
+            result.runReturned = jit.hasReturned();
+            result.runResult = jit.result();
+            result.success = true;
+            result.log = log.str();
+            return result;
+        }
+
+        // 解析标签、松弛分支，由驱动程序按格式写出
+        if (options.format != FORMAT_ASM) {
+            INSTR_SCOPE("link");
+            string error;
+            if (!mipsLink(mipsParts, result.object, error)) {
+                result.diagnostics.push_back({Diagnostic::ERROR, 0, 0, "link: " + error});
+                result.log = log.str();
+                return result;
+            }
+            result.success = true;
+            result.log = log.str();
+            return result;
+        }
+
+        // 新生成的函数写入缓存
+        if (cache) {
+            for (int i = 0; i < n; ++i) {
+                if (cached[i] || funcCodes[i].empty()) continue;
+                if (pm.hasModulePasses() && !callGraph.getInfo(names[i]).reachable) continue;
+                const set<string>& callees = callGraph.getInfo(names[i]).callees;
+                cache->store(keys[i], asmParts[i], vector<string>(callees.begin(), callees.end()));
+            }
+        }
+
+        // 拼接到一块预留好大小的缓冲区中，由调用者一次写出
+        size_t total = 0;
+        for (int i : emitted) total += asmParts[i].size();
+        AsmBuffer out;
+        out.reserve(total + 128);
+        vector<string> emittedNames;
+        for (int i : emitted) emittedNames.push_back(cache ? names[i] : parts[i].front().result);
+        AsmGenerator::emitHeader(out);
+        for (int i : emitted) out << asmParts[i];
+        AsmGenerator::emitFooter(out, entryFunction(emittedNames));
+        result.assembly = out.take();
+        result.success = true;
+    } catch (const SyntaxError& e) {
+        result.diagnostics.push_back({Diagnostic::ERROR, e.line, e.column, e.what()});
+    } catch (const exception& e) {
+        result.diagnostics.push_back({Diagnostic::ERROR, 0, 0, string("internal error: ") + e.what()});
+    }
+
+    result.log = log.str();
+    return result;
+}
@@ -0,0 +1,373 @@
+#include "driver.h"
+#include "lexer.h"
+#include "myparser.h"
+#include "intercode.h"
+#include "asmgen.h"
+#include "cache.h"
+#include "irfile.h"
+#include "mipssim.h"
+#include "interp.h"
+#include "instrument.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
+
+/**
+ * 在 MIPS 模拟器上运行生成的汇编或机器码（object 不为空时），报告写入 log
+ * 汇编或执行失败（越界访问、超过步数上限）作为错误写入 diag
+ * expected 不为空时（同时使用了 --interp）与解释器的结果对比，不一致说明后端有错
+ */
+static bool simulate(const string& assembly, const string& name, ostream& log, ostream& diag,
+                     const int* expected = nullptr, const MipsObject* object = nullptr) {
+    INSTR_SCOPE("simulate");
+    MipsSimulator sim;
+    string error;
+    bool loaded = object ? sim.load(object->text, error) : sim.assemble(assembly, error);
+    if (!loaded || !sim.run(error)) {
+        diag << name << ": simulation error: " << error << endl;
+        return false;
+    }
+    log << "\nSimulation of " << name << ":" << endl;
+    log << "==============================" << endl;
+    sim.printReport(log);
+    if (expected && *expected != sim.result()) {
+        diag << name << ": error: simulator returned " << sim.result() << " but the IR interpreter returned "
+             << *expected << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 用解释器执行中间代码，报告写入 log
+ */
+static bool interpret(const vector<Quad>& codes, const string& name, ostream& log, ostream& diag,
+                      IRInterpreter& interp) {
+    INSTR_SCOPE("interp");
+    string error;
+    if (!interp.load(codes, error) || !interp.run(error)) {
+        diag << name << ": interpreter error: " << error << endl;
+        return false;
+    }
+    log << "\nIR Interpreter:" << endl;
+    log << "==============================" << endl;
+    interp.printReport(log);
+    return true;
+}
+
+/**
+ * 流式编译：边读边解析，每个函数在右花括号之后立即生成中间代码和汇编并写出
+ * 源文件按块读取，语法树和四元式在函数写出后立即释放
+ */
+static CompileResult compileStreaming(const CompileJob& job, const CompileOptions& options) {
+    INSTR_SCOPE("compile");
+    CompileResult result;
+    ostringstream log, diag;
+
+    ifstream file(job.input);
+    if (!file.is_open()) {
+        diag << "Error: Cannot open file '" << job.input << "'" << endl;
+        result.diagnostics = diag.str();
+        return result;
+    }
+
+    if (!options.quiet) {
+        log << "Source File: " << job.input << endl;
+        log << "Streaming Source Code..." << endl;
+    }
+
+    // 汇编先积累在缓冲区中，超过一定大小再整块写出，内存仍然有上界
+    // 写到临时文件，全部成功后才改名为输出文件：中途出错不留下截断的汇编，空文件不创建输出
+    const size_t flushSize = 1 << 20;
+    const string tmpPath = job.output + ".tmp" + to_string(getpid());
+    ofstream out(tmpPath, ios::binary);
+    if (!out.is_open()) {
+        diag << "Error: Cannot write file '" << job.output << "'" << endl;
+        result.diagnostics = diag.str();
+        return result;
+    }
+    AsmBuffer buf;
+    auto flush = [&] {
+        out.write(buf.str().data(), buf.size());
+        buf.clear();
+    };
+    int funcCount = 0;
+    try {
+        Lexer lexer(file);
+        Parser parser(lexer);
+
+        AsmGenerator::emitHeader(buf);
+        string config = cacheConfig(options);
+        // 流式编译没有整个程序，只执行函数级遍
+        PassManager pm(options.passes, options.passStats);
+        // 被调函数可能在后面才定义，调用在全部函数读完之后统一检查
+        vector<string> names;
+        map<string, int> arity;
+        vector<Quad> calls; // 每个函数的 FUNC_BEGIN 及其中的 CALL
+        while (FuncDef* func = parser.parseNextFunction()) {
+            funcCount++;
+            names.push_back(func->funcName);
+            arity[func->funcName] = (int)func->args.size();
+            CacheKey key;
+            if (options.cache) {
+                string text;
+                vector<string> callees;
+                key = CompileCache::makeKey(func->tokenHash, config);
+                if (options.cache->lookup(key, text, callees)) {
+                    freeAST(func);
+                    buf << text;
+                    if (buf.size() >= flushSize) flush();
+                    continue;
+                }
+            }
+
+            vector<Quad> codes;
+            {
+                INSTR_SCOPE_DETAIL("lower", func->funcName);
+                InterCodeGenerator interGen;
+                interGen.generateFunction(func);
+                freeAST(func);
+                codes = interGen.getCodes();
+            }
+            calls.push_back(codes.front());
+            for (auto& q : codes) {
+                if (q.op == OP_CALL) calls.push_back(q);
+            }
+            pm.runFunctionPasses(codes);
+
+            size_t start = buf.size();
+            {
+                INSTR_SCOPE_DETAIL("codegen", codes.front().result);
+                AsmGenerator asmGen(codes);
+                asmGen.generateBody(buf);
+            }
+
+            if (options.cache) {
+                vector<string> callees;
+                for (auto& q : codes) {
+                    if (q.op == OP_CALL) callees.push_back(q.arg1);
+                }
+                options.cache->store(key, buf.str().substr(start), callees);
+            }
+            if (buf.size() >= flushSize) flush();
+        }
+        string callError;
+        for (auto& func : splitFunctions(calls)) {
+            callError = checkCalls(func, arity);
+            if (!callError.empty()) break;
+        }
+        AsmGenerator::emitFooter(buf, entryFunction(names));
+        flush();
+        if (int unconverged = pm.unconvergedRuns()) {
+            diag << formatDiagnostic({Diagnostic::WARNING, 0, 0,
+                                      "function passes stopped after " + to_string(OS_MAX_ROUNDS) +
+                                          " rounds without reaching a fixpoint (" + to_string(unconverged) +
+                                          " time(s))"},
+                                     job.input)
+                 << endl;
+        }
+
+        if (!callError.empty()) {
+            diag << formatDiagnostic({Diagnostic::ERROR, 0, 0, callError}, job.input) << endl;
+        } else if (funcCount == 0) {
+            diag << "Warning: File is empty" << endl;
+        } else {
+            if (!options.quiet) {
+                log << "Functions compiled: " << funcCount << endl;
+                log << "Compilation completed successfully!" << endl;
+            }
+            result.success = true;
+        }
+    } catch (const SyntaxError& e) {
+        diag << formatDiagnostic({Diagnostic::ERROR, e.line, e.column, e.what()}, job.input) << endl;
+    } catch (const exception& e) {
+        diag << formatDiagnostic({Diagnostic::ERROR, 0, 0, string("internal error: ") + e.what()}, job.input) << endl;
+    }
+    out.close();
+    if (result.success && (!out || rename(tmpPath.c_str(), job.output.c_str()) != 0)) {
+        diag << "Error: Cannot write file '" << job.output << "'" << endl;
+        result.success = false;
+    }
+    if (!result.success) remove(tmpPath.c_str());
+
+    // 流式编译不在内存中保留汇编，模拟时从输出文件读回
+    if (result.success && options.simulate) {
+        ifstream in(job.output, ios::binary);
+        stringstream text;
+        text << in.rdbuf();
+        result.success = simulate(text.str(), job.output, log, diag);
+    }
+
+    result.log = log.str();
+    result.diagnostics = diag.str();
+    return result;
+}
+
+/**
+ * 后端编译：直接从 mmap 映射的中间代码文件生成汇编，不做词法、语法分析
+ * 中间代码在前端已经过调用图优化，这里逐函数独立生成汇编
+ */
+static CompileResult compileFromIR(const CompileJob& job, const CompileOptions& options, ThreadPool* pool) {
+    INSTR_SCOPE("compile");
+    CompileResult result;
+    ostringstream log, diag;
+
+    IRFile ir;
+    string error;
+    if (!ir.open(job.input, error)) {
+        diag << "Error: " << error << endl;
+        result.diagnostics = diag.str();
+        return result;
+    }
+
+    int n = ir.functionCount();
+    if (!options.quiet) log << "IR File: " << job.input << " (" << n << " functions)" << endl;
+
+    IRInterpreter interp;
+    if (options.interpret && !interpret(ir.allQuads(), job.input, log, diag, interp)) {
+        result.log = log.str();
+        result.diagnostics = diag.str();
+        return result;
+    }
+
+    vector<string> asmParts(n);
+    auto codegen = [&](int i) {
+        vector<Quad> codes = ir.functionQuads(i);
+        INSTR_SCOPE_DETAIL("codegen", ir.functionName(i));
+        AsmBuffer part;
+        AsmGenerator asmGen(codes);
+        asmGen.generateBody(part);
+        asmParts[i] = part.take();
+    };
+    try {
+        if (pool) pool->parallelFor(n, codegen);
+        else for (int i = 0; i < n; ++i) codegen(i);
+    } catch (const exception& e) {
+        diag << formatDiagnostic({Diagnostic::ERROR, 0, 0, string("internal error: ") + e.what()}, job.input) << endl;
+        result.diagnostics = diag.str();
+        return result;
+    }
+
+    vector<string> names;
+    for (int i = 0; i < n; ++i) names.push_back(ir.functionName(i));
+    AsmBuffer out;
+    AsmGenerator::emitHeader(out);
+    for (auto& part : asmParts) out << part;
+    AsmGenerator::emitFooter(out, entryFunction(names));
+    if (!out.writeFile(job.output)) {
+        diag << "Error: Cannot write file '" << job.output << "'" << endl;
+        result.diagnostics = diag.str();
+        return result;
+    }
+
+    if (!options.quiet) log << "Compilation completed successfully!" << endl;
+    int expected = interp.result();
+    bool compare = options.interpret && interp.hasReturned();
+    result.success = options.simulate ? simulate(out.str(), job.output, log, diag, compare ? &expected : nullptr)
+                                      : true;
+    result.log = log.str();
+    result.diagnostics = diag.str();
+    return result;
+}
+
+/**
+ * 编译单个源文件：读取 -> 词法/语法分析 -> 中间代码 -> 调用图优化 -> 汇编
+ * 不向全局的 cout/cerr 写任何内容，可以安全地在多个线程中并发调用
+ */
+CompileResult compileFile(const CompileJob& job, const CompileOptions& options, ThreadPool* pool) {
+    if (options.fromIR) return compileFromIR(job, options, pool);
+    if (options.stream) return compileStreaming(job, options);
+
+    CompileResult result;
+    ostringstream log, diag;
+
+    // 读取源代码文件
+    ifstream file(job.input);
+    if (!file.is_open()) {
+        diag << "Error: Cannot open file '" << job.input << "'" << endl;
+        result.diagnostics = diag.str();
+        return result;
+    }
+
+    string code;
+    {
+        INSTR_SCOPE("read");
+        stringstream buffer;
+        buffer << file.rdbuf();
+        code = buffer.str();
+        file.close();
+    }
+
+    if (code.empty()) {
+        diag << "Warning: File is empty" << endl;
+        result.diagnostics = diag.str();
+        return result;
+    }
+
+    if (!options.quiet) {
+        log << "Source File: " << job.input << endl;
+        log << "Parsing Source Code..." << endl;
+    }
+
+    CompileOutput output = compileSource(code, options, pool);
+    log << output.log;
+    for (auto& dg : output.diagnostics) diag << formatDiagnostic(dg, job.input) << endl;
+
+    if (output.success) {
+        if (options.emitIR) {
+            if (!writeIRFile(job.output, output.ir)) {
+                diag << "Error: Cannot write IR file '" << job.output << "'" << endl;
+            } else {
+                if (!options.quiet) log << "IR written to " << job.output << endl;
+                result.success = true;
+            }
+        } else if (!options.emitAsm) {
+            // 只要求调试输出，不写汇编文件
+            result.success = true;
+        } else if (options.run) {
+            // JIT 直接执行，不写汇编文件；同时使用了 --interp 时对比结果
+            result.success = true;
+            if (output.interpreted && output.interpReturned && output.runResult != output.interpResult) {
+                diag << job.input << ": error: JIT returned " << output.runResult
+                     << " but the IR interpreter returned " << output.interpResult << endl;
+                result.success = false;
+            }
+        } else {
+            // 整个汇编文本（或目标文件）一次写出
+            INSTR_SCOPE("write");
+            bool binary = options.format != FORMAT_ASM;
+            const string& data = options.format == FORMAT_ELF   ? mipsElfObject(output.object)
+                                 : options.format == FORMAT_BIN ? mipsRawImage(output.object)
+                                                                : output.assembly;
+            ofstream out(job.output, ios::binary);
+            out.write(data.data(), data.size());
+            if (!out) {
+                diag << "Error: Cannot write file '" << job.output << "'" << endl;
+            } else {
+                if (!options.quiet) log << "Compilation completed successfully!" << endl;
+                if (!options.profileGenerate.empty()) {
+                    if (!output.profile.save(options.profileGenerate)) {
+                        diag << "Error: Cannot write profile '" << options.profileGenerate << "'" << endl;
+                        result.log = log.str();
+                        result.diagnostics = diag.str();
+                        return result;
+                    }
+                    if (!options.quiet) log << "Profile written to " << options.profileGenerate << endl;
+                }
+                bool compare = output.interpreted && output.interpReturned;
+                if (binary && !options.quiet && output.object.relaxedBranches > 0) {
+                    log << "Relaxed " << output.object.relaxedBranches << " out-of-range branches" << endl;
+                }
+                result.success = options.simulate ? simulate(output.assembly, job.output, log, diag,
+                                                             compare ? &output.interpResult : nullptr,
+                                                             binary ? &output.object : nullptr)
+                                                  : true;
+            }
+        }
+    }
+
+    result.log = log.str();
+    result.diagnostics = diag.str();
+    return result;
+}
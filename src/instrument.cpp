@@ -0,0 +1,263 @@
+#include "instrument.h"
+
+#ifndef COMPILER_INSTRUMENT
+
+bool instrumentEnabled() {
+    return false;
+}
+
+void instrPrintReport(ostream& out) {
+    out << "Instrumentation is not compiled in, rebuild with 'make INSTRUMENT=1'" << '\n';
+}
+
+bool instrWriteTrace(const string&) {
+    return false;
+}
+
+#else
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static const char* COUNTER_NAMES[CNT_COUNT] = {
+    "tokens lexed", "AST nodes built", "quads emitted", "registers spilled",
+    "spillAll flushes", "loads emitted", "stores emitted", "allocations", "bytes allocated"
+};
+
+static atomic<long long> counters[CNT_COUNT];
+
+// 每个线程自己的分配计数，作用域内的分配数不受其他线程影响
+static thread_local long long threadAllocs = 0;
+static thread_local long long threadAllocBytes = 0;
+
+// 一次阶段（作用域）的记录，时间单位为微秒，从进程启动开始计
+struct InstrEvent {
+    const char* phase;
+    string detail;
+    double start;
+    double wall;
+    double cpu;
+    long long allocs;
+    long long bytes;
+    long peakKB;
+    int tid;
+};
+
+static mutex eventLock;
+static vector<InstrEvent> events;
+static atomic<int> nextTid(0);
+static thread_local int threadId = -1;
+
+static double wallMicros() {
+    static const auto origin = chrono::steady_clock::now();
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - origin).count();
+}
+
+// 当前线程的 CPU 时间
+static double cpuMicros() {
+#ifndef _WIN32
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#else
+    return (double)clock() * 1e6 / CLOCKS_PER_SEC;
+#endif
+}
+
+// 进程的峰值常驻内存（KB），进程级别的最大值
+static long peakRSS() {
+#ifndef _WIN32
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+void* operator new(size_t n) {
+    counters[CNT_ALLOCS].fetch_add(1, memory_order_relaxed);
+    counters[CNT_ALLOC_BYTES].fetch_add((long long)n, memory_order_relaxed);
+    threadAllocs++;
+    threadAllocBytes += (long long)n;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t n) {
+    return operator new(n);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+bool instrumentEnabled() {
+    return true;
+}
+
+void instrCount(InstrCounter counter, long long n) {
+    counters[counter].fetch_add(n, memory_order_relaxed);
+}
+
+InstrScope::InstrScope(const char* phase, const string& detail)
+    : phase(phase), detail(detail), startAllocs(threadAllocs), startBytes(threadAllocBytes) {
+    startWall = wallMicros();
+    startCpu = cpuMicros();
+}
+
+InstrScope::~InstrScope() {
+    InstrEvent e;
+    e.wall = wallMicros() - startWall;
+    e.cpu = cpuMicros() - startCpu;
+    e.allocs = threadAllocs - startAllocs;
+    e.bytes = threadAllocBytes - startBytes;
+    e.phase = phase;
+    e.detail = move(detail);
+    e.start = startWall;
+    e.peakKB = peakRSS();
+    if (threadId < 0) threadId = nextTid++;
+    e.tid = threadId;
+
+    lock_guard<mutex> guard(eventLock);
+    events.push_back(move(e));
+}
+
+/**
+ * 输出 -ftime-report 风格的报告
+ * 按阶段汇总；嵌套的阶段分别统计（例如 codegen 包含在 compile 中），因此百分比之和可能超过 100%
+ */
+void instrPrintReport(ostream& out) {
+    lock_guard<mutex> guard(eventLock);
+
+    struct PhaseTotal {
+        long long calls = 0;
+        double wall = 0, cpu = 0;
+        long long allocs = 0, bytes = 0;
+        long peakKB = 0;
+        double firstStart = -1;
+    };
+    map<string, PhaseTotal> phases;
+    double begin = 0, end = 0;
+    for (auto& e : events) {
+        PhaseTotal& p = phases[e.phase];
+        p.calls++;
+        p.wall += e.wall;
+        p.cpu += e.cpu;
+        p.allocs += e.allocs;
+        p.bytes += e.bytes;
+        p.peakKB = max(p.peakKB, e.peakKB);
+        if (p.firstStart < 0 || e.start < p.firstStart) p.firstStart = e.start;
+        if (begin == end || e.start < begin) begin = e.start;
+        end = max(end, e.start + e.wall);
+    }
+    double total = end - begin;
+
+    // 按第一次出现的时间排序，接近流水线的顺序
+    vector<pair<string, PhaseTotal>> ordered(phases.begin(), phases.end());
+    sort(ordered.begin(), ordered.end(), [](const pair<string, PhaseTotal>& a, const pair<string, PhaseTotal>& b) {
+        return a.second.firstStart < b.second.firstStart;
+    });
+
+    char line[256];
+    out << "\nTime report (wall " << (long long)(total / 1000) << " ms):" << '\n';
+    snprintf(line, sizeof(line), "  %-12s %8s %11s %11s %7s %11s %11s %9s\n",
+             "phase", "calls", "wall ms", "cpu ms", "wall %", "allocs", "alloc KB", "peak MB");
+    out << line;
+    for (auto& it : ordered) {
+        const PhaseTotal& p = it.second;
+        snprintf(line, sizeof(line), "  %-12s %8lld %11.2f %11.2f %6.1f%% %11lld %11lld %9.1f\n",
+                 it.first.c_str(), p.calls, p.wall / 1000, p.cpu / 1000,
+                 total > 0 ? 100 * p.wall / total : 0.0, p.allocs, p.bytes / 1024, p.peakKB / 1024.0);
+        out << line;
+    }
+
+    out << "Counters:" << '\n';
+    for (int i = 0; i < CNT_COUNT; ++i) {
+        snprintf(line, sizeof(line), "  %-18s %14lld\n", COUNTER_NAMES[i], counters[i].load());
+        out << line;
+    }
+
+    // 最慢的函数（带 detail 的记录）
+    vector<const InstrEvent*> funcs;
+    for (auto& e : events) {
+        if (!e.detail.empty()) funcs.push_back(&e);
+    }
+    size_t top = min<size_t>(10, funcs.size());
+    partial_sort(funcs.begin(), funcs.begin() + top, funcs.end(), [](const InstrEvent* a, const InstrEvent* b) {
+        return a->wall > b->wall;
+    });
+    if (top > 0) out << "Slowest functions:" << '\n';
+    for (size_t i = 0; i < top; ++i) {
+        snprintf(line, sizeof(line), "  %-12s %11.3f ms %9lld allocs  ", funcs[i]->phase, funcs[i]->wall / 1000,
+                 funcs[i]->allocs);
+        out << line << funcs[i]->detail << '\n';
+    }
+}
+
+static string jsonEscape(const string& s) {
+    string r;
+    for (char c : s) {
+        if (c == '"' || c == '\\') r += '\\';
+        if ((unsigned char)c < 0x20) continue;
+        r += c;
+    }
+    return r;
+}
+
+/**
+ * Chrome trace：每个阶段是一个完整事件（ph "X"），计数器的最终值作为一个计数事件（ph "C"）
+ */
+bool instrWriteTrace(const string& path) {
+    lock_guard<mutex> guard(eventLock);
+    ofstream out(path, ios::binary);
+    if (!out) return false;
+
+    out << "{\"traceEvents\": [\n";
+    char buf[256];
+    double last = 0;
+    for (auto& e : events) {
+        string name = e.detail.empty() ? e.phase : string(e.phase) + " " + e.detail;
+        snprintf(buf, sizeof(buf), "\"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, ",
+                 e.tid, e.start, e.wall);
+        out << "{\"name\": \"" << jsonEscape(name) << "\", \"cat\": \"" << e.phase << "\", " << buf;
+        snprintf(buf, sizeof(buf), "\"args\": {\"cpu_us\": %.3f, \"allocs\": %lld, \"alloc_bytes\": %lld, \"peak_rss_kb\": %ld}},\n",
+                 e.cpu, e.allocs, e.bytes, e.peakKB);
+        out << buf;
+        last = max(last, e.start + e.wall);
+    }
+    snprintf(buf, sizeof(buf), "{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"ts\": %.3f, \"args\": {", last);
+    out << buf;
+    for (int i = 0; i < CNT_COUNT; ++i) {
+        out << (i ? ", " : "") << "\"" << COUNTER_NAMES[i] << "\": " << counters[i].load();
+    }
+    out << "}}\n]}\n";
+    return (bool)out;
+}
+
+#endif
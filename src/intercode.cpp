@@ -1,5 +1,7 @@
 #include "intercode.h"
+#include "instrument.h"
 #include <string>
+#include <algorithm>
 
 InterCodeGenerator::InterCodeGenerator() {
     tempCount = 0;
@@ -7,19 +9,40 @@ InterCodeGenerator::InterCodeGenerator() {
 }
 
 /**
- * 生成一个新的临时变量名，如 t0, t1, t2...
+ * 生成一个新的临时变量名，如 .t0, .t1, .t2...
  * 用于存储表达式计算的中间结果
+ * 以 '.' 开头：源程序的标识符不含 '.'，临时变量不会与用户变量重名
+ * 已经死亡的临时变量会被优先复用，以限制同时存活的临时变量数量
  */
 string InterCodeGenerator::newTemp() {
-    return "t" + to_string(tempCount++);
+    string name;
+    if (!freeTemps.empty()) {
+        name = freeTemps.back();
+        freeTemps.pop_back();
+    } else {
+        name = ".t" + to_string(tempCount++);
+    }
+    liveTemps.insert(name);
+    return name;
+}
+
+/**
+ * 释放临时变量：临时变量只会被使用一次，使用后即可复用
+ * 只回收 newTemp 分配且尚未释放的名字，用户变量和立即数不在其中，传入它们不产生任何效果
+ */
+void InterCodeGenerator::releaseTemp(const string& name) {
+    if (liveTemps.erase(name)) freeTemps.push_back(name);
 }
 
 /**
- * 生成一个新的逻辑标签名，如 L0, L1, L2...
+ * 生成一个新的逻辑标签名，如 main.L0, main.L1...
  * 用于控制流跳转（if, while）
+ * 标签以函数名为前缀，各函数可以独立生成而不会在汇编中重名
+ * （源程序的标识符不含 '.'，不会与函数名冲突）
  */
 string InterCodeGenerator::newLabel() {
-    return "L" + to_string(labelCount++);
+    string label = "L" + to_string(labelCount++);
+    return currentFunc.empty() ? label : currentFunc + "." + label;
 }
 
 /**
@@ -31,6 +54,7 @@ string InterCodeGenerator::newLabel() {
  */
 void InterCodeGenerator::emit(QuadOp op, string arg1, string arg2, string result) {
     codes.emplace_back(op, arg1, arg2, result);
+    INSTR_COUNT(CNT_QUADS, 1);
 }
 
 /**
@@ -40,156 +64,314 @@ const vector<Quad>& InterCodeGenerator::getCodes() const {
     return codes;
 }
 
+/**
+ * 计算 Sethi-Ullman 标号（Ershov 数）
+ * 叶子结点需要 1 个寄存器；二元结点左右需求相同时为 need+1，否则取较大者
+ * 调用按顺序求值实参，第 k 个实参求值时前 k 个的结果仍然存活，需求为各实参 need + k 的最大值
+ * 使用显式栈做后序遍历，避免深层表达式耗尽调用栈
+ */
+int InterCodeGenerator::labelExpr(ExprNode* node) {
+    if (!node) return 0;
+
+    vector<ExprNode*> stack = {node};
+    while (!stack.empty()) {
+        ExprNode* cur = stack.back();
+        if (cur->need > 0) { stack.pop_back(); continue; }
+
+        if (cur->nodeType == NODE_CALL_EXPR) {
+            CallExpr* call = (CallExpr*)cur;
+            bool ready = true;
+            for (ExprNode* arg : call->args) {
+                if (arg->need == 0) { stack.push_back(arg); ready = false; }
+            }
+            if (!ready) continue;
+            int need = 1;
+            for (size_t k = 0; k < call->args.size(); ++k) need = max(need, call->args[k]->need + (int)k);
+            cur->need = need;
+            stack.pop_back();
+            continue;
+        }
+        if (cur->nodeType != NODE_BINARY_EXPR) {
+            cur->need = 1;
+            stack.pop_back();
+            continue;
+        }
+
+        BinaryExpr* bin = (BinaryExpr*)cur;
+        if (bin->left->need == 0) { stack.push_back(bin->left); continue; }
+        if (bin->right->need == 0) { stack.push_back(bin->right); continue; }
+
+        int l = bin->left->need;
+        int r = bin->right->need;
+        cur->need = (l == r) ? l + 1 : max(l, r);
+        stack.pop_back();
+    }
+    return node->need;
+}
+
 /**
  * 生成表达式的中间代码
  * 处理算术运算，并返回存储该结果的变量名（或数字字符串）
  * 例如：a + b * c 会生成：
- * MUL b, c, t0
- * ADD a, t0, t1
- * 并返回 "t1"
+ * MUL b, c, .t0
+ * ADD a, .t0, .t0
+ * 并返回 ".t0"
+ *
+ * 按 Sethi-Ullman 标号先计算需求更大的子树，并在操作数被使用后立即释放临时变量，
+ * 使同时存活的临时变量数量最少（表达式没有副作用，求值顺序可以自由调整；
+ * 被调函数也无法修改调用者的变量）
+ * 调用先求出全部实参，再连续输出 PARAM 和 CALL，嵌套调用的 PARAM 不会与外层的交错：
+ * f(x, g(y)) 为 PARAM y; CALL g 1 .t0; PARAM x; PARAM .t0; CALL f 2 .t1
+ * 遍历使用显式栈：frames 保存待完成的二元结点和调用，values 保存已求出的操作数
  */
 string InterCodeGenerator::genExpr(ExprNode* node) {
     if (!node) return "";
-    
-    // 情况1：数字节点，直接返回数值字符串
-    if (node->nodeType == NODE_NUMBER) {
-        return to_string(((NumberNode*)node)->value);
-    } 
-    // 情况2：标识符节点，返回变量名
-    else if (node->nodeType == NODE_IDENTIFIER) {
-        return ((IdNode*)node)->name;
-    } 
-    // 情况3：二元表达式（+ - * /）
-    else if (node->nodeType == NODE_BINARY_EXPR) {
-        BinaryExpr* bin = (BinaryExpr*)node;
-        
-        // 递归计算左右子树
-        string t1 = genExpr(bin->left);
-        string t2 = genExpr(bin->right);
-        
-        // 分配一个临时变量来存储运算结果
-        string res = newTemp();
-        
-        // 映射操作符
-        QuadOp op = OP_ADD;
-        if (bin->op == "+") op = OP_ADD;
-        else if (bin->op == "-") op = OP_SUB;
-        else if (bin->op == "*") op = OP_MUL;
-        else if (bin->op == "/") op = OP_DIV;
-        
-        // 生成四元式：res = t1 op t2
-        emit(op, t1, t2, res);
-        return res;
+    labelExpr(node);
+
+    struct Frame {
+        ExprNode* node;
+        int stage;         // 0: 未开始, 1: 第一个子树已入栈, 2: 两个子树都已入栈；调用为已入栈的实参个数
+        QuadOp op;
+        ExprNode* lhs;
+        ExprNode* rhs;
+        bool rightFirst;   // 是否先计算右子树
+    };
+    vector<Frame> frames;
+    vector<string> values;
+    frames.push_back({node, 0, OP_ADD, nullptr, nullptr, false});
+
+    while (!frames.empty()) {
+        Frame& f = frames.back();
+
+        // 情况1：数字节点，直接返回数值字符串
+        if (f.node->nodeType == NODE_NUMBER) {
+            values.push_back(to_string(((NumberNode*)f.node)->value));
+            frames.pop_back();
+            continue;
+        }
+        // 情况2：标识符节点，返回变量名
+        if (f.node->nodeType == NODE_IDENTIFIER) {
+            values.push_back(((IdNode*)f.node)->name);
+            frames.pop_back();
+            continue;
+        }
+        // 情况3：函数调用，实参逐个入栈求值
+        if (f.node->nodeType == NODE_CALL_EXPR) {
+            CallExpr* call = (CallExpr*)f.node;
+            int n = (int)call->args.size();
+            if (f.stage < n) {
+                ExprNode* arg = call->args[f.stage++];
+                frames.push_back({arg, 0, OP_ADD, nullptr, nullptr, false});
+                continue;
+            }
+            vector<string> args(values.end() - n, values.end());
+            values.resize(values.size() - n);
+            for (auto& a : args) releaseTemp(a);
+            for (auto& a : args) emit(OP_PARAM, a, "", "");
+            string res = newTemp();
+            emit(OP_CALL, call->funcName, to_string(n), res);
+            frames.pop_back();
+            values.push_back(res);
+            continue;
+        }
+        // 情况4：二元表达式（+ - * /）
+        if (f.node->nodeType != NODE_BINARY_EXPR) {
+            values.push_back("");
+            frames.pop_back();
+            continue;
+        }
+
+        if (f.stage == 0) {
+            BinaryExpr* bin = (BinaryExpr*)f.node;
+
+            // 映射操作符
+            f.op = OP_ADD;
+            if (bin->op == "+") f.op = OP_ADD;
+            else if (bin->op == "-") f.op = OP_SUB;
+            else if (bin->op == "*") f.op = OP_MUL;
+            else if (bin->op == "/") f.op = OP_DIV;
+
+            f.lhs = bin->left;
+            f.rhs = bin->right;
+            // 可交换运算：把立即数放到右操作数，便于后端使用立即数形式
+            if ((f.op == OP_ADD || f.op == OP_MUL) && f.lhs->nodeType == NODE_NUMBER && f.rhs->nodeType != NODE_NUMBER) {
+                swap(f.lhs, f.rhs);
+            }
+
+            // 先计算寄存器需求更大的子树
+            f.rightFirst = f.rhs->need > f.lhs->need;
+            f.stage = 1;
+            ExprNode* first = f.rightFirst ? f.rhs : f.lhs;
+            frames.push_back({first, 0, OP_ADD, nullptr, nullptr, false});
+        } else if (f.stage == 1) {
+            f.stage = 2;
+            ExprNode* second = f.rightFirst ? f.lhs : f.rhs;
+            frames.push_back({second, 0, OP_ADD, nullptr, nullptr, false});
+        } else {
+            string second = values.back(); values.pop_back();
+            string first = values.back(); values.pop_back();
+            string t1 = f.rightFirst ? second : first;
+            string t2 = f.rightFirst ? first : second;
+
+            // 操作数在本条四元式之后不再使用，结果可以直接复用它们的临时变量
+            releaseTemp(t1);
+            releaseTemp(t2);
+            string res = newTemp();
+
+            // 生成四元式：res = t1 op t2
+            emit(f.op, t1, t2, res);
+            frames.pop_back();
+            values.push_back(res);
+        }
     }
-    return "";
+    return values.back();
 }
 
 /**
  * 生成语句及控制结构的中间代码
+ * 使用显式任务栈代替递归：任务要么是待访问的结点，要么是延迟输出的
+ * 标签 / 跳转 / 函数尾四元式（只需要 result 字段）
  */
-void InterCodeGenerator::genNode(ASTNode* node) {
-    if (!node) return;
-
-    switch (node->nodeType) {
-        // 根节点：遍历所有顶层元素（函数或声明）
-        case NODE_PROGRAM: {
-            ProgramNode* prog = (ProgramNode*)node;
-            for (auto el : prog->elements) genNode(el);
-            break;
-        }
+void InterCodeGenerator::genNode(ASTNode* root) {
+    if (!root) return;
 
-        // 函数定义：标记函数开始和结束
-        case NODE_FUNC_DEF: {
-            FuncDef* func = (FuncDef*)node;
-            emit(OP_FUNC_BEGIN, "", "", func->funcName);
-            genNode(func->body); // 递归生成函数体代码
-            emit(OP_FUNC_END, "", "", func->funcName);
-            break;
-        }
+    struct Task {
+        ASTNode* node;  // 非空：访问该结点
+        QuadOp op;      // node 为空时：输出 op result
+        string result;
+    };
+    vector<Task> tasks;
+    tasks.push_back({root, OP_LABEL, ""});
 
-        // 语句块：遍历块内所有语句
-        case NODE_BLOCK: {
-            BlockStmt* block = (BlockStmt*)node;
-            for (auto stmt : block->stmts) genNode(stmt);
-            break;
+    while (!tasks.empty()) {
+        Task task = tasks.back();
+        tasks.pop_back();
+
+        if (!task.node) {
+            emit(task.op, "", "", task.result);
+            continue;
         }
+        ASTNode* node = task.node;
 
-        // 变量声明：如果有初始化值，生成赋值指令
-        case NODE_VAR_DECL: {
-            VarDeclStmt* decl = (VarDeclStmt*)node;
-            if (decl->initVal) {
-                string val = genExpr(decl->initVal);
-                emit(OP_ASSIGN, val, "", decl->name);
+        switch (node->nodeType) {
+            // 根节点：遍历所有顶层元素（函数或声明）
+            case NODE_PROGRAM: {
+                ProgramNode* prog = (ProgramNode*)node;
+                for (auto it = prog->elements.rbegin(); it != prog->elements.rend(); ++it) {
+                    tasks.push_back({*it, OP_LABEL, ""});
+                }
+                break;
             }
-            break;
-        }
 
-        // 赋值语句：x = expr
-        case NODE_ASSIGN_STMT: {
-            AssignStmt* assign = (AssignStmt*)node;
-            string val = genExpr(assign->value);
-            emit(OP_ASSIGN, val, "", assign->varName);
-            break;
-        }
+            // 函数定义：标记函数开始和结束
+            case NODE_FUNC_DEF: {
+                FuncDef* func = (FuncDef*)node;
+                // 每个函数拥有独立的临时变量和标签编号
+                currentFunc = func->funcName;
+                tempCount = 0;
+                labelCount = 0;
+                freeTemps.clear();
+                liveTemps.clear();
+                string params;
+                for (size_t k = 0; k < func->args.size(); ++k) params += (k ? "," : "") + func->args[k];
+                emit(OP_FUNC_BEGIN, params, "", func->funcName);
+                tasks.push_back({nullptr, OP_FUNC_END, func->funcName});
+                tasks.push_back({func->body, OP_LABEL, ""}); // 生成函数体代码
+                break;
+            }
 
-        // 返回语句：return expr
-        case NODE_RETURN_STMT: {
-            ReturnStmt* ret = (ReturnStmt*)node;
-            string val = genExpr(ret->retVal);
-            emit(OP_RETURN, val, "", "");
-            break;
-        }
+            // 语句块：遍历块内所有语句
+            case NODE_BLOCK: {
+                BlockStmt* block = (BlockStmt*)node;
+                for (auto it = block->stmts.rbegin(); it != block->stmts.rend(); ++it) {
+                    tasks.push_back({*it, OP_LABEL, ""});
+                }
+                break;
+            }
 
-        // IF 语句：控制流转换逻辑
-        case NODE_IF_STMT: {
-            IfStmt* stmt = (IfStmt*)node;
-            string cond = genExpr(stmt->cond); // 计算条件表达式
-            
-            string lblElse = newLabel(); // else 分支入口
-            string lblEnd = newLabel();  // 整个 if 结构的出口
-            
-            // 核心逻辑：如果条件为 0 (false)，跳转到 else 标签
-            emit(OP_JEQ, cond, "0", lblElse);
-            
-            // 生成 then 分支代码
-            genNode(stmt->thenBlock);
-            // 执行完 then 后，必须强制跳转到 end，跳过 else 分支
-            emit(OP_JMP, "", "", lblEnd);
-            
-            // else 分支开始
-            emit(OP_LABEL, "", "", lblElse);
-            if (stmt->elseBlock) genNode(stmt->elseBlock);
-            
-            // if 结构结束点
-            emit(OP_LABEL, "", "", lblEnd);
-            break;
-        }
+            // 变量声明：如果有初始化值，生成赋值指令
+            case NODE_VAR_DECL: {
+                VarDeclStmt* decl = (VarDeclStmt*)node;
+                if (decl->initVal) {
+                    string val = genExpr(decl->initVal);
+                    emit(OP_ASSIGN, val, "", decl->name);
+                    releaseTemp(val);
+                }
+                break;
+            }
+
+            // 赋值语句：x = expr
+            case NODE_ASSIGN_STMT: {
+                AssignStmt* assign = (AssignStmt*)node;
+                string val = genExpr(assign->value);
+                emit(OP_ASSIGN, val, "", assign->varName);
+                releaseTemp(val);
+                break;
+            }
+
+            // 表达式语句：调用不接收返回值，其余表达式的结果直接丢弃
+            case NODE_EXPR_STMT: {
+                ExprStmt* stmt = (ExprStmt*)node;
+                string val = genExpr(stmt->expr);
+                if (stmt->expr->nodeType == NODE_CALL_EXPR) codes.back().result.clear();
+                releaseTemp(val);
+                break;
+            }
+
+            // 返回语句：return expr
+            case NODE_RETURN_STMT: {
+                ReturnStmt* ret = (ReturnStmt*)node;
+                string val = genExpr(ret->retVal);
+                emit(OP_RETURN, val, "", "");
+                releaseTemp(val);
+                break;
+            }
+
+            // IF 语句：控制流转换逻辑
+            case NODE_IF_STMT: {
+                IfStmt* stmt = (IfStmt*)node;
+                string cond = genExpr(stmt->cond); // 计算条件表达式
+                
+                string lblElse = newLabel(); // else 分支入口
+                string lblEnd = newLabel();  // 整个 if 结构的出口
+                
+                // 核心逻辑：如果条件为 0 (false)，跳转到 else 标签
+                emit(OP_JEQ, cond, "0", lblElse);
+                releaseTemp(cond);
 
-        // WHILE 语句：循环控制
-        case NODE_WHILE_STMT: {
-            WhileStmt* stmt = (WhileStmt*)node;
-            string lblStart = newLabel(); // 循环检查点
-            string lblEnd = newLabel();   // 循环出口
-            
-            // 在头部放置标签，以便每次循环结束后跳回这里
-            emit(OP_LABEL, "", "", lblStart);
-            
-            // 检查循环条件
-            string cond = genExpr(stmt->cond);
-            // 如果条件不成立 (==0)，直接跳出循环
-            emit(OP_JEQ, cond, "0", lblEnd);
-            
-            // 生成循环体内部代码
-            genNode(stmt->body);
-            
-            // 循环体结束后，无条件跳转回头部再次检查条件
-            emit(OP_JMP, "", "", lblStart);
-            
-            // 整个循环结束的出口
-            emit(OP_LABEL, "", "", lblEnd);
-            break;
+                // 以下任务逆序入栈，实际输出顺序为：
+                // then 分支; JMP end（跳过 else 分支）; else:; else 分支; end:
+                tasks.push_back({nullptr, OP_LABEL, lblEnd});
+                if (stmt->elseBlock) tasks.push_back({stmt->elseBlock, OP_LABEL, ""});
+                tasks.push_back({nullptr, OP_LABEL, lblElse});
+                tasks.push_back({nullptr, OP_JMP, lblEnd});
+                tasks.push_back({stmt->thenBlock, OP_LABEL, ""});
+                break;
+            }
+
+            // WHILE 语句：循环控制
+            case NODE_WHILE_STMT: {
+                WhileStmt* stmt = (WhileStmt*)node;
+                string lblStart = newLabel(); // 循环检查点
+                string lblEnd = newLabel();   // 循环出口
+                
+                // 在头部放置标签，以便每次循环结束后跳回这里
+                emit(OP_LABEL, "", "", lblStart);
+                
+                // 检查循环条件
+                string cond = genExpr(stmt->cond);
+                // 如果条件不成立 (==0)，直接跳出循环
+                emit(OP_JEQ, cond, "0", lblEnd);
+                releaseTemp(cond);
+
+                // 逆序入栈，实际输出顺序为：循环体; JMP start（回到头部再次检查条件）; end:
+                tasks.push_back({nullptr, OP_LABEL, lblEnd});
+                tasks.push_back({nullptr, OP_JMP, lblStart});
+                tasks.push_back({stmt->body, OP_LABEL, ""});
+                break;
+            }
+            default: break;
         }
-        default: break;
     }
 }
 
@@ -197,12 +379,91 @@ void InterCodeGenerator::generate(ASTNode* root) {
     codes.clear();
     tempCount = 0;
     labelCount = 0;
+    freeTemps.clear();
+    liveTemps.clear();
+    currentFunc.clear();
     genNode(root);
 }
 
-void InterCodeGenerator::printCodes() {
+void InterCodeGenerator::generateFunction(FuncDef* func) {
+    codes.clear();
+    currentFunc.clear();
+    genNode(func);
+}
+
+void InterCodeGenerator::printCodes(ostream& out) {
+    printQuads(codes, out);
+}
+
+vector<vector<Quad>> splitFunctions(const vector<Quad>& codes) {
+    vector<vector<Quad>> funcs;
+    bool inFunc = false;
+    for (auto& q : codes) {
+        if (q.op == OP_FUNC_BEGIN || !inFunc) {
+            funcs.emplace_back();
+            inFunc = true;
+        }
+        funcs.back().push_back(q);
+        if (q.op == OP_FUNC_END) inFunc = false;
+    }
+    return funcs;
+}
+
+vector<string> funcParams(const Quad& begin) {
+    vector<string> params;
+    size_t start = 0;
+    while (start < begin.arg1.size()) {
+        size_t comma = begin.arg1.find(',', start);
+        if (comma == string::npos) comma = begin.arg1.size();
+        params.push_back(begin.arg1.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return params;
+}
+
+string entryFunction(const vector<string>& names) {
+    if (find(names.begin(), names.end(), "main") != names.end()) return "main";
+    return names.empty() ? "" : names.front();
+}
+
+/**
+ * 检查一个函数中的调用：被调函数必须存在，实参个数必须等于形参个数
+ * 汇编和 JIT 中形参是被调函数栈帧里的固定位置，个数不符时读到的是无关的值
+ */
+string checkCalls(const vector<Quad>& codes, const map<string, int>& arity) {
+    for (auto& q : codes) {
+        if (q.op != OP_CALL) continue;
+        const string& caller = codes.front().result;
+        auto it = arity.find(q.arg1);
+        if (it == arity.end()) return "call to undefined function '" + q.arg1 + "' in function " + caller;
+        if (to_string(it->second) != q.arg2) {
+            return "function '" + q.arg1 + "' takes " + to_string(it->second) + " argument(s) but is called with " +
+                   q.arg2 + " in function " + caller;
+        }
+    }
+    return "";
+}
+
+const char* quadOpName(QuadOp op) {
+    static const char* names[] = {
+        "ADD", "SUB", "MUL", "DIV", "ASSIGN", "LABEL", "JMP",
+        "JEQ", "JNE", "JGT", "JLT", "PARAM", "CALL", "RETURN",
+        "FUNC_BEGIN", "FUNC_END", "PHI"
+    };
+    return (op >= 0 && op <= OP_PHI) ? names[op] : "?";
+}
+
+void printQuads(const vector<Quad>& codes, ostream& out) {
     for (auto& q : codes) {
-        // 输出格式：操作码 操作数1 操作数2 结果
-        cout << q.op << " " << q.arg1 << " " << q.arg2 << " " << q.result << endl;
+        // 输出格式：操作码 操作数1 操作数2 结果；PHI 的值和前驱各自用逗号连接
+        if (q.op == OP_PHI) {
+            out << quadOpName(q.op) << " ";
+            for (size_t k = 0; k < q.phi.size(); ++k) out << (k ? "," : "") << q.phi[k].first;
+            out << " ";
+            for (size_t k = 0; k < q.phi.size(); ++k) out << (k ? "," : "") << q.phi[k].second;
+            out << " " << q.result << '\n';
+            continue;
+        }
+        out << quadOpName(q.op) << " " << q.arg1 << " " << q.arg2 << " " << q.result << '\n';
     }
 }
\ No newline at end of file
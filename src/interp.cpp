@@ -0,0 +1,292 @@
+#include "interp.h"
+#include <map>
+#include <algorithm>
+#include <climits>
+
+IRInterpreter::IRInterpreter()
+    : steps(0), maxSteps(1000000000LL), maxDepth(10000), value(0), returned(false) {}
+
+void IRInterpreter::setMaxSteps(long long n) {
+    maxSteps = n;
+}
+
+void IRInterpreter::setMaxDepth(int n) {
+    maxDepth = n;
+}
+
+int32_t IRInterpreter::result() const {
+    return value;
+}
+
+bool IRInterpreter::hasReturned() const {
+    return returned;
+}
+
+long long IRInterpreter::getSteps() const {
+    return steps;
+}
+
+const vector<long long>& IRInterpreter::quadCounts() const {
+    return counts;
+}
+
+const vector<long long>& IRInterpreter::takenCounts() const {
+    return taken;
+}
+
+static bool isConstant(const string& s) {
+    if (s.empty()) return false;
+    return isdigit((unsigned char)s[0]) || (s[0] == '-' && s.size() > 1);
+}
+
+static bool isJump(QuadOp op) {
+    return op == OP_JMP || op == OP_JEQ || op == OP_JNE || op == OP_JGT || op == OP_JLT;
+}
+
+/**
+ * 预解码：逐个函数为变量和常量分配槽位，解析标签和被调函数
+ * 同时按标签 / 跳转划分基本块，用于统计块的执行次数
+ */
+bool IRInterpreter::load(const vector<Quad>& codes, string& error) {
+    code.clear();
+    funcs.clear();
+    blockStart.clear();
+    blockName.clear();
+    counts.assign(codes.size(), 0);
+    taken.assign(codes.size(), 0);
+
+    map<string, int> funcIndex;
+    for (size_t i = 0; i < codes.size(); ++i) {
+        if (codes[i].op != OP_FUNC_BEGIN) continue;
+        if (!funcIndex.emplace(codes[i].result, (int)funcs.size()).second) {
+            error = "duplicate function '" + codes[i].result + "'";
+            return false;
+        }
+        funcs.push_back({codes[i].result, (int)i, 0, {}});
+    }
+
+    code.resize(codes.size(), Inst{OP_LABEL, -1, -1, -1, -1});
+    for (size_t f = 0; f < funcs.size(); ++f) {
+        Function& func = funcs[f];
+        map<string, int> slots;
+        map<string, int> labels;
+        int end = func.entry + 1;
+        for (; end < (int)codes.size() && codes[end].op != OP_FUNC_BEGIN; ++end) {
+            if (codes[end].op == OP_LABEL) labels[codes[end].result] = end;
+            if (codes[end].op == OP_FUNC_END) break;
+        }
+        if (end >= (int)codes.size() || codes[end].op != OP_FUNC_END) {
+            error = "function " + func.name + " has no FUNC_END";
+            return false;
+        }
+
+        auto slotOf = [&](const string& s) -> int {
+            if (s.empty()) return -1;
+            auto it = slots.find(s);
+            if (it != slots.end()) return it->second;
+            int id = (int)func.frame.size();
+            func.frame.push_back(isConstant(s) ? (int32_t)stoll(s) : 0);
+            slots[s] = id;
+            return id;
+        };
+        // 形参占据最前面的槽位，调用时实参按顺序复制进去
+        vector<string> params = funcParams(codes[func.entry]);
+        for (auto& p : params) slotOf(p);
+        func.params = (int)params.size();
+
+        for (int i = func.entry; i <= end; ++i) {
+            const Quad& q = codes[i];
+            Inst& in = code[i];
+            in.op = q.op;
+
+            // 基本块：函数入口、标签以及跳转 / 返回之后的第一条四元式
+            bool leader = (i == func.entry) || q.op == OP_LABEL ||
+                          (i > func.entry && (isJump(codes[i - 1].op) || codes[i - 1].op == OP_RETURN));
+            if (leader) {
+                blockStart.push_back(i);
+                if (q.op == OP_LABEL) blockName.push_back(q.result);
+                else if (i == func.entry) blockName.push_back(func.name);
+                else blockName.push_back(func.name + "+" + to_string(i - func.entry));
+            }
+
+            switch (q.op) {
+                case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+                    in.a = slotOf(q.arg1);
+                    in.b = slotOf(q.arg2);
+                    in.r = slotOf(q.result);
+                    break;
+                case OP_ASSIGN:
+                    in.a = slotOf(q.arg1);
+                    in.r = slotOf(q.result);
+                    break;
+                case OP_JMP: case OP_JEQ: case OP_JNE: case OP_JGT: case OP_JLT: {
+                    auto it = labels.find(q.result);
+                    if (it == labels.end()) {
+                        error = "jump to undefined label '" + q.result + "' in function " + func.name;
+                        return false;
+                    }
+                    in.target = it->second;
+                    if (q.op != OP_JMP) {
+                        in.a = slotOf(q.arg1);
+                        in.b = slotOf(q.arg2);
+                    }
+                    break;
+                }
+                case OP_PARAM:
+                    in.a = slotOf(q.arg1);
+                    break;
+                case OP_CALL: {
+                    auto it = funcIndex.find(q.arg1);
+                    if (it == funcIndex.end()) {
+                        error = "call to undefined function '" + q.arg1 + "' in function " + func.name;
+                        return false;
+                    }
+                    in.target = it->second;
+                    in.b = isConstant(q.arg2) ? stoi(q.arg2) : 0; // 实参个数
+                    in.r = slotOf(q.result);
+                    break;
+                }
+                case OP_RETURN:
+                    in.a = slotOf(q.arg1);
+                    break;
+                case OP_PHI:
+                    // SSA 形式在离开遍管理器之前就已还原，不能直接执行
+                    error = "PHI in function " + func.name + ", the IR is still in SSA form";
+                    return false;
+                default: break;
+            }
+        }
+    }
+    return true;
+}
+
+static inline int32_t wrapDiv(int32_t a, int32_t b) {
+    if (b == 0) return 0;
+    if (a == INT_MIN && b == -1) return INT_MIN;
+    return a / b;
+}
+
+/**
+ * 执行：所有活动记录的槽位放在同一个数组中，调用时复制被调函数的栈帧初值
+ * 调用栈是显式的，不使用 C++ 递归
+ */
+bool IRInterpreter::run(string& error, const string& entry) {
+    fill(counts.begin(), counts.end(), 0);
+    fill(taken.begin(), taken.end(), 0);
+    steps = 0;
+    value = 0;
+    returned = false;
+
+    vector<string> names;
+    for (auto& f : funcs) names.push_back(f.name);
+    string start = entry.empty() ? entryFunction(names) : entry;
+    int entryFunc = -1;
+    for (size_t f = 0; f < funcs.size(); ++f) {
+        if (funcs[f].name == start) { entryFunc = (int)f; break; }
+    }
+    if (entryFunc < 0) {
+        error = entry.empty() ? "program has no functions" : "entry function '" + entry + "' not found";
+        return false;
+    }
+
+    struct Activation {
+        size_t base;      // 栈帧在 stack 中的起始位置
+        int returnPc;     // 调用者中 CALL 的下一条
+        int resultSlot;   // 调用者中接收返回值的槽位
+    };
+    vector<Activation> calls;
+    vector<int32_t> stack;
+    vector<int32_t> args; // PARAM 压入的实参，CALL 取走最后 nargs 个
+
+    auto enter = [&](int f, int returnPc, int resultSlot) {
+        calls.push_back({stack.size(), returnPc, resultSlot});
+        stack.insert(stack.end(), funcs[f].frame.begin(), funcs[f].frame.end());
+        counts[funcs[f].entry]++;
+        return funcs[f].entry + 1;
+    };
+
+    int pc = enter(entryFunc, -1, -1);
+    int32_t* fp = stack.data();
+
+    while (true) {
+        if (steps >= maxSteps) {
+            error = "step limit of " + to_string(maxSteps) + " quads exceeded";
+            return false;
+        }
+        steps++;
+        counts[pc]++;
+        const Inst& in = code[pc];
+
+        switch (in.op) {
+            case OP_ADD: fp[in.r] = (int32_t)((uint32_t)fp[in.a] + (uint32_t)fp[in.b]); pc++; break;
+            case OP_SUB: fp[in.r] = (int32_t)((uint32_t)fp[in.a] - (uint32_t)fp[in.b]); pc++; break;
+            case OP_MUL: fp[in.r] = (int32_t)((int64_t)fp[in.a] * fp[in.b]); pc++; break;
+            case OP_DIV: fp[in.r] = wrapDiv(fp[in.a], fp[in.b]); pc++; break;
+            case OP_ASSIGN: fp[in.r] = fp[in.a]; pc++; break;
+            case OP_JMP: pc = in.target; break;
+            case OP_JEQ: if (fp[in.a] == fp[in.b]) { taken[pc]++; pc = in.target; } else pc++; break;
+            case OP_JNE: if (fp[in.a] != fp[in.b]) { taken[pc]++; pc = in.target; } else pc++; break;
+            case OP_JGT: if (fp[in.a] > fp[in.b]) { taken[pc]++; pc = in.target; } else pc++; break;
+            case OP_JLT: if (fp[in.a] < fp[in.b]) { taken[pc]++; pc = in.target; } else pc++; break;
+            case OP_PARAM: args.push_back(fp[in.a]); pc++; break;
+            case OP_CALL: {
+                if ((int)calls.size() >= maxDepth) {
+                    error = "call depth limit of " + to_string(maxDepth) + " exceeded";
+                    return false;
+                }
+                size_t n = min(args.size(), (size_t)in.b);
+                size_t first = args.size() - n;
+                pc = enter(in.target, pc + 1, in.r);
+                fp = stack.data() + calls.back().base;
+                for (size_t k = 0; k < n && (int)k < funcs[in.target].params; ++k) fp[k] = args[first + k];
+                args.resize(first);
+                break;
+            }
+            case OP_RETURN:
+            case OP_FUNC_END: {
+                // 执行到函数尾等同于不带值的返回
+                bool hasValue = (in.op == OP_RETURN && in.a >= 0);
+                int32_t v = hasValue ? fp[in.a] : 0;
+                Activation done = calls.back();
+                calls.pop_back();
+                stack.resize(done.base);
+                if (calls.empty()) {
+                    value = v;
+                    returned = hasValue;
+                    return true;
+                }
+                fp = stack.data() + calls.back().base;
+                if (done.resultSlot >= 0) fp[done.resultSlot] = v;
+                pc = done.returnPc;
+                break;
+            }
+            default: pc++; break; // LABEL
+        }
+    }
+}
+
+vector<IRBlockCount> IRInterpreter::blockCounts() const {
+    vector<IRBlockCount> blocks;
+    for (size_t b = 0; b < blockStart.size(); ++b) {
+        int first = blockStart[b];
+        int last = (b + 1 < blockStart.size()) ? blockStart[b + 1] - 1 : (int)code.size() - 1;
+        blocks.push_back({blockName[b], first, last, counts[first]});
+    }
+    return blocks;
+}
+
+void IRInterpreter::printReport(ostream& out, int top) const {
+    if (returned) out << "Result: " << value << '\n';
+    else out << "Result: (no return value)" << '\n';
+    out << "Quads executed: " << steps << '\n';
+
+    vector<IRBlockCount> blocks = blockCounts();
+    stable_sort(blocks.begin(), blocks.end(), [](const IRBlockCount& x, const IRBlockCount& y) {
+        return x.count > y.count;
+    });
+    out << "Hottest blocks:" << '\n';
+    for (int i = 0; i < top && i < (int)blocks.size() && blocks[i].count > 0; ++i) {
+        const IRBlockCount& b = blocks[i];
+        out << "  " << b.name << " [" << b.first << ".." << b.last << "] " << b.count << '\n';
+    }
+}
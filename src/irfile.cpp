@@ -0,0 +1,231 @@
+#include "irfile.h"
+#include <fstream>
+#include <unordered_map>
+#include <cstring>
+#include <cctype>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * 写出中间代码文件
+ * 所有操作数先放入去重的字符串表，四元式只保存字符串编号
+ */
+bool writeIRFile(const string& path, const vector<Quad>& codes) {
+    vector<string> strings = {""};
+    unordered_map<string, uint32_t> ids = {{"", 0}};
+    auto intern = [&](const string& s) -> uint32_t {
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        uint32_t id = (uint32_t)strings.size();
+        strings.push_back(s);
+        ids[s] = id;
+        return id;
+    };
+
+    vector<IRQuadRecord> records;
+    vector<IRFuncEntry> funcs;
+    records.reserve(codes.size());
+    for (auto& q : codes) {
+        if (q.op == OP_FUNC_BEGIN) {
+            funcs.push_back({intern(q.result), (uint32_t)records.size(), 0, 0});
+        }
+        records.push_back({(uint32_t)q.op, intern(q.arg1), intern(q.arg2), intern(q.result)});
+        if (q.op == OP_FUNC_END && !funcs.empty()) {
+            funcs.back().quadCount = (uint32_t)records.size() - funcs.back().firstQuad;
+        }
+    }
+
+    vector<uint32_t> offsets;
+    string stringData;
+    for (auto& s : strings) {
+        offsets.push_back((uint32_t)stringData.size());
+        stringData += s;
+    }
+    offsets.push_back((uint32_t)stringData.size());
+    while (stringData.size() % 4 != 0) stringData += '\0';
+
+    IRFileHeader header;
+    memcpy(header.magic, "QIR", 4);
+    header.version = IR_FILE_VERSION;
+    header.stringCount = (uint32_t)strings.size();
+    header.funcCount = (uint32_t)funcs.size();
+    header.quadCount = (uint32_t)records.size();
+    header.stringDataSize = (uint32_t)stringData.size();
+    header.reserved[0] = header.reserved[1] = 0;
+
+    ofstream out(path, ios::binary);
+    if (!out.is_open()) return false;
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+    out.write(stringData.data(), stringData.size());
+    out.write((const char*)funcs.data(), funcs.size() * sizeof(IRFuncEntry));
+    out.write((const char*)records.data(), records.size() * sizeof(IRQuadRecord));
+    return (bool)out;
+}
+
+IRFile::IRFile()
+    : data(nullptr), size(0), mapped(false), header(nullptr), stringOffsets(nullptr),
+      stringData(nullptr), funcs(nullptr), quads(nullptr) {}
+
+IRFile::~IRFile() {
+    close();
+}
+
+void IRFile::close() {
+    if (!data) return;
+#ifndef _WIN32
+    if (mapped) munmap((void*)data, size);
+    else delete[] data;
+#else
+    delete[] data;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+/**
+ * 看起来像立即数（以数字或 '-' 开头，与 Lowering::isNumber 的判断相同）的操作数
+ * 必须完整地是一个 32 位有符号整数，否则后端和解释器中的 stoi 会抛出异常
+ */
+static bool validNumber(const char* s, size_t len) {
+    if (len == 0 || !(isdigit((unsigned char)s[0]) || (s[0] == '-' && len > 1))) return true;
+    size_t i = (s[0] == '-') ? 1 : 0;
+    long long v = 0;
+    for (; i < len; ++i) {
+        if (!isdigit((unsigned char)s[i])) return false;
+        v = v * 10 + (s[i] - '0');
+        if (v > 2147483648LL) return false;
+    }
+    return s[0] == '-' || v <= 2147483647LL;
+}
+
+/**
+ * 打开并校验中间代码文件
+ * 检查各个区域的边界、字符串编号、立即数操作数和函数的首尾，之后的访问不再做任何解析
+ */
+bool IRFile::open(const string& path, string& error) {
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { error = "Cannot open file '" + path + "'"; return false; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        error = "Cannot read file '" + path + "'";
+        return false;
+    }
+    size = (size_t)st.st_size;
+    void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { error = "Cannot map file '" + path + "'"; size = 0; return false; }
+    data = (const char*)p;
+    mapped = true;
+#else
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in.is_open()) { error = "Cannot open file '" + path + "'"; return false; }
+    size = (size_t)in.tellg();
+    char* buf = new char[size];
+    in.seekg(0);
+    in.read(buf, size);
+    data = buf;
+    mapped = false;
+#endif
+
+    auto fail = [&](const string& msg) { error = path + ": " + msg; close(); return false; };
+
+    if (size < sizeof(IRFileHeader)) return fail("file too small");
+    header = (const IRFileHeader*)data;
+    if (memcmp(header->magic, "QIR", 4) != 0) return fail("not an IR file");
+    if (header->version != IR_FILE_VERSION) return fail("unsupported IR version " + to_string(header->version));
+
+    uint64_t offsetsSize = ((uint64_t)header->stringCount + 1) * sizeof(uint32_t);
+    uint64_t funcsOffset = sizeof(IRFileHeader) + offsetsSize + header->stringDataSize;
+    uint64_t quadsOffset = funcsOffset + (uint64_t)header->funcCount * sizeof(IRFuncEntry);
+    uint64_t end = quadsOffset + (uint64_t)header->quadCount * sizeof(IRQuadRecord);
+    if (header->stringCount == 0 || header->stringDataSize % 4 != 0 || end != size) return fail("corrupted layout");
+
+    stringOffsets = (const uint32_t*)(data + sizeof(IRFileHeader));
+    stringData = data + sizeof(IRFileHeader) + offsetsSize;
+    funcs = (const IRFuncEntry*)(data + funcsOffset);
+    quads = (const IRQuadRecord*)(data + quadsOffset);
+
+    for (uint32_t i = 0; i < header->stringCount; ++i) {
+        if (stringOffsets[i] > stringOffsets[i + 1]) return fail("corrupted string table");
+    }
+    if (stringOffsets[header->stringCount] > header->stringDataSize) return fail("corrupted string table");
+    vector<char> badNumber(header->stringCount);
+    for (uint32_t i = 0; i < header->stringCount; ++i) {
+        badNumber[i] = !validNumber(stringData + stringOffsets[i], stringOffsets[i + 1] - stringOffsets[i]);
+    }
+
+    // 函数必须以 FUNC_BEGIN 开始、FUNC_END 结束，不能嵌套，函数之外没有四元式
+    bool inFunc = false;
+    for (uint32_t i = 0; i < header->quadCount; ++i) {
+        const IRQuadRecord& q = quads[i];
+        // PHI 只在优化遍内部出现，写出的中间代码总是已经离开 SSA 形式
+        if (q.op > OP_FUNC_END || q.arg1 >= header->stringCount || q.arg2 >= header->stringCount ||
+            q.result >= header->stringCount) {
+            return fail("corrupted quad " + to_string(i));
+        }
+        if (badNumber[q.arg1] || badNumber[q.arg2]) return fail("invalid integer operand in quad " + to_string(i));
+        if (q.op == OP_FUNC_BEGIN) {
+            if (inFunc) return fail("quad " + to_string(i) + ": function begins before the previous one ends");
+            inFunc = true;
+        } else if (!inFunc) {
+            return fail("quad " + to_string(i) + " is outside of a function");
+        } else if (q.op == OP_FUNC_END) {
+            inFunc = false;
+        }
+    }
+    if (inFunc) return fail("last function has no end");
+
+    for (uint32_t i = 0; i < header->funcCount; ++i) {
+        const IRFuncEntry& f = funcs[i];
+        if (f.nameId >= header->stringCount || f.quadCount < 2 ||
+            (uint64_t)f.firstQuad + f.quadCount > header->quadCount ||
+            quads[f.firstQuad].op != OP_FUNC_BEGIN || quads[f.firstQuad + f.quadCount - 1].op != OP_FUNC_END) {
+            return fail("corrupted function index");
+        }
+    }
+    return true;
+}
+
+int IRFile::functionCount() const {
+    return header ? (int)header->funcCount : 0;
+}
+
+string IRFile::getString(uint32_t id) const {
+    return string(stringData + stringOffsets[id], stringOffsets[id + 1] - stringOffsets[id]);
+}
+
+string IRFile::functionName(int index) const {
+    return getString(funcs[index].nameId);
+}
+
+vector<Quad> IRFile::functionQuads(int index) const {
+    vector<Quad> out;
+    const IRFuncEntry& f = funcs[index];
+    out.reserve(f.quadCount);
+    for (uint32_t i = f.firstQuad; i < f.firstQuad + f.quadCount; ++i) {
+        const IRQuadRecord& q = quads[i];
+        out.emplace_back((QuadOp)q.op, getString(q.arg1), getString(q.arg2), getString(q.result));
+    }
+    return out;
+}
+
+vector<Quad> IRFile::allQuads() const {
+    vector<Quad> out;
+    if (!header) return out;
+    out.reserve(header->quadCount);
+    for (uint32_t i = 0; i < header->quadCount; ++i) {
+        const IRQuadRecord& q = quads[i];
+        out.emplace_back((QuadOp)q.op, getString(q.arg1), getString(q.arg2), getString(q.result));
+    }
+    return out;
+}
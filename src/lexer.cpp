@@ -1,21 +1,86 @@
 // 文件名: lexer.cpp (修正版)
 #include "lexer.h"
+#include "instrument.h"
 #include <cctype>
 
-Lexer::Lexer(string source) : src(source), pos(0) {}
+Lexer::Lexer(string source, int startLine, int startColumn)
+    : src(move(source)), pos(0), in(nullptr), line(startLine), column(startColumn), tokLine(startLine),
+      tokColumn(startColumn) {}
+
+Lexer::Lexer(istream& input)
+    : pos(0), in(&input), line(1), column(1), tokLine(1), tokColumn(1) {}
+
+string tokenName(TokenType type) {
+    switch (type) {
+        case TOK_INT: return "'int'";
+        case TOK_VOID: return "'void'";
+        case TOK_RETURN: return "'return'";
+        case TOK_IF: return "'if'";
+        case TOK_ELSE: return "'else'";
+        case TOK_WHILE: return "'while'";
+        case TOK_ID: return "identifier";
+        case TOK_NUM: return "number";
+        case TOK_PLUS: return "'+'";
+        case TOK_MINUS: return "'-'";
+        case TOK_STAR: return "'*'";
+        case TOK_SLASH: return "'/'";
+        case TOK_ASSIGN: return "'='";
+        case TOK_LPAREN: return "'('";
+        case TOK_RPAREN: return "')'";
+        case TOK_LBRACE: return "'{'";
+        case TOK_RBRACE: return "'}'";
+        case TOK_SEMI: return "';'";
+        case TOK_COMMA: return "','";
+        case TOK_EOF: return "end of file";
+        case TOK_ERROR: return "invalid character";
+    }
+    return "unknown token";
+}
+
+// 流式输入时每次读取的块大小
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+bool Lexer::hasChar() {
+    if ((size_t)pos < src.length()) return true;
+    if (!in || !*in) return false;
+
+    // 缓冲区已消费完，丢弃后读取下一块
+    src.resize(CHUNK_SIZE);
+    in->read(&src[0], CHUNK_SIZE);
+    src.resize(in->gcount());
+    pos = 0;
+    return !src.empty();
+}
+
+char Lexer::advanceChar() {
+    char c = src[pos++];
+    if (c == '\n') { line++; column = 1; }
+    else column++;
+    return c;
+}
 
 Token Lexer::nextToken() {
-    while (pos < src.length()) {
+    Token tok = scanToken();
+    tok.line = tokLine;
+    tok.column = tokColumn;
+    INSTR_COUNT(CNT_TOKENS, 1);
+    return tok;
+}
+
+Token Lexer::scanToken() {
+    while (hasChar()) {
         char current = src[pos];
 
         // 1. 跳过空白
-        if (isspace(current)) { pos++; continue; }
+        if (isspace(current)) { advanceChar(); continue; }
+        tokLine = line;
+        tokColumn = column;
 
         // 2. 识别单词 (关键字或变量名)
         if (isalpha(current)) {
             string word;
-            while (pos < src.length() && (isalnum(src[pos]) || src[pos] == '_')) {
-                word += src[pos++];
+            while (hasChar() && (isalnum(src[pos]) || src[pos] == '_')) {
+                word += advanceChar();
             }
             
             // --- 之前漏掉的关键字补在这个位置 ---
@@ -32,14 +97,14 @@ Token Lexer::nextToken() {
         // 3. 识别数字
         if (isdigit(current)) {
             string numStr;
-            while (pos < src.length() && isdigit(src[pos])) {
-                numStr += src[pos++];
+            while (hasChar() && isdigit(src[pos])) {
+                numStr += advanceChar();
             }
             return {TOK_NUM, numStr};
         }
 
         // 4. 识别符号
-        pos++;
+        advanceChar();
         switch (current) {
             case '+': return {TOK_PLUS, "+"};
             case '-': return {TOK_MINUS, "-"};
@@ -47,6 +112,7 @@ Token Lexer::nextToken() {
             case '/': return {TOK_SLASH, "/"};
             case '=': return {TOK_ASSIGN, "="};
             case ';': return {TOK_SEMI, ";"};
+            case ',': return {TOK_COMMA, ","};
             case '(': return {TOK_LPAREN, "("};
             case ')': return {TOK_RPAREN, ")"};
             case '{': return {TOK_LBRACE, "{"};
@@ -54,5 +120,7 @@ Token Lexer::nextToken() {
             default: return {TOK_ERROR, string(1, current)};
         }
     }
+    tokLine = line;
+    tokColumn = column;
     return {TOK_EOF, ""};
 }
\ No newline at end of file
@@ -1,146 +1,321 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include "lexer.h"
-#include "myparser.h"
-# include "intercode.h"
-# include "asmgen.h"
-
-// 打印工具：支持所有节点类型
-void printAST(ASTNode* node, int level = 0) {
-    if (!node) return;
-    string indent(level * 2, ' ');
-
-    switch (node->nodeType) {
-        case NODE_PROGRAM: {
-            cout << indent << "Program" << endl;
-            ProgramNode* prog = (ProgramNode*)node;
-            for (auto el : prog->elements) printAST(el, level + 1);
-            break;
-        }
-        case NODE_FUNC_DEF: {
-            FuncDef* func = (FuncDef*)node;
-            cout << indent << "Function: " << func->returnType << " " << func->funcName << "()" << endl;
-            printAST(func->body, level + 1);
-            break;
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <cstdlib>
+#include <memory>
+#include "driver.h"
+#include "threadpool.h"
+#include "server.h"
+#include "instrument.h"
+
+using namespace std;
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options] <source_file>..." << endl;
+    cerr << "Options:" << endl;
+    cerr << "  -o <file>   Output file (only with a single source file)" << endl;
+    cerr << "  -q          Quiet, only print diagnostics" << endl;
+    cerr << "  --emit=<stages>     Comma separated list of ast, ir, asm (default: asm)" << endl;
+    cerr << "                      ast / ir are printed to stdout, asm is written to the output file" << endl;
+    cerr << "  -d <dir>    Output directory, each input writes <dir>/<name>.asm (or .qir)" << endl;
+    cerr << "  -j <n>      Number of worker threads (default: number of cores)" << endl;
+    cerr << "  -O0 / -O1 / -O2 / -Os  Optimization pipeline (default: -O1, call graph only;" << endl;
+    cerr << "              -O2 adds the function passes including sparse SSA optimizations," << endl;
+    cerr << "              -Os repeats them until nothing changes)" << endl;
+    cerr << "  -fpass=<list>       Enable passes, -fno-pass=<list> disables them" << endl;
+    cerr << "                      (" << knownPassNames() << ")" << endl;
+    cerr << "  -fverify-ir         Check the IR after every pass" << endl;
+    cerr << "  -fpass-stats        Print runs, changes and time of every pass to stderr" << endl;
+    cerr << "  --simulate  Run the generated assembly on the built-in MIPS simulator and report" << endl;
+    cerr << "              $v0, instruction counts, memory accesses and pipeline cycles" << endl;
+    cerr << "  --interp    Execute the optimized IR with the quad interpreter and report" << endl;
+    cerr << "              the result and the hottest basic blocks (checked against --simulate)" << endl;
+    cerr << "  --run       Compile to x86-64 machine code in memory and execute it (no output file)" << endl;
+    cerr << "  --profile-generate=<file>  Execute the optimized IR and write block and branch counts" << endl;
+    cerr << "  --profile-use=<file>       Lay out blocks and pick spill victims by those counts" << endl;
+    cerr << "  -ftime-report       Print time, memory and counters per phase to stderr" << endl;
+    cerr << "  -ftrace=<file>      Write a Chrome trace (chrome://tracing) of all phases" << endl;
+    cerr << "                      (both need a build with 'make INSTRUMENT=1')" << endl;
+    cerr << "  --format=<fmt>      Output asm (default), elf (relocatable MIPS object) or bin (raw image)" << endl;
+    cerr << "  --stream    Compile and write each function as soon as it is parsed" << endl;
+    cerr << "              (bounded memory, no whole-program call graph optimization)" << endl;
+    cerr << "  --emit-ir   Run the front end only and write binary IR (.qir) instead of assembly" << endl;
+    cerr << "  --from-ir   Inputs are .qir files, run the back end only" << endl;
+    cerr << "  --server <socket>   Run as a compile server on a Unix domain socket" << endl;
+    cerr << "  --connect <socket>  Send the inputs to a running compile server" << endl;
+    cerr << "  --stop              With --connect: shut the server down afterwards" << endl;
+    cerr << "  --cache-dir <dir>   Reuse assembly of unchanged functions from <dir>" << endl;
+    cerr << "  --cache-size <MB>   Cache size limit, least recently used entries are evicted (default: 256)" << endl;
+    cerr << "Example: " << prog << " program.txt" << endl;
+}
+
+// 解析逗号分隔的遍名列表，有未知的遍名时返回 false
+static bool parsePassList(const string& list, vector<string>& out) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == string::npos) comma = list.size();
+        string name = list.substr(start, comma - start);
+        if (!isKnownPass(name)) {
+            cerr << "Error: Unknown pass '" << name << "', expected one of " << knownPassNames() << endl;
+            return false;
         }
-        case NODE_BLOCK: {
-            cout << indent << "Block { ... }" << endl;
-            BlockStmt* block = (BlockStmt*)node;
-            for (auto stmt : block->stmts) printAST(stmt, level + 1);
-            break;
+        out.push_back(name);
+        start = comma + 1;
+    }
+    return true;
+}
+
+// 取文件名去掉目录和扩展名的部分，如 src/a.cpp -> a
+static string fileStem(const string& path) {
+    size_t slash = path.find_last_of("/\\");
+    string name = (slash == string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return (dot == string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> inputs;
+    string outputFile;
+    string outputDir;
+    int threads = 0;
+    CompileOptions options;
+    string cacheDir;
+    string serverSocket;
+    string connectSocket;
+    bool stopServer = false;
+    unsigned long long cacheSizeMB = 256;
+    bool timeReport = false;
+    string traceFile;
+    PassStatistics passStats;
+    string profileUseFile;
+    Profile profile;
+
+    // 解析命令行参数
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if ((arg == "-o" || arg == "-d" || arg == "-j" || arg == "--cache-dir" || arg == "--cache-size" ||
+             arg == "--server" || arg == "--connect") && i + 1 >= argc) {
+            cerr << "Error: Missing argument for " << arg << endl;
+            return 1;
         }
-        case NODE_IF_STMT: {
-            cout << indent << "If Statement" << endl;
-            IfStmt* s = (IfStmt*)node;
-            cout << indent << "  Cond:" << endl;
-            printAST(s->cond, level + 2);
-            cout << indent << "  Then:" << endl;
-            printAST(s->thenBlock, level + 2);
-            if (s->elseBlock) {
-                cout << indent << "  Else:" << endl;
-                printAST(s->elseBlock, level + 2);
-            }
-            break;
+        if (arg == "-o") outputFile = argv[++i];
+        else if (arg == "-d") outputDir = argv[++i];
+        else if (arg == "-j") threads = atoi(argv[++i]);
+        else if (arg == "-q") options.quiet = true;
+        else if (arg == "-O0") options.passes.level = OPT_O0;
+        else if (arg == "-O1") options.passes.level = OPT_O1;
+        else if (arg == "-O2") options.passes.level = OPT_O2;
+        else if (arg == "-Os") options.passes.level = OPT_OS;
+        else if (arg.compare(0, 7, "-fpass=") == 0) {
+            if (!parsePassList(arg.substr(7), options.passes.enable)) return 1;
         }
-        case NODE_WHILE_STMT: {
-            cout << indent << "While Statement" << endl;
-            WhileStmt* s = (WhileStmt*)node;
-            cout << indent << "  Cond:" << endl;
-            printAST(s->cond, level + 2);
-            cout << indent << "  Body:" << endl;
-            printAST(s->body, level + 2);
-            break;
+        else if (arg.compare(0, 10, "-fno-pass=") == 0) {
+            if (!parsePassList(arg.substr(10), options.passes.disable)) return 1;
         }
-        case NODE_RETURN_STMT: {
-            cout << indent << "Return" << endl;
-            printAST(((ReturnStmt*)node)->retVal, level + 1);
-            break;
+        else if (arg == "-fverify-ir") options.passes.verify = true;
+        else if (arg == "-fpass-stats") options.passStats = &passStats;
+        else if (arg.compare(0, 19, "--profile-generate=") == 0) options.profileGenerate = arg.substr(19);
+        else if (arg.compare(0, 14, "--profile-use=") == 0) profileUseFile = arg.substr(14);
+        else if (arg == "-ftime-report") timeReport = true;
+        else if (arg.compare(0, 8, "-ftrace=") == 0) traceFile = arg.substr(8);
+        else if (arg.compare(0, 7, "--emit=") == 0) {
+            // 调试输出默认关闭，只有明确要求时才格式化语法树和中间代码
+            options.dumpAST = options.dumpIR = options.emitAsm = false;
+            string stages = arg.substr(7);
+            size_t start = 0;
+            while (start <= stages.size()) {
+                size_t comma = stages.find(',', start);
+                if (comma == string::npos) comma = stages.size();
+                string stage = stages.substr(start, comma - start);
+                if (stage == "ast") options.dumpAST = true;
+                else if (stage == "ir") options.dumpIR = true;
+                else if (stage == "asm") options.emitAsm = true;
+                else {
+                    cerr << "Error: Unknown stage '" << stage << "' in --emit, expected ast, ir or asm" << endl;
+                    return 1;
+                }
+                start = comma + 1;
+            }
         }
-        case NODE_VAR_DECL: {
-            VarDeclStmt* s = (VarDeclStmt*)node;
-            cout << indent << "VarDecl: " << s->type << " " << s->name << endl;
-            if (s->initVal) {
-                cout << indent << "  = " << endl;
-                printAST(s->initVal, level + 2);
+        else if (arg.compare(0, 9, "--format=") == 0) {
+            string format = arg.substr(9);
+            if (format == "asm") options.format = FORMAT_ASM;
+            else if (format == "elf") options.format = FORMAT_ELF;
+            else if (format == "bin") options.format = FORMAT_BIN;
+            else {
+                cerr << "Error: Unknown format '" << format << "', expected asm, elf or bin" << endl;
+                return 1;
             }
-            break;
         }
-        case NODE_ASSIGN_STMT: {
-            AssignStmt* s = (AssignStmt*)node;
-            cout << indent << "Assign: " << s->varName << " =" << endl;
-            printAST(s->value, level + 1);
-            break;
+        else if (arg == "--stream") options.stream = true;
+        else if (arg == "--simulate") options.simulate = true;
+        else if (arg == "--interp") options.interpret = true;
+        else if (arg == "--run") options.run = true;
+        else if (arg == "--emit-ir") options.emitIR = true;
+        else if (arg == "--from-ir") options.fromIR = true;
+        else if (arg == "--server") serverSocket = argv[++i];
+        else if (arg == "--connect") connectSocket = argv[++i];
+        else if (arg == "--stop") stopServer = true;
+        else if (arg == "--cache-dir") cacheDir = argv[++i];
+        else if (arg == "--cache-size") cacheSizeMB = strtoull(argv[++i], nullptr, 10);
+        else if (!arg.empty() && arg[0] == '-') {
+            cerr << "Error: Unknown option '" << arg << "'" << endl;
+            printUsage(argv[0]);
+            return 1;
         }
-        case NODE_BINARY_EXPR: {
-            BinaryExpr* s = (BinaryExpr*)node;
-            cout << indent << "Op: " << s->op << endl;
-            printAST(s->left, level + 1);
-            printAST(s->right, level + 1);
-            break;
+        else inputs.push_back(arg);
+    }
+
+    if ((timeReport || !traceFile.empty()) && !instrumentEnabled()) {
+        cerr << "Warning: -ftime-report / -ftrace need a build with 'make INSTRUMENT=1', ignored" << endl;
+        timeReport = false;
+        traceFile.clear();
+    }
+
+    // 计数文件只读取一次，所有任务共享
+    if (!profileUseFile.empty()) {
+        string error;
+        if (!profile.load(profileUseFile, error)) {
+            cerr << "Error: " << error << endl;
+            return 1;
         }
-        case NODE_NUMBER: {
-            cout << indent << ((NumberNode*)node)->value << endl;
-            break;
+        options.profileUse = &profile;
+    }
+
+    unique_ptr<CompileCache> cache;
+    if (!cacheDir.empty()) {
+        cache = make_unique<CompileCache>(cacheDir, cacheSizeMB * 1024 * 1024);
+        options.cache = cache.get();
+    }
+
+    // 服务模式：不需要输入文件，也不输出调试信息
+    if (!serverSocket.empty()) {
+        if (!options.profileGenerate.empty() || options.run || options.format != FORMAT_ASM) {
+            cerr << "Error: --profile-generate / --run / --format cannot be used with --server" << endl;
+            return 1;
         }
-        case NODE_IDENTIFIER: {
-            cout << indent << "Id: " << ((IdNode*)node)->name << endl;
-            break;
+        options.dumpAST = options.dumpIR = false;
+        ThreadPool pool(threads);
+        int rc = runServer(serverSocket, options, pool);
+        if (cache) {
+            cache->evict();
+            cache->printStats(cerr);
         }
+        return rc;
     }
-}
 
-int main(int argc, char* argv[]) {
     // 检查命令行参数
-    if (argc < 2) {
-        cerr << "Usage: " << argv[0] << " <source_file>" << endl;
-        cerr << "Example: " << argv[0] << " program.txt" << endl;
+    if (inputs.empty() && !(stopServer && !connectSocket.empty())) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!outputFile.empty() && inputs.size() > 1) {
+        cerr << "Error: -o can only be used with a single source file, use -d instead" << endl;
         return 1;
     }
 
-    string filename = argv[1];
-    
-    // 读取源代码文件
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Error: Cannot open file '" << filename << "'" << endl;
+    if (options.emitIR && (options.fromIR || options.stream)) {
+        cerr << "Error: --emit-ir cannot be combined with --from-ir or --stream" << endl;
+        return 1;
+    }
+    if (options.simulate && (options.emitIR || !options.emitAsm || !connectSocket.empty())) {
+        cerr << "Error: --simulate requires assembly output" << endl;
+        return 1;
+    }
+    if (options.run && (options.simulate || options.fromIR || options.stream || options.emitIR || !options.emitAsm ||
+                        !connectSocket.empty())) {
+        cerr << "Error: --run needs a normal source compile and cannot be combined with --simulate" << endl;
+        return 1;
+    }
+    if (options.interpret && (options.stream || !connectSocket.empty())) {
+        cerr << "Error: --interp needs the whole program and cannot be combined with --stream or --connect" << endl;
+        return 1;
+    }
+    if ((!options.profileGenerate.empty() || options.profileUse) &&
+        (options.fromIR || options.stream || options.emitIR || !options.emitAsm || !connectSocket.empty())) {
+        cerr << "Error: --profile-generate / --profile-use need a normal source compile to assembly" << endl;
+        return 1;
+    }
+    if (options.format != FORMAT_ASM && (options.fromIR || options.stream || options.emitIR || options.run ||
+                                         !options.emitAsm || !connectSocket.empty())) {
+        cerr << "Error: --format=elf/bin needs a normal source compile to assembly" << endl;
+        return 1;
+    }
+    if (!options.profileGenerate.empty() && inputs.size() > 1) {
+        cerr << "Error: --profile-generate can only be used with a single source file" << endl;
+        return 1;
+    }
+    if ((options.dumpAST || options.dumpIR || !options.emitAsm) &&
+        (options.fromIR || options.stream || options.emitIR || !connectSocket.empty())) {
+        cerr << "Error: --emit=ast/ir requires a normal source compile" << endl;
         return 1;
     }
 
-    stringstream buffer;
-    buffer << file.rdbuf();
-    string code = buffer.str();
-    file.close();
+    // 确定每个输入的输出文件名
+    // 单个输入且未指定输出时保持原来的 output.asm
+    string ext = options.emitIR                 ? ".qir"
+                 : options.format == FORMAT_ELF ? ".o"
+                 : options.format == FORMAT_BIN ? ".bin"
+                                                : ".asm";
+    vector<CompileJob> jobs;
+    set<string> outputs;
+    for (auto& in : inputs) {
+        string out;
+        if (!outputFile.empty()) out = outputFile;
+        else if (inputs.size() == 1 && outputDir.empty()) out = "output" + ext;
+        else out = (outputDir.empty() ? "" : outputDir + "/") + fileStem(in) + ext;
 
-    if (code.empty()) {
-        cerr << "Warning: File is empty" << endl;
-        return 1;
+        if (!outputs.insert(out).second) {
+            cerr << "Error: Multiple inputs would write to '" << out << "'" << endl;
+            return 1;
+        }
+        jobs.push_back({in, out});
+    }
+
+    if (!connectSocket.empty()) return runClient(connectSocket, jobs, stopServer);
+
+    // 并发编译，结果按输入顺序输出，保证日志与诊断信息是确定的
+    vector<CompileResult> results(jobs.size());
+    vector<bool> finished(jobs.size(), false);
+    size_t nextToPrint = 0;
+    int failures = 0;
+    mutex printLock;
+
+    ThreadPool pool(threads);
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        pool.submit([&, i] {
+            CompileResult r = compileFile(jobs[i], options, &pool);
+
+            lock_guard<mutex> guard(printLock);
+            results[i] = move(r);
+            finished[i] = true;
+            // 前面的任务都已完成时立即打印并释放，不必等到全部结束
+            while (nextToPrint < jobs.size() && finished[nextToPrint]) {
+                CompileResult& done = results[nextToPrint];
+                cout << done.log;
+                cerr << done.diagnostics;
+                if (!done.success) failures++;
+                done = CompileResult();
+                nextToPrint++;
+            }
+        });
+    }
+    pool.wait();
+
+    if (options.passStats) passStats.print(cerr);
+    if (timeReport) instrPrintReport(cerr);
+    if (!traceFile.empty() && !instrWriteTrace(traceFile)) {
+        cerr << "Error: Cannot write trace file '" << traceFile << "'" << endl;
+        failures++;
+    }
+
+    if (cache) {
+        cache->evict();
+        cache->printStats(cerr);
     }
 
-    cout << "Source File: " << filename << endl;
-    cout << "Parsing Source Code..." << endl;
-
-    Lexer lexer(code);
-    Parser parser(lexer);
-    
-    ASTNode* root = parser.parse();
-    
-    cout << "\nGenerated AST Structure:" << endl;
-    cout << "========================" << endl;
-    printAST(root);
-    cout << endl;
-
-    // 生成中间代码
-    InterCodeGenerator interGen;
-    interGen.generate(root);
-    cout << "\nGenerated Intermediate Code:" << endl;
-    cout << "==============================" << endl;
-    interGen.printCodes();
-
-    // 生成汇编代码
-    AsmGenerator asmGen(interGen.getCodes());
-    asmGen.generate("output.asm");
-    cout << "Compilation completed successfully!" << endl;
-
-    return 0;
+    return failures == 0 ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "mipsenc.h"
+#include "asmgen.h"
+
+// 用到的寄存器编号
+static const int REG_ZERO = 0;
+static const int REG_AT = 1;
+static const int REG_V0 = 2;
+static const int REG_SP = 29;
+static const int REG_RA = 31;
+
+// 操作码与功能码
+enum {
+    OPC_SPECIAL = 0x00, OPC_J = 0x02, OPC_JAL = 0x03, OPC_BEQ = 0x04, OPC_BNE = 0x05, OPC_ADDI = 0x08,
+    OPC_ORI = 0x0D, OPC_LUI = 0x0F, OPC_LW = 0x23, OPC_SW = 0x2B
+};
+enum {
+    FN_JR = 0x08, FN_MFLO = 0x12, FN_MULT = 0x18, FN_DIV = 0x1A, FN_ADD = 0x20, FN_SUB = 0x22
+};
+
+static uint32_t rType(int rs, int rt, int rd, int funct) {
+    return ((uint32_t)OPC_SPECIAL << 26) | (rs << 21) | (rt << 16) | (rd << 11) | funct;
+}
+
+static uint32_t iType(int opcode, int rs, int rt, int32_t imm) {
+    return ((uint32_t)opcode << 26) | (rs << 21) | (rt << 16) | ((uint32_t)imm & 0xFFFF);
+}
+
+static const char* const PROGRAM_END = "Program_End";
+static const char* const PROGRAM_ENTRY = "Program_Entry";
+
+/**
+ * 指令字输出：与 MipsAsmEmitter 逐条对应，跳转目标留到链接时解析
+ */
+class MipsBinaryEmitter : public TargetEmitter {
+private:
+    MipsFunction& fn;
+
+    void emit(uint32_t word) { fn.code.push_back({MipsInstr::FIXED, word, ""}); }
+
+    // lw / sw 的偏移只有 16 位；更大的栈帧先用 $at 算出高位地址
+    void frameAccess(int opcode, int reg, int offset) {
+        if (offset >= -32768 && offset <= 32767) {
+            emit(iType(opcode, REG_SP, reg, offset));
+            return;
+        }
+        int32_t high = (int32_t)(((uint32_t)offset + 0x8000) >> 16);
+        emit(iType(OPC_LUI, REG_ZERO, REG_AT, high));
+        emit(rType(REG_AT, REG_SP, REG_AT, FN_ADD));
+        emit(iType(opcode, REG_AT, reg, offset));
+    }
+
+public:
+    explicit MipsBinaryEmitter(MipsFunction& f) : fn(f) {}
+
+    vector<int> allocatableRegs() const override { return mipsAllocatableRegs(); }
+
+    void funcBegin(const string& name) override {
+        fn.labels[name] = (int)fn.code.size();
+        fn.functions.push_back({name, (int)fn.code.size()});
+    }
+
+    void label(const string& name) override { fn.labels[name] = (int)fn.code.size(); }
+
+    void loadImm(int reg, int32_t val) override {
+        if (val >= -32768 && val <= 32767) {
+            emit(iType(OPC_ADDI, REG_ZERO, reg, val));
+            return;
+        }
+        int upper = (val >> 16) & 0xFFFF;
+        int lower = val & 0xFFFF;
+        emit(iType(OPC_LUI, REG_ZERO, reg, upper));
+        if (lower != 0) emit(iType(OPC_ORI, reg, reg, lower));
+    }
+
+    void load(int reg, int offset) override { frameAccess(OPC_LW, reg, offset); }
+    void store(int reg, int offset) override { frameAccess(OPC_SW, reg, offset); }
+
+    void arith(QuadOp op, int rd, int rs, int rt) override {
+        switch (op) {
+            case OP_ADD: emit(rType(rs, rt, rd, FN_ADD)); break;
+            case OP_SUB: emit(rType(rs, rt, rd, FN_SUB)); break;
+            case OP_MUL:
+                emit(rType(rs, rt, 0, FN_MULT));
+                emit(rType(0, 0, rd, FN_MFLO));
+                break;
+            case OP_DIV:
+                emit(rType(rs, rt, 0, FN_DIV));
+                emit(rType(0, 0, rd, FN_MFLO));
+                break;
+            default: break;
+        }
+    }
+
+    void jump(const string& target) override {
+        fn.code.push_back({MipsInstr::JUMP, (uint32_t)OPC_J << 26, target});
+    }
+
+    void branch(QuadOp op, int rs, int rt, const string& target) override {
+        fn.code.push_back({MipsInstr::BRANCH, iType(op == OP_JEQ ? OPC_BEQ : OPC_BNE, rs, rt, 0), target});
+    }
+
+    void ret(int reg) override {
+        emit(rType(reg >= 0 ? reg : REG_ZERO, REG_ZERO, REG_V0, FN_ADD));
+        emit(rType(REG_RA, 0, 0, FN_JR));
+    }
+
+    void call(const string& name, int frameBytes, int raOffset) override {
+        frameAccess(OPC_SW, REG_RA, raOffset);
+        if (frameBytes < 32768) {
+            emit(iType(OPC_ADDI, REG_SP, REG_SP, -frameBytes));
+            fn.code.push_back({MipsInstr::JUMP, (uint32_t)OPC_JAL << 26, name});
+            emit(iType(OPC_ADDI, REG_SP, REG_SP, frameBytes));
+        } else {
+            loadImm(REG_AT, frameBytes);
+            emit(rType(REG_SP, REG_AT, REG_SP, FN_SUB));
+            fn.code.push_back({MipsInstr::JUMP, (uint32_t)OPC_JAL << 26, name});
+            loadImm(REG_AT, frameBytes);
+            emit(rType(REG_SP, REG_AT, REG_SP, FN_ADD));
+        }
+        frameAccess(OPC_LW, REG_RA, raOffset);
+    }
+
+    void result(int reg) override { emit(rType(REG_V0, REG_ZERO, reg, FN_ADD)); }
+};
+
+MipsFunction mipsEncode(const vector<Quad>& codes, const map<string, long long>* weights) {
+    MipsFunction fn;
+    fn.code.reserve(codes.size() * 3);
+    MipsBinaryEmitter emitter(fn);
+    Lowering lowering(emitter);
+    lowering.setVarWeights(weights);
+    lowering.lower(codes);
+    return fn;
+}
+
+/**
+ * 链接：地址以字为单位，从 0 开始
+ * 松弛是单调的（分支只会从短变长），反复计算地址直到没有新的越界分支
+ */
+bool mipsLink(const vector<MipsFunction>& parts, MipsObject& out, string& error) {
+    out = MipsObject();
+
+    // 程序头、各段、入口跳板、Program_End 死循环拼成一个指令序列
+    vector<const MipsInstr*> items;
+    map<string, int> labels;
+    vector<pair<string, int>> functions;
+    vector<string> names;
+    for (auto& part : parts) {
+        for (auto& f : part.functions) names.push_back(f.first);
+    }
+    string entry = entryFunction(names);
+    const MipsInstr header[] = {
+        {MipsInstr::FIXED, iType(OPC_ADDI, REG_ZERO, REG_SP, 1024), ""},
+        {MipsInstr::JUMP, (uint32_t)OPC_JAL << 26, PROGRAM_ENTRY},
+        {MipsInstr::JUMP, (uint32_t)OPC_J << 26, PROGRAM_END},
+    };
+    MipsInstr trampoline{MipsInstr::JUMP, (uint32_t)OPC_J << 26, entry};
+    MipsInstr footer{MipsInstr::JUMP, (uint32_t)OPC_J << 26, PROGRAM_END};
+    for (auto& in : header) items.push_back(&in);
+    for (auto& part : parts) {
+        int base = (int)items.size();
+        for (auto& l : part.labels) {
+            if (!labels.emplace(l.first, base + l.second).second) {
+                error = "duplicate label '" + l.first + "'";
+                return false;
+            }
+        }
+        for (auto& f : part.functions) functions.push_back({f.first, base + f.second});
+        for (auto& in : part.code) items.push_back(&in);
+    }
+    // 没有函数时跳板为空，Program_Entry 与 Program_End 是同一条指令
+    int entryAt = (int)items.size();
+    int endAt = entryAt + (entry.empty() ? 0 : 1);
+    for (auto& l : {make_pair(PROGRAM_ENTRY, entryAt), make_pair(PROGRAM_END, endAt)}) {
+        if (!labels.emplace(l.first, l.second).second) {
+            error = string("duplicate label '") + l.first + "'";
+            return false;
+        }
+    }
+    if (!entry.empty()) items.push_back(&trampoline);
+    items.push_back(&footer);
+
+    int n = (int)items.size();
+    vector<int> target(n, -1);
+    for (int i = 0; i < n; ++i) {
+        if (items[i]->kind == MipsInstr::FIXED) continue;
+        auto it = labels.find(items[i]->target);
+        if (it == labels.end()) {
+            error = "undefined label '" + items[i]->target + "'";
+            return false;
+        }
+        target[i] = it->second;
+    }
+
+    vector<char> relaxed(n, 0);
+    vector<int64_t> addr(n + 1);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        addr[0] = 0;
+        for (int i = 0; i < n; ++i) addr[i + 1] = addr[i] + (relaxed[i] ? 2 : 1);
+        for (int i = 0; i < n; ++i) {
+            if (items[i]->kind != MipsInstr::BRANCH || relaxed[i]) continue;
+            int64_t offset = addr[target[i]] - (addr[i] + 1);
+            if (offset < -32768 || offset > 32767) {
+                relaxed[i] = 1;
+                out.relaxedBranches++;
+                changed = true;
+            }
+        }
+    }
+    // j / jal 只能在同一个 256MB 区域内跳转
+    if (addr[n] > (1 << 26)) {
+        error = "program does not fit in one 256MB jump region";
+        return false;
+    }
+
+    out.text.reserve(addr[n]);
+    auto emitJump = [&](uint32_t opcode, int t) {
+        out.jumpRelocs.push_back((uint32_t)out.text.size() * 4);
+        out.text.push_back((opcode << 26) | (uint32_t)addr[t]);
+    };
+    for (int i = 0; i < n; ++i) {
+        const MipsInstr& in = *items[i];
+        if (in.kind == MipsInstr::FIXED) {
+            out.text.push_back(in.word);
+        } else if (in.kind == MipsInstr::JUMP) {
+            emitJump(in.word >> 26, target[i]);
+        } else if (!relaxed[i]) {
+            out.text.push_back(in.word | ((uint32_t)(addr[target[i]] - (addr[i] + 1)) & 0xFFFF));
+        } else {
+            // beq 与 bne 的操作码只差最低位：取反后跳过下一条 j
+            out.text.push_back((in.word ^ (1u << 26)) | 1);
+            emitJump(OPC_J, target[i]);
+        }
+    }
+    for (auto& f : functions) out.functions.push_back({f.first, (uint32_t)addr[f.second] * 4});
+    out.programEntry = (uint32_t)addr[labels[PROGRAM_ENTRY]] * 4;
+    out.programEnd = (uint32_t)addr[n - 1] * 4;
+    return true;
+}
+
+// 大端序写入
+static void put16(string& s, uint32_t v) {
+    s.push_back((char)(v >> 8));
+    s.push_back((char)v);
+}
+
+static void put32(string& s, uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) s.push_back((char)(v >> shift));
+}
+
+string mipsRawImage(const MipsObject& obj) {
+    string image;
+    image.reserve(obj.text.size() * 4);
+    for (uint32_t w : obj.text) put32(image, w);
+    return image;
+}
+
+/**
+ * 可重定位目标文件：.text / .data / .rel.text / .symtab / .strtab / .shstrtab
+ * j 的目标字段中保存段内偏移（REL 格式的加数），由 R_MIPS_26 针对 .text 段符号重定位
+ */
+string mipsElfObject(const MipsObject& obj) {
+    enum { SEC_NULL, SEC_TEXT, SEC_DATA, SEC_REL, SEC_SYMTAB, SEC_STRTAB, SEC_SHSTRTAB, SEC_COUNT };
+    const uint32_t SHT_PROGBITS = 1, SHT_SYMTAB = 2, SHT_STRTAB = 3, SHT_REL = 9;
+    const uint32_t SHF_WRITE = 1, SHF_ALLOC = 2, SHF_EXECINSTR = 4, SHF_INFO_LINK = 0x40;
+    const uint32_t R_MIPS_26 = 4;
+    const uint8_t STB_LOCAL = 0, STB_GLOBAL = 1, STT_NOTYPE = 0, STT_FUNC = 2, STT_SECTION = 3;
+    // EF_MIPS_ARCH_32 | EF_MIPS_ABI_O32 | EF_MIPS_NOREORDER
+    const uint32_t E_FLAGS = 0x50000000 | 0x00001000 | 0x1;
+
+    string shstrtab(1, '\0');
+    uint32_t secName[SEC_COUNT] = {};
+    const char* names[SEC_COUNT] = {"", ".text", ".data", ".rel.text", ".symtab", ".strtab", ".shstrtab"};
+    for (int i = 1; i < SEC_COUNT; ++i) {
+        secName[i] = (uint32_t)shstrtab.size();
+        shstrtab += names[i];
+        shstrtab.push_back('\0');
+    }
+
+    // 符号表：局部符号在前（段符号、Program_Entry、Program_End），全局符号为入口 _start 和各个函数
+    string strtab(1, '\0');
+    string symtab;
+    auto addSymbol = [&](const string& name, uint32_t value, uint32_t size, uint8_t bind, uint8_t type,
+                         uint16_t shndx) {
+        uint32_t nameOff = 0;
+        if (!name.empty()) {
+            nameOff = (uint32_t)strtab.size();
+            strtab += name;
+            strtab.push_back('\0');
+        }
+        put32(symtab, nameOff);
+        put32(symtab, value);
+        put32(symtab, size);
+        symtab.push_back((char)((bind << 4) | type));
+        symtab.push_back(0);
+        put16(symtab, shndx);
+    };
+    addSymbol("", 0, 0, STB_LOCAL, STT_NOTYPE, 0);
+    addSymbol("", 0, 0, STB_LOCAL, STT_SECTION, SEC_TEXT);   // 符号 1：重定位使用
+    addSymbol("", 0, 0, STB_LOCAL, STT_SECTION, SEC_DATA);
+    addSymbol(PROGRAM_ENTRY, obj.programEntry, obj.programEnd - obj.programEntry, STB_LOCAL, STT_NOTYPE, SEC_TEXT);
+    addSymbol(PROGRAM_END, obj.programEnd, 4, STB_LOCAL, STT_NOTYPE, SEC_TEXT);
+    uint32_t firstGlobal = 5;
+    bool hasStart = false;
+    for (auto& f : obj.functions) hasStart = hasStart || f.first == "_start";
+    if (!hasStart) addSymbol("_start", 0, 0, STB_GLOBAL, STT_NOTYPE, SEC_TEXT);
+    for (size_t i = 0; i < obj.functions.size(); ++i) {
+        uint32_t end = i + 1 < obj.functions.size() ? obj.functions[i + 1].second : obj.programEntry;
+        addSymbol(obj.functions[i].first, obj.functions[i].second, end - obj.functions[i].second, STB_GLOBAL,
+                  STT_FUNC, SEC_TEXT);
+    }
+
+    string rel;
+    for (uint32_t off : obj.jumpRelocs) {
+        put32(rel, off);
+        put32(rel, (1u << 8) | R_MIPS_26);
+    }
+
+    // 文件布局：ELF 头、各段内容（4 字节对齐）、段头表
+    string file;
+    const uint32_t EHSIZE = 52, SHENTSIZE = 40;
+    file.resize(EHSIZE);
+    uint32_t offset[SEC_COUNT] = {}, size[SEC_COUNT] = {};
+    auto place = [&](int sec, const string& data) {
+        while (file.size() % 4) file.push_back('\0');
+        offset[sec] = (uint32_t)file.size();
+        size[sec] = (uint32_t)data.size();
+        file += data;
+    };
+    place(SEC_TEXT, mipsRawImage(obj));
+    place(SEC_DATA, "");
+    place(SEC_REL, rel);
+    place(SEC_SYMTAB, symtab);
+    place(SEC_STRTAB, strtab);
+    place(SEC_SHSTRTAB, shstrtab);
+    while (file.size() % 4) file.push_back('\0');
+    uint32_t shoff = (uint32_t)file.size();
+
+    struct SectionHeader {
+        uint32_t type, flags, link, info, align, entsize;
+    };
+    const SectionHeader headers[SEC_COUNT] = {
+        {0, 0, 0, 0, 0, 0},
+        {SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 0, 0, 4, 0},
+        {SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, 0, 0, 4, 0},
+        {SHT_REL, SHF_INFO_LINK, SEC_SYMTAB, SEC_TEXT, 4, 8},
+        {SHT_SYMTAB, 0, SEC_STRTAB, firstGlobal, 4, 16},
+        {SHT_STRTAB, 0, 0, 0, 1, 0},
+        {SHT_STRTAB, 0, 0, 0, 1, 0},
+    };
+    for (int i = 0; i < SEC_COUNT; ++i) {
+        put32(file, secName[i]);
+        put32(file, headers[i].type);
+        put32(file, headers[i].flags);
+        put32(file, 0);           // sh_addr
+        put32(file, offset[i]);
+        put32(file, size[i]);
+        put32(file, headers[i].link);
+        put32(file, headers[i].info);
+        put32(file, headers[i].align);
+        put32(file, headers[i].entsize);
+    }
+
+    string ehdr = {'\x7f', 'E', 'L', 'F', 1 /* ELFCLASS32 */, 2 /* ELFDATA2MSB */, 1 /* EV_CURRENT */};
+    ehdr.resize(16, '\0');
+    put16(ehdr, 1);               // ET_REL
+    put16(ehdr, 8);               // EM_MIPS
+    put32(ehdr, 1);               // e_version
+    put32(ehdr, 0);               // e_entry
+    put32(ehdr, 0);               // e_phoff
+    put32(ehdr, shoff);
+    put32(ehdr, E_FLAGS);
+    put16(ehdr, EHSIZE);
+    put16(ehdr, 0);               // e_phentsize
+    put16(ehdr, 0);               // e_phnum
+    put16(ehdr, SHENTSIZE);
+    put16(ehdr, SEC_COUNT);
+    put16(ehdr, SEC_SHSTRTAB);
+    file.replace(0, EHSIZE, ehdr);
+    return file;
+}
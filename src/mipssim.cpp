@@ -0,0 +1,457 @@
+#include "mipssim.h"
+#include "asmgen.h"
+#include <unordered_map>
+#include <cstdlib>
+#include <climits>
+#include <cstdio>
+
+// 内存大小（字），地址 0 位于中间
+static const int64_t MEM_WORDS = 1 << 20;
+
+// 乘法器 / 除法器的延迟（周期），在此之前读取 HI/LO 需要等待
+static const long long MULT_LATENCY = 4;
+static const long long DIV_LATENCY = 32;
+
+static const char* OP_NAMES[MOP_COUNT] = {
+    "addi", "lui", "ori", "add", "sub", "mult", "div", "mflo", "mfhi",
+    "lw", "sw", "beq", "bne", "j", "jal", "jr"
+};
+
+const char* MipsSimulator::opName(MipsOp op) {
+    return (op >= 0 && op < MOP_COUNT) ? OP_NAMES[op] : "?";
+}
+
+MipsSimulator::MipsSimulator() : hi(0), lo(0), maxSteps(1000000000LL) {
+    for (int i = 0; i < 32; ++i) regs[i] = 0;
+}
+
+void MipsSimulator::setMaxSteps(long long n) {
+    maxSteps = n;
+}
+
+int32_t MipsSimulator::result() const {
+    return regs[2];
+}
+
+const SimStats& MipsSimulator::getStats() const {
+    return stats;
+}
+
+static string trim(const string& s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// 寄存器：$t0 这样的名字或 $8 这样的编号
+static bool parseReg(const string& s, int& reg) {
+    static unordered_map<string, int> names = [] {
+        unordered_map<string, int> m;
+        for (int i = 0; i < 32; ++i) m[REG_NAMES[i]] = i;
+        m["$s8"] = 30;
+        return m;
+    }();
+    auto it = names.find(s);
+    if (it != names.end()) { reg = it->second; return true; }
+    if (s.size() < 2 || s[0] != '$') return false;
+    char* end;
+    long v = strtol(s.c_str() + 1, &end, 10);
+    if (*end != '\0' || v < 0 || v > 31) return false;
+    reg = (int)v;
+    return true;
+}
+
+static bool parseImm(const string& s, long long& v) {
+    if (s.empty()) return false;
+    char* end;
+    v = strtoll(s.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+/**
+ * 汇编：两遍扫描，第一遍解码指令并记录标签位置，第二遍回填跳转目标
+ * 支持的语法就是 AsmGenerator 的输出：每行一条指令或一个 "标签:"，.data / .text 伪指令被忽略
+ */
+bool MipsSimulator::assemble(const string& text, string& error) {
+    program.clear();
+    unordered_map<string, int> labels;
+    vector<pair<int, string>> fixups; // 指令下标 -> 目标标签
+
+    int lineNo = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t nl = text.find('\n', pos);
+        if (nl == string::npos) nl = text.size();
+        string line = text.substr(pos, nl - pos);
+        pos = nl + 1;
+        lineNo++;
+
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+        line = trim(line);
+
+        // 行首的标签，可能后面还跟着指令
+        size_t colon;
+        while ((colon = line.find(':')) != string::npos && line.find_first_of(" \t") > colon) {
+            string name = line.substr(0, colon);
+            if (name.empty() || !labels.emplace(name, (int)program.size()).second) {
+                error = "line " + to_string(lineNo) + ": " + (name.empty() ? "empty label" : "duplicate label '" + name + "'");
+                return false;
+            }
+            line = trim(line.substr(colon + 1));
+        }
+        if (line.empty() || line[0] == '.') continue;
+
+        // 助记符和以逗号分隔的操作数
+        size_t sp = line.find_first_of(" \t");
+        string mnemonic = line.substr(0, sp);
+        vector<string> ops;
+        if (sp != string::npos) {
+            string rest = line.substr(sp);
+            size_t start = 0;
+            while (start <= rest.size()) {
+                size_t comma = rest.find(',', start);
+                if (comma == string::npos) comma = rest.size();
+                ops.push_back(trim(rest.substr(start, comma - start)));
+                start = comma + 1;
+            }
+        }
+
+        int op = -1;
+        for (int i = 0; i < MOP_COUNT; ++i) {
+            if (mnemonic == OP_NAMES[i]) { op = i; break; }
+        }
+        auto fail = [&](const string& msg) {
+            error = "line " + to_string(lineNo) + ": " + msg;
+            return false;
+        };
+        if (op < 0) return fail("unsupported instruction '" + mnemonic + "'");
+
+        MipsInst inst{(MipsOp)op, 0, 0, 0, 0, -1, lineNo};
+        auto expect = [&](size_t n) {
+            return ops.size() == n;
+        };
+        long long v = 0;
+        bool ok = true;
+        switch (inst.op) {
+            case MOP_ADDI:
+            case MOP_ORI:
+                ok = expect(3) && parseReg(ops[0], inst.rd) && parseReg(ops[1], inst.rs) && parseImm(ops[2], v);
+                if (ok && inst.op == MOP_ADDI && (v < -32768 || v > 32767)) return fail("immediate out of range");
+                if (ok && inst.op == MOP_ORI && (v < 0 || v > 0xFFFF)) return fail("immediate out of range");
+                inst.imm = (int32_t)v;
+                break;
+            case MOP_LUI:
+                ok = expect(2) && parseReg(ops[0], inst.rd) && parseImm(ops[1], v);
+                if (ok && (v < 0 || v > 0xFFFF)) return fail("immediate out of range");
+                inst.imm = (int32_t)v;
+                break;
+            case MOP_ADD:
+            case MOP_SUB:
+                ok = expect(3) && parseReg(ops[0], inst.rd) && parseReg(ops[1], inst.rs) && parseReg(ops[2], inst.rt);
+                break;
+            case MOP_MULT:
+            case MOP_DIV:
+                ok = expect(2) && parseReg(ops[0], inst.rs) && parseReg(ops[1], inst.rt);
+                break;
+            case MOP_MFLO:
+            case MOP_MFHI:
+                ok = expect(1) && parseReg(ops[0], inst.rd);
+                break;
+            case MOP_LW:
+            case MOP_SW: {
+                // 形如 -4($sp)
+                ok = expect(2) && parseReg(ops[0], inst.op == MOP_LW ? inst.rd : inst.rt);
+                size_t lp = ok ? ops[1].find('(') : string::npos;
+                ok = ok && lp != string::npos && ops[1].back() == ')';
+                if (ok) {
+                    string off = trim(ops[1].substr(0, lp));
+                    ok = (off.empty() || parseImm(off, v)) &&
+                         parseReg(trim(ops[1].substr(lp + 1, ops[1].size() - lp - 2)), inst.rs);
+                    inst.imm = off.empty() ? 0 : (int32_t)v;
+                }
+                break;
+            }
+            case MOP_BEQ:
+            case MOP_BNE:
+                ok = expect(3) && parseReg(ops[0], inst.rs) && parseReg(ops[1], inst.rt);
+                if (ok) fixups.push_back({(int)program.size(), ops[2]});
+                break;
+            case MOP_J:
+            case MOP_JAL:
+                ok = expect(1);
+                if (ok) fixups.push_back({(int)program.size(), ops[0]});
+                break;
+            case MOP_JR:
+                ok = expect(1) && parseReg(ops[0], inst.rs);
+                break;
+            default: break;
+        }
+        if (!ok) return fail("malformed operands for '" + mnemonic + "'");
+        program.push_back(inst);
+    }
+
+    for (auto& f : fixups) {
+        auto it = labels.find(f.second);
+        if (it == labels.end()) {
+            error = "line " + to_string(program[f.first].line) + ": undefined label '" + f.second + "'";
+            return false;
+        }
+        program[f.first].target = it->second;
+    }
+    return true;
+}
+
+/**
+ * 解码机器码：只接受 assemble 支持的指令子集
+ * 分支目标为 pc + 1 + 偏移，j / jal 的目标字段就是指令下标（代码从地址 0 开始）
+ */
+bool MipsSimulator::load(const vector<uint32_t>& words, string& error) {
+    program.clear();
+    program.reserve(words.size());
+    for (size_t i = 0; i < words.size(); ++i) {
+        uint32_t w = words[i];
+        int opcode = (int)(w >> 26);
+        int rs = (w >> 21) & 31, rt = (w >> 16) & 31, rd = (w >> 11) & 31;
+        int32_t simm = (int16_t)(w & 0xFFFF);
+        int line = (int)i + 1;
+        MipsInst inst{MOP_COUNT, 0, 0, 0, 0, -1, line};
+        switch (opcode) {
+            case 0x00:
+                switch (w & 0x3F) {
+                    case 0x20: inst = {MOP_ADD, rd, rs, rt, 0, -1, line}; break;
+                    case 0x22: inst = {MOP_SUB, rd, rs, rt, 0, -1, line}; break;
+                    case 0x18: inst = {MOP_MULT, 0, rs, rt, 0, -1, line}; break;
+                    case 0x1A: inst = {MOP_DIV, 0, rs, rt, 0, -1, line}; break;
+                    case 0x12: inst = {MOP_MFLO, rd, 0, 0, 0, -1, line}; break;
+                    case 0x10: inst = {MOP_MFHI, rd, 0, 0, 0, -1, line}; break;
+                    case 0x08: inst = {MOP_JR, 0, rs, 0, 0, -1, line}; break;
+                    default: break;
+                }
+                break;
+            case 0x08: inst = {MOP_ADDI, rt, rs, 0, simm, -1, line}; break;
+            case 0x0D: inst = {MOP_ORI, rt, rs, 0, (int32_t)(w & 0xFFFF), -1, line}; break;
+            case 0x0F: inst = {MOP_LUI, rt, 0, 0, (int32_t)(w & 0xFFFF), -1, line}; break;
+            case 0x23: inst = {MOP_LW, rt, rs, 0, simm, -1, line}; break;
+            case 0x2B: inst = {MOP_SW, 0, rs, rt, simm, -1, line}; break;
+            case 0x04: inst = {MOP_BEQ, 0, rs, rt, 0, (int)i + 1 + simm, line}; break;
+            case 0x05: inst = {MOP_BNE, 0, rs, rt, 0, (int)i + 1 + simm, line}; break;
+            case 0x02: inst = {MOP_J, 0, 0, 0, 0, (int)(w & 0x3FFFFFF), line}; break;
+            case 0x03: inst = {MOP_JAL, 0, 0, 0, 0, (int)(w & 0x3FFFFFF), line}; break;
+            default: break;
+        }
+        if (inst.op == MOP_COUNT) {
+            char hex[16];
+            snprintf(hex, sizeof(hex), "0x%08x", w);
+            error = "word " + to_string(line) + ": unsupported instruction " + hex;
+            return false;
+        }
+        program.push_back(inst);
+    }
+    return true;
+}
+
+/**
+ * 执行程序并统计
+ * 周期模型：每条指令发射占 1 个周期，流水线排空另加 4 个周期，再加上各类停顿：
+ *   - lw 的结果被下一条指令在 EX 级使用：1 周期
+ *   - beq / bne / jr 在 ID 级读取寄存器：前一条是 ALU 指令时 1 周期，是 lw 时 2 周期，前第二条是 lw 时 1 周期
+ *   - 跳转或分支成立：冲刷 1 条已取指令
+ *   - mflo / mfhi 以及新的乘除法要等待上一次乘除法完成
+ */
+bool MipsSimulator::run(string& error) {
+    for (int i = 0; i < 32; ++i) regs[i] = 0;
+    hi = lo = 0;
+    memory.assign(MEM_WORDS, 0);
+    stats = SimStats();
+
+    // 前两条指令写入的寄存器（-1 表示不写）以及它们是否为 lw
+    int prevDest[2] = {-1, -1};
+    bool prevLoad[2] = {false, false};
+    long long cycle = 0;
+    long long hiloReady = 0;
+
+    int pc = 0;
+    int n = (int)program.size();
+    while (true) {
+        if (pc < 0 || pc >= n) {
+            error = "execution left the program (pc = " + to_string(pc) + ")";
+            return false;
+        }
+        const MipsInst& in = program[pc];
+
+        // 跳转到自身：Program_End 死循环，程序结束
+        if (in.op == MOP_J && in.target == pc) break;
+
+        if (stats.instructions >= maxSteps) {
+            error = "step limit of " + to_string(maxSteps) + " instructions exceeded";
+            return false;
+        }
+        stats.instructions++;
+        stats.opCounts[in.op]++;
+
+        // 数据冒险
+        int srcA = -1, srcB = -1;
+        bool readsInID = false;
+        switch (in.op) {
+            case MOP_ADDI: case MOP_ORI: case MOP_LW: srcA = in.rs; break;
+            case MOP_ADD: case MOP_SUB: case MOP_MULT: case MOP_DIV: srcA = in.rs; srcB = in.rt; break;
+            case MOP_SW: srcA = in.rs; srcB = in.rt; break;
+            case MOP_BEQ: case MOP_BNE: srcA = in.rs; srcB = in.rt; readsInID = true; break;
+            case MOP_JR: srcA = in.rs; readsInID = true; break;
+            default: break;
+        }
+        auto uses = [&](int r) {
+            return r > 0 && (r == srcA || r == srcB);
+        };
+        long long stall = 0;
+        if (readsInID) {
+            if (uses(prevDest[0])) {
+                stall = prevLoad[0] ? 2 : 1;
+            } else if (uses(prevDest[1]) && prevLoad[1]) {
+                stall = 1;
+            }
+            stats.branchStalls += stall;
+        } else if (uses(prevDest[0]) && prevLoad[0]) {
+            stall = 1;
+            stats.loadUseStalls += stall;
+        }
+        cycle += 1 + stall;
+
+        if (in.op == MOP_MFLO || in.op == MOP_MFHI || in.op == MOP_MULT || in.op == MOP_DIV) {
+            if (cycle < hiloReady) {
+                stats.mulDivStalls += hiloReady - cycle;
+                cycle = hiloReady;
+            }
+        }
+
+        int dest = -1;
+        int next = pc + 1;
+        switch (in.op) {
+            case MOP_ADDI:
+                regs[in.rd] = (int32_t)((uint32_t)regs[in.rs] + (uint32_t)in.imm);
+                dest = in.rd;
+                break;
+            case MOP_LUI:
+                regs[in.rd] = (int32_t)((uint32_t)in.imm << 16);
+                dest = in.rd;
+                break;
+            case MOP_ORI:
+                regs[in.rd] = regs[in.rs] | in.imm;
+                dest = in.rd;
+                break;
+            case MOP_ADD:
+                regs[in.rd] = (int32_t)((uint32_t)regs[in.rs] + (uint32_t)regs[in.rt]);
+                dest = in.rd;
+                break;
+            case MOP_SUB:
+                regs[in.rd] = (int32_t)((uint32_t)regs[in.rs] - (uint32_t)regs[in.rt]);
+                dest = in.rd;
+                break;
+            case MOP_MULT: {
+                int64_t p = (int64_t)regs[in.rs] * (int64_t)regs[in.rt];
+                lo = (int32_t)(uint32_t)p;
+                hi = (int32_t)(uint32_t)((uint64_t)p >> 32);
+                hiloReady = cycle + MULT_LATENCY;
+                break;
+            }
+            case MOP_DIV: {
+                int32_t a = regs[in.rs], b = regs[in.rt];
+                if (b == 0) { lo = 0; hi = 0; }
+                else if (a == INT_MIN && b == -1) { lo = INT_MIN; hi = 0; }
+                else { lo = a / b; hi = a % b; }
+                hiloReady = cycle + DIV_LATENCY;
+                break;
+            }
+            case MOP_MFLO:
+                regs[in.rd] = lo;
+                dest = in.rd;
+                break;
+            case MOP_MFHI:
+                regs[in.rd] = hi;
+                dest = in.rd;
+                break;
+            case MOP_LW:
+            case MOP_SW: {
+                int32_t addr = (int32_t)((uint32_t)regs[in.rs] + (uint32_t)in.imm);
+                int64_t index = ((int64_t)addr >> 2) + MEM_WORDS / 2;
+                if ((addr & 3) != 0 || index < 0 || index >= MEM_WORDS) {
+                    error = "line " + to_string(in.line) + ": invalid memory address " + to_string(addr);
+                    return false;
+                }
+                if (in.op == MOP_LW) {
+                    regs[in.rd] = memory[index];
+                    dest = in.rd;
+                    stats.loads++;
+                } else {
+                    memory[index] = regs[in.rt];
+                    stats.stores++;
+                }
+                break;
+            }
+            case MOP_BEQ:
+            case MOP_BNE:
+                stats.branches++;
+                if ((regs[in.rs] == regs[in.rt]) == (in.op == MOP_BEQ)) {
+                    stats.takenBranches++;
+                    next = in.target;
+                }
+                break;
+            case MOP_J:
+                stats.jumps++;
+                next = in.target;
+                break;
+            case MOP_JAL:
+                stats.jumps++;
+                regs[31] = (pc + 1) * 4;
+                dest = 31;
+                next = in.target;
+                break;
+            case MOP_JR:
+                stats.jumps++;
+                next = regs[in.rs] / 4;
+                break;
+            default: break;
+        }
+        regs[0] = 0;
+
+        if (next != pc + 1) {
+            stats.flushStalls++;
+            cycle++;
+        }
+
+        prevDest[1] = prevDest[0];
+        prevLoad[1] = prevLoad[0];
+        prevDest[0] = dest;
+        prevLoad[0] = (in.op == MOP_LW);
+        pc = next;
+    }
+
+    // 最后一条指令离开流水线还需要 4 个周期
+    stats.cycles = cycle + (stats.instructions > 0 ? 4 : 0);
+    return true;
+}
+
+void MipsSimulator::printReport(ostream& out) const {
+    const SimStats& s = stats;
+    out << "Result ($v0): " << regs[2] << '\n';
+    out << "Instructions: " << s.instructions << '\n';
+    out << "Cycles: " << s.cycles;
+    if (s.instructions > 0) {
+        char cpi[32];
+        snprintf(cpi, sizeof(cpi), "%.3f", (double)s.cycles / s.instructions);
+        out << " (CPI " << cpi << ")";
+    }
+    out << '\n';
+    out << "Stalls: load-use " << s.loadUseStalls << ", branch operand " << s.branchStalls
+        << ", control flush " << s.flushStalls << ", mult/div " << s.mulDivStalls << '\n';
+    out << "Memory: " << s.loads << " loads, " << s.stores << " stores" << '\n';
+    out << "Control: " << s.branches << " branches (" << s.takenBranches << " taken), "
+        << s.jumps << " jumps" << '\n';
+    out << "By opcode:" << '\n';
+    for (int i = 0; i < MOP_COUNT; ++i) {
+        if (s.opCounts[i] == 0) continue;
+        out << "  " << OP_NAMES[i] << " " << s.opCounts[i] << '\n';
+    }
+}
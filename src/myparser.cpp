@@ -1,107 +1,207 @@
 #include "myparser.h"
-#include <cstdlib>
+#include "threadpool.h"
+#include "instrument.h"
+#include <vector>
+#include <algorithm>
+#include <memory>
 
-Parser::Parser(Lexer& lex) : lexer(lex) {
+Parser::Parser(Lexer& lex) : lexer(lex), tokenHash(0) {
     currentToken = lexer.nextToken();
 }
 
+// FNV-1a 64 位哈希参数
+static const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+/**
+ * 消费当前记号：把记号类型和文本计入当前函数的哈希，再读取下一个记号
+ * 哈希只依赖记号序列，空白和换行的变化不影响结果
+ */
+void Parser::advance() {
+    tokenHash = (tokenHash ^ (unsigned long long)currentToken.type) * FNV_PRIME;
+    for (unsigned char c : currentToken.value) tokenHash = (tokenHash ^ c) * FNV_PRIME;
+    tokenHash = (tokenHash ^ 0xFF) * FNV_PRIME; // 记号之间的分隔
+    currentToken = lexer.nextToken();
+}
+
+// 语法错误以异常退出解析，已经建立的结点由 NodePtr 或各个显式栈的 catch 释放（--server 长期运行）
+struct NodeDeleter {
+    void operator()(ASTNode* node) const { freeAST(node); }
+};
+template <class T>
+using NodePtr = unique_ptr<T, NodeDeleter>;
+
+void Parser::error(const string& msg) {
+    throw SyntaxError(msg, currentToken.line, currentToken.column);
+}
+
+// 当前记号的描述，如 "'='"、"identifier 'abc'"
+static string describe(const Token& tok) {
+    if (tok.type == TOK_ID || tok.type == TOK_NUM) return tokenName(tok.type) + " '" + tok.value + "'";
+    if (tok.type == TOK_ERROR) return "invalid character '" + tok.value + "'";
+    return tokenName(tok.type);
+}
+
 void Parser::eat(TokenType type) {
     if (currentToken.type == type) {
-        currentToken = lexer.nextToken();
+        advance();
     } else {
-        cerr << "Syntax Error: Expected token type " << type 
-             << " but got " << currentToken.type << " value: " << currentToken.value << endl;
-        exit(1);
+        error("expected " + tokenName(type) + " but got " + describe(currentToken));
     }
 }
 
-// Factor -> NUM | ID | ( Expr )
+// Factor -> NUM | ID
 ExprNode* Parser::parseFactor() {
     Token token = currentToken;
     if (token.type == TOK_NUM) {
+        int value;
+        try {
+            value = stoi(token.value);
+        } catch (const out_of_range&) {
+            error("integer literal '" + token.value + "' is out of range");
+        }
         eat(TOK_NUM);
-        return new NumberNode(stoi(token.value));
+        return new NumberNode(value);
     } else if (token.type == TOK_ID) {
         eat(TOK_ID);
         return new IdNode(token.value);
-    } else if (token.type == TOK_LPAREN) {
-        eat(TOK_LPAREN);
-        ExprNode* node = parseExpression();
-        eat(TOK_RPAREN);
-        return node;
     }
-    cerr << "Error: Unexpected token in Factor: " << token.value << endl;
-    exit(1);
-}
-
-// Term -> * /
-ExprNode* Parser::parseTerm() {
-    ExprNode* left = parseFactor();
-    while (currentToken.type == TOK_STAR || currentToken.type == TOK_SLASH) {
-        Token op = currentToken;
-        eat(op.type);
-        ExprNode* right = parseFactor();
-        left = new BinaryExpr(op.value, left, right);
-    }
-    return left;
+    error("expected expression but got " + describe(token));
 }
 
-// Expr -> + -
-ExprNode* Parser::parseExpression() {
-    ExprNode* left = parseTerm();
-    while (currentToken.type == TOK_PLUS || currentToken.type == TOK_MINUS) {
-        Token op = currentToken;
-        eat(op.type);
-        ExprNode* right = parseTerm();
-        left = new BinaryExpr(op.value, left, right);
-    }
-    return left;
+// 运算符优先级：* / 高于 + -，括号和调用标记为 0
+static int precedence(TokenType type) {
+    if (type == TOK_STAR || type == TOK_SLASH) return 2;
+    if (type == TOK_PLUS || type == TOK_MINUS) return 1;
+    return 0;
 }
 
-// Block -> { stmt... }
-BlockStmt* Parser::parseBlock() {
-    eat(TOK_LBRACE);
-    BlockStmt* block = new BlockStmt();
-    while (currentToken.type != TOK_RBRACE && currentToken.type != TOK_EOF) {
-        block->stmts.push_back(parseStatement());
+// Expr -> Term { (+|-) Term }
+// Term -> Factor { (*|/) Factor }
+// Factor -> NUM | ID | ID ( [Expr {, Expr}] ) | ( Expr )
+// 使用调度场算法：操作数栈 + 运算符栈都在堆上，任意深度的括号和调用嵌套都不会耗尽调用栈
+// 调用的左括号以函数名记号（TOK_ID）压入运算符栈，calls 记录其实参在操作数栈中的起点
+ExprNode* Parser::parseExpression(const string& leading) {
+    vector<ExprNode*> operands;
+    vector<Token> operators; // 包括尚未匹配的 '(' 和调用
+    vector<size_t> calls;
+    int openParens = 0;
+    string pendingId = leading;
+
+    // 用栈顶运算符归约栈顶的两个操作数
+    auto reduce = [&]() {
+        Token op = operators.back();
+        operators.pop_back();
+        ExprNode* right = operands.back(); operands.pop_back();
+        ExprNode* left = operands.back(); operands.pop_back();
+        operands.push_back(new BinaryExpr(op.value, left, right));
+    };
+    // 归约到最内层的 '(' 或调用为止
+    auto reduceGroup = [&]() {
+        while (operators.back().type != TOK_LPAREN && operators.back().type != TOK_ID) reduce();
+    };
+
+    try {
+        while (true) {
+            // 期望一个操作数：前面可以有任意多个 '(' 和 "f("
+            bool haveOperand = false;
+            while (!haveOperand) {
+                if (pendingId.empty() && currentToken.type == TOK_LPAREN) {
+                    operators.push_back(currentToken);
+                    eat(TOK_LPAREN);
+                    openParens++;
+                    continue;
+                }
+                if (pendingId.empty() && currentToken.type != TOK_ID) break;
+                string name = pendingId;
+                if (name.empty()) {
+                    name = currentToken.value;
+                    eat(TOK_ID);
+                }
+                pendingId.clear();
+                haveOperand = true;
+                if (currentToken.type != TOK_LPAREN) {
+                    operands.push_back(new IdNode(name));
+                    break;
+                }
+                eat(TOK_LPAREN);
+                if (currentToken.type == TOK_RPAREN) {
+                    eat(TOK_RPAREN);
+                    operands.push_back(new CallExpr(name, {}));
+                    break;
+                }
+                operators.push_back({TOK_ID, name});
+                calls.push_back(operands.size());
+                openParens++;
+                haveOperand = false;
+            }
+            if (!haveOperand) operands.push_back(parseFactor());
+
+            // 操作数之后：可以是若干个 ')'，实参之间的 ','，然后是二元运算符或表达式结束
+            bool nextArg = false;
+            while (openParens > 0) {
+                if (currentToken.type == TOK_RPAREN) {
+                    reduceGroup();
+                    if (operators.back().type == TOK_ID) {
+                        vector<ExprNode*> args(operands.begin() + calls.back(), operands.end());
+                        operands.resize(calls.back());
+                        calls.pop_back();
+                        operands.push_back(new CallExpr(operators.back().value, args));
+                    }
+                    operators.pop_back();
+                    eat(TOK_RPAREN);
+                    openParens--;
+                } else if (currentToken.type == TOK_COMMA) {
+                    reduceGroup();
+                    if (operators.back().type != TOK_ID) break; // 括号中的 ','：下面报告缺少 ')'
+                    eat(TOK_COMMA);
+                    nextArg = true;
+                    break;
+                } else {
+                    break;
+                }
+            }
+            if (nextArg) continue;
+
+            int prec = precedence(currentToken.type);
+            if (prec == 0) break;
+
+            // 左结合：先归约优先级不低于当前运算符的部分
+            while (!operators.empty() && precedence(operators.back().type) >= prec) reduce();
+            operators.push_back(currentToken);
+            eat(currentToken.type);
+        }
+
+        // 还有未闭合的括号
+        if (openParens > 0) eat(TOK_RPAREN);
+    } catch (...) {
+        for (ExprNode* e : operands) freeAST(e);
+        throw;
     }
-    eat(TOK_RBRACE);
-    return block;
+    while (!operators.empty()) reduce();
+    return operands.back();
 }
 
-// If -> if (expr) stmt [else stmt]
-StmtNode* Parser::parseIf() {
-    eat(TOK_IF);
+// ( expr )
+ExprNode* Parser::parseCondition() {
     eat(TOK_LPAREN);
-    ExprNode* cond = parseExpression();
+    NodePtr<ExprNode> cond(parseExpression());
     eat(TOK_RPAREN);
-    
-    StmtNode* thenStmt = parseStatement();
-    StmtNode* elseStmt = nullptr;
-    
-    if (currentToken.type == TOK_ELSE) {
-        eat(TOK_ELSE);
-        elseStmt = parseStatement();
-    }
-    return new IfStmt(cond, thenStmt, elseStmt);
+    return cond.release();
 }
 
-// While -> while (expr) stmt
-StmtNode* Parser::parseWhile() {
-    eat(TOK_WHILE);
-    eat(TOK_LPAREN);
-    ExprNode* cond = parseExpression();
-    eat(TOK_RPAREN);
-    StmtNode* body = parseStatement();
-    return new WhileStmt(cond, body);
+// Block -> { stmt... }
+BlockStmt* Parser::parseBlock() {
+    if (currentToken.type != TOK_LBRACE) eat(TOK_LBRACE);
+    return (BlockStmt*)parseStatement();
 }
 
 // Return -> return expr;
 StmtNode* Parser::parseReturn() {
     eat(TOK_RETURN);
-    ExprNode* val = parseExpression();
+    NodePtr<ExprNode> val(parseExpression());
     eat(TOK_SEMI);
-    return new ReturnStmt(val);
+    return new ReturnStmt(val.release());
 }
 
 // VarDecl -> int id [= expr];
@@ -109,40 +209,120 @@ StmtNode* Parser::parseVarDecl() {
     eat(TOK_INT);
     string name = currentToken.value;
     eat(TOK_ID);
-    ExprNode* init = nullptr;
+    NodePtr<ExprNode> init;
     if (currentToken.type == TOK_ASSIGN) {
         eat(TOK_ASSIGN);
-        init = parseExpression();
+        init.reset(parseExpression());
     }
     eat(TOK_SEMI);
-    return new VarDeclStmt("int", name, init);
+    return new VarDeclStmt("int", name, init.release());
 }
 
 // Assign -> id = expr;
+// Call   -> id ( [expr {, expr}] ) ...;
 StmtNode* Parser::parseAssign() {
     string name = currentToken.value;
     eat(TOK_ID);
+    if (currentToken.type == TOK_LPAREN) {
+        NodePtr<ExprNode> expr(parseExpression(name));
+        eat(TOK_SEMI);
+        return new ExprStmt(expr.release());
+    }
     eat(TOK_ASSIGN);
-    ExprNode* val = parseExpression();
+    NodePtr<ExprNode> val(parseExpression());
     eat(TOK_SEMI);
-    return new AssignStmt(name, val);
+    return new AssignStmt(name, val.release());
 }
 
-// 语句分发
-StmtNode* Parser::parseStatement() {
-    if (currentToken.type == TOK_IF) return parseIf();
-    if (currentToken.type == TOK_WHILE) return parseWhile();
+// 不含子语句的简单语句
+StmtNode* Parser::parseSimpleStatement() {
     if (currentToken.type == TOK_RETURN) return parseReturn();
-    if (currentToken.type == TOK_LBRACE) return parseBlock();
     if (currentToken.type == TOK_INT) return parseVarDecl();
     if (currentToken.type == TOK_ID) return parseAssign();
     
-    cerr << "Unknown statement: " << currentToken.value << endl;
-    exit(1);
+    error("expected statement but got " + describe(currentToken));
+}
+
+// 语句分发
+// If    -> if (expr) stmt [else stmt]
+// While -> while (expr) stmt
+// Block -> { stmt... }
+// 嵌套的 if / while / 块保存在显式栈中，解析完一条子语句后再逐层归约
+StmtNode* Parser::parseStatement() {
+    enum FrameKind { FRAME_BLOCK, FRAME_IF_THEN, FRAME_IF_ELSE, FRAME_WHILE_BODY };
+    struct Frame {
+        FrameKind kind;
+        ExprNode* cond;
+        StmtNode* thenStmt;
+        BlockStmt* block;
+    };
+    vector<Frame> stack;
+
+    try {
+        while (true) {
+            StmtNode* done = nullptr;
+
+            if (!stack.empty() && stack.back().kind == FRAME_BLOCK &&
+                (currentToken.type == TOK_RBRACE || currentToken.type == TOK_EOF)) {
+                // 块结束
+                eat(TOK_RBRACE);
+                done = stack.back().block;
+                stack.pop_back();
+            } else if (currentToken.type == TOK_IF) {
+                eat(TOK_IF);
+                stack.push_back({FRAME_IF_THEN, parseCondition(), nullptr, nullptr});
+                continue;
+            } else if (currentToken.type == TOK_WHILE) {
+                eat(TOK_WHILE);
+                stack.push_back({FRAME_WHILE_BODY, parseCondition(), nullptr, nullptr});
+                continue;
+            } else if (currentToken.type == TOK_LBRACE) {
+                eat(TOK_LBRACE);
+                stack.push_back({FRAME_BLOCK, nullptr, nullptr, new BlockStmt()});
+                continue;
+            } else {
+                done = parseSimpleStatement();
+            }
+
+            // 把完成的语句交给外层结构，能归约的逐层归约
+            while (true) {
+                if (stack.empty()) return done;
+                Frame& f = stack.back();
+                if (f.kind == FRAME_BLOCK) {
+                    f.block->stmts.push_back(done);
+                    break;
+                }
+                if (f.kind == FRAME_IF_THEN) {
+                    if (currentToken.type == TOK_ELSE) {
+                        eat(TOK_ELSE);
+                        f.thenStmt = done;
+                        f.kind = FRAME_IF_ELSE;
+                        break;
+                    }
+                    done = new IfStmt(f.cond, done, nullptr);
+                } else if (f.kind == FRAME_IF_ELSE) {
+                    done = new IfStmt(f.cond, f.thenStmt, done);
+                } else {
+                    done = new WhileStmt(f.cond, done);
+                }
+                stack.pop_back();
+            }
+        }
+    } catch (...) {
+        // 栈中已经建立的条件、then 分支和块
+        for (Frame& f : stack) {
+            freeAST(f.cond);
+            freeAST(f.thenStmt);
+            freeAST(f.block);
+        }
+        throw;
+    }
 }
 
-// Func -> int id () block
+// Func -> (int | void) id ( [void | int id {, int id}] ) block
 FuncDef* Parser::parseFuncDef() {
+    tokenHash = FNV_OFFSET;
+
     // 简单假设函数都是 int 返回类型
     string retType = "int";
     if (currentToken.type == TOK_INT) eat(TOK_INT);
@@ -152,24 +332,131 @@ FuncDef* Parser::parseFuncDef() {
     eat(TOK_ID);
     
     eat(TOK_LPAREN);
-    // 这里偷懒省略了参数解析，直接假设无参或跳过参数
-    // 真正的编译器需要在这里解析参数列表
-    while (currentToken.type != TOK_RPAREN) { 
-        currentToken = lexer.nextToken(); // 跳过参数
+    vector<string> params;
+    if (currentToken.type == TOK_VOID) {
+        eat(TOK_VOID);
+    } else if (currentToken.type != TOK_RPAREN) {
+        while (true) {
+            eat(TOK_INT);
+            if (currentToken.type == TOK_ID && find(params.begin(), params.end(), currentToken.value) != params.end()) {
+                error("duplicate parameter '" + currentToken.value + "'");
+            }
+            params.push_back(currentToken.value);
+            eat(TOK_ID);
+            if (currentToken.type != TOK_COMMA) break;
+            eat(TOK_COMMA);
+        }
     }
     eat(TOK_RPAREN);
     
     BlockStmt* body = parseBlock();
-    return new FuncDef(retType, name, body);
+    FuncDef* func = new FuncDef(retType, name, body);
+    func->args = params;
+    func->tokenHash = tokenHash;
+    return func;
+}
+
+FuncDef* Parser::parseNextFunction() {
+    if (currentToken.type == TOK_EOF) return nullptr;
+    // 简单处理：如果是 int 开头，预读下一个看看是函数还是变量
+    // 这是一个简化的预测分析，真实情况要复杂点
+    // 这里直接假设全是函数定义，方便完工
+    return parseFuncDef();
 }
 
 ASTNode* Parser::parse() {
-    ProgramNode* root = new ProgramNode();
-    while (currentToken.type != TOK_EOF) {
-        // 简单处理：如果是 int 开头，预读下一个看看是函数还是变量
-        // 这是一个简化的预测分析，真实情况要复杂点
-        // 这里直接假设全是函数定义，方便完工
-        root->elements.push_back(parseFuncDef());
+    NodePtr<ProgramNode> root(new ProgramNode());
+    while (FuncDef* func = parseNextFunction()) {
+        root->elements.push_back(func);
     }
-    return root;
+    return root.release();
+}
+
+// 小于该大小的文件直接串行解析，切分和调度的开销不值得
+static const size_t PARALLEL_PARSE_MIN = 256 * 1024;
+// 每段的最小字节数：很多小函数合并为一段，避免任务过碎
+static const size_t PARSE_CHUNK_MIN = 64 * 1024;
+
+// 源代码中的一段，起点总是顶层元素的开始
+struct SourceChunk {
+    size_t begin;
+    size_t end;
+    int line;   // begin 处的行列号
+    int column;
+};
+
+/**
+ * 预扫描：只统计花括号深度和换行，在深度回到 0 的 '}' 之后切分，每段至少 target 字节
+ * 语言中没有注释和字符串，花括号总是记号；括号不配对时剩余部分作为一段，由语法分析报告错误
+ */
+static vector<SourceChunk> splitTopLevel(const string& source, size_t target) {
+    vector<SourceChunk> chunks;
+    SourceChunk cur = {0, 0, 1, 1};
+    const char* s = source.data();
+    size_t n = source.size();
+    int depth = 0;
+    int line = 1;
+    size_t lineStart = 0;
+    for (size_t i = 0; i < n; ++i) {
+        char c = s[i];
+        if (c == '\n') {
+            line++;
+            lineStart = i + 1;
+        } else if (c == '{') {
+            depth++;
+        } else if (c == '}') {
+            if (--depth < 0) break;
+            if (depth == 0 && i + 1 - cur.begin >= target) {
+                cur.end = i + 1;
+                chunks.push_back(cur);
+                cur = {i + 1, 0, line, (int)(i + 1 - lineStart) + 1};
+            }
+        }
+    }
+    cur.end = n;
+    chunks.push_back(cur);
+    return chunks;
+}
+
+/**
+ * 并行解析：各段只包含完整的顶层元素，解析结果按段的顺序拼接
+ * 函数定义不会读取其结束的 '}' 之后的记号，因此所有段都解析成功时结果与串行解析相同；
+ * 反之（例如参数列表中出现花括号使切分点落在函数内部）回退到串行解析
+ */
+ASTNode* parseProgram(const string& source, ThreadPool* pool) {
+    if (pool && pool->size() > 1 && source.size() >= PARALLEL_PARSE_MIN) {
+        size_t target = max(PARSE_CHUNK_MIN, source.size() / (pool->size() * 4));
+        vector<SourceChunk> chunks;
+        {
+            INSTR_SCOPE("splitTopLevel");
+            chunks = splitTopLevel(source, target);
+        }
+        int n = (int)chunks.size();
+        vector<vector<FuncDef*>> results(n);
+        vector<char> failed(n, 0);
+        pool->parallelFor(n, [&](int i) {
+            const SourceChunk& c = chunks[i];
+            INSTR_SCOPE_DETAIL("parseChunk", "line " + to_string(c.line));
+            try {
+                Lexer lexer(source.substr(c.begin, c.end - c.begin), c.line, c.column);
+                Parser parser(lexer);
+                while (FuncDef* func = parser.parseNextFunction()) results[i].push_back(func);
+            } catch (const exception&) {
+                failed[i] = 1;
+            }
+        });
+
+        if (find(failed.begin(), failed.end(), 1) == failed.end()) {
+            ProgramNode* root = new ProgramNode();
+            for (auto& funcs : results) root->elements.insert(root->elements.end(), funcs.begin(), funcs.end());
+            return root;
+        }
+        for (auto& funcs : results) {
+            for (FuncDef* func : funcs) freeAST(func);
+        }
+    }
+
+    Lexer lexer(source);
+    Parser parser(lexer);
+    return parser.parse();
 }
\ No newline at end of file
@@ -0,0 +1,538 @@
+#include "passes.h"
+#include "verifier.h"
+#include "ssa.h"
+#include "instrument.h"
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <iomanip>
+#include <stdexcept>
+
+/**
+ * 删除标记的四元式，返回删除的数量
+ */
+int compactQuads(vector<Quad>& codes, const vector<bool>& removed) {
+    size_t kept = 0;
+    for (size_t i = 0; i < codes.size(); ++i) {
+        if (removed[i]) continue;
+        if (kept != i) codes[kept] = move(codes[i]);
+        kept++;
+    }
+    int count = (int)(codes.size() - kept);
+    codes.erase(codes.begin() + kept, codes.end());
+    return count;
+}
+
+/**
+ * 常量折叠，运算语义与解释器、模拟器一致（32 位回绕）
+ * 除数为 0 时不折叠，留到运行时处理
+ */
+bool foldArith(QuadOp op, int a, int b, int& r) {
+    uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+    switch (op) {
+        case OP_ADD: r = (int)(ua + ub); return true;
+        case OP_SUB: r = (int)(ua - ub); return true;
+        case OP_MUL: r = (int)(ua * ub); return true;
+        case OP_DIV:
+            if (b == 0) return false;
+            r = (a == INT_MIN && b == -1) ? INT_MIN : a / b;
+            return true;
+        default: return false;
+    }
+}
+
+bool evalCond(QuadOp op, int a, int b) {
+    switch (op) {
+        case OP_JEQ: return a == b;
+        case OP_JNE: return a != b;
+        case OP_JGT: return a > b;
+        case OP_JLT: return a < b;
+        default: return true;
+    }
+}
+
+/**
+ * 代数化简：x+0、x-0、x*1、x/1 化为复制，x*0、0/x、x-x 化为常量 0
+ * 成功时把 q 改写为 ASSIGN
+ */
+static bool simplifyArith(Quad& q) {
+    const string* copy = nullptr;
+    bool zero = false;
+    if (q.op == OP_ADD) {
+        if (q.arg2 == "0") copy = &q.arg1;
+        else if (q.arg1 == "0") copy = &q.arg2;
+    } else if (q.op == OP_SUB) {
+        if (q.arg2 == "0") copy = &q.arg1;
+        else if (q.arg1 == q.arg2) zero = true;
+    } else if (q.op == OP_MUL) {
+        if (q.arg1 == "0" || q.arg2 == "0") zero = true;
+        else if (q.arg2 == "1") copy = &q.arg1;
+        else if (q.arg1 == "1") copy = &q.arg2;
+    } else if (q.op == OP_DIV) {
+        // 除以 0 的结果也是 0，所以 0/x 总是 0
+        if (q.arg1 == "0") zero = true;
+        else if (q.arg2 == "1") copy = &q.arg1;
+    }
+    if (!copy && !zero) return false;
+    string value = zero ? "0" : *copy;
+    q.op = OP_ASSIGN;
+    q.arg1 = value;
+    q.arg2.clear();
+    return true;
+}
+
+/**
+ * constprop：基本块内的常量传播、复制传播和常量折叠
+ * 常量条件的跳转改为无条件跳转或删除，交给 simplifycfg 清理死代码
+ */
+static int constProp(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    vector<bool> removed(codes.size(), false);
+    int changes = 0;
+
+    map<string, string> value;          // 变量 -> 当前等于的常量或变量
+    map<string, vector<string>> copies; // 变量 x -> 值记为 x 的变量
+    auto clear = [&] {
+        value.clear();
+        copies.clear();
+    };
+    // 变量被重新赋值：它自己的值以及复制自它的变量都失效
+    auto kill = [&](const string& v) {
+        value.erase(v);
+        auto it = copies.find(v);
+        if (it == copies.end()) return;
+        for (auto& w : it->second) {
+            auto jt = value.find(w);
+            if (jt != value.end() && jt->second == v) value.erase(jt);
+        }
+        copies.erase(it);
+    };
+    auto subst = [&](string& s) {
+        if (!isVarOperand(s)) return false;
+        auto it = value.find(s);
+        if (it == value.end()) return false;
+        s = it->second;
+        return true;
+    };
+
+    for (size_t i = 0; i < codes.size(); ++i) {
+        Quad& q = codes[i];
+        bool changed = false;
+        switch (q.op) {
+            case OP_LABEL:
+            case OP_FUNC_BEGIN:
+                clear();
+                break;
+            case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: {
+                changed |= subst(q.arg1);
+                changed |= subst(q.arg2);
+                int r;
+                if (isConstOperand(q.arg1) && isConstOperand(q.arg2) &&
+                    foldArith(q.op, stoi(q.arg1), stoi(q.arg2), r)) {
+                    q.op = OP_ASSIGN;
+                    q.arg1 = to_string(r);
+                    q.arg2.clear();
+                    changed = true;
+                } else if (simplifyArith(q)) {
+                    changed = true;
+                }
+                if (q.op != OP_ASSIGN) {
+                    kill(q.result);
+                    break;
+                }
+                // 已化为赋值，按赋值继续处理
+                [[fallthrough]];
+            }
+            case OP_ASSIGN: {
+                changed |= subst(q.arg1);
+                if (q.arg1 == q.result) {
+                    removed[i] = true;
+                    changed = true;
+                    break;
+                }
+                kill(q.result);
+                value[q.result] = q.arg1;
+                if (isVarOperand(q.arg1)) copies[q.arg1].push_back(q.result);
+                break;
+            }
+            case OP_JEQ: case OP_JNE: case OP_JGT: case OP_JLT: {
+                changed |= subst(q.arg1);
+                changed |= subst(q.arg2);
+                if (isConstOperand(q.arg1) && isConstOperand(q.arg2)) {
+                    if (evalCond(q.op, stoi(q.arg1), stoi(q.arg2))) {
+                        q.op = OP_JMP;
+                        q.arg1.clear();
+                        q.arg2.clear();
+                    } else {
+                        removed[i] = true;
+                    }
+                    changed = true;
+                }
+                clear();
+                break;
+            }
+            case OP_JMP:
+                clear();
+                break;
+            case OP_PARAM:
+                changed |= subst(q.arg1);
+                break;
+            case OP_RETURN:
+                changed |= subst(q.arg1);
+                clear();
+                break;
+            case OP_CALL:
+                if (!q.result.empty()) kill(q.result);
+                break;
+            default:
+                break;
+        }
+        if (changed) changes++;
+    }
+    compactQuads(codes, removed);
+    return changes;
+}
+
+/**
+ * 跳转穿透的最终目标：沿 forward 链走到不再是“标签后紧跟无条件跳转”的标签
+ * 每个标签只解析一次（结果记入 resolved），链上有环时停在进入环的标签
+ */
+static const string& resolveForward(const string& label, const unordered_map<string, string>& forward,
+                                    unordered_map<string, string>& resolved) {
+    vector<const string*> path;
+    unordered_map<string, int> onPath;
+    const string* cur = &label;
+    const string* final;
+    int cycleStart = -1;
+    while (true) {
+        auto done = resolved.find(*cur);
+        if (done != resolved.end()) { final = &done->second; break; }
+        auto seen = onPath.find(*cur);
+        if (seen != onPath.end()) { final = cur; cycleStart = seen->second; break; }
+        auto next = forward.find(*cur);
+        if (next == forward.end()) { final = cur; break; }
+        onPath[*cur] = (int)path.size();
+        path.push_back(cur);
+        cur = &next->second;
+    }
+    // 环上的标签保持原目标（与逐个跟随、遇到重复即停止的结果相同）
+    string target = *final;
+    for (int k = 0; k < (int)path.size(); ++k) {
+        resolved[*path[k]] = (cycleStart >= 0 && k >= cycleStart) ? *path[k] : target;
+    }
+    return resolved.emplace(label, label).first->second;
+}
+
+/**
+ * simplifycfg：跳转穿透、删除不可达的块、删除跳到下一条的跳转和无用的标签
+ * 标签少了，后端在块边界写回寄存器的次数也随之减少
+ * 每一轮都是线性的：穿透链只解析一次，“跳到紧随其后的标签”从后向前扫描，
+ * 一次删除可以让前面的跳转接着被删除（嵌套 if 的出口），不需要再来一轮
+ * 只有删除之后出现了新的穿透机会（标签后的条件跳转被删除，露出无条件跳转）时才再执行一轮
+ */
+static int simplifyCFG(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    int changes = 0;
+
+    while (true) {
+        int n = (int)codes.size();
+        int before = changes;
+
+        // 1. 跳转穿透：目标标签后面紧跟着无条件跳转时，直接跳到最终目标
+        unordered_map<string, string> forward;
+        for (int i = 0; i < n; ++i) {
+            if (codes[i].op != OP_LABEL) continue;
+            int j = i + 1;
+            while (j < n && codes[j].op == OP_LABEL) j++;
+            if (j < n && codes[j].op == OP_JMP && codes[j].result != codes[i].result) {
+                forward[codes[i].result] = codes[j].result;
+            }
+        }
+        if (!forward.empty()) {
+            unordered_map<string, string> resolved;
+            for (auto& q : codes) {
+                if (!isBranch(q.op) || !forward.count(q.result)) continue;
+                const string& target = resolveForward(q.result, forward, resolved);
+                if (target != q.result) {
+                    q.result = target;
+                    changes++;
+                }
+            }
+        }
+        if (changes != before) func.invalidate();
+
+        // 2. 删除从入口不可达的块（保留函数结尾）
+        vector<bool> removed(n, false);
+        const CFG& cfg = func.getCFG();
+        for (int b = 0; b < cfg.size(); ++b) {
+            if (cfg.reachable(b)) continue;
+            for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+                if (codes[i].op != OP_FUNC_END) removed[i] = true;
+            }
+        }
+
+        // 3. 跳转的目标就是紧随其后的标签之一
+        // 从后向前扫描，连续的（未删除的）标签编为同一段，删除的跳转不打断这一段
+        unordered_map<string, int> labelRun;
+        int run = 0;
+        for (int i = n - 1; i >= 0; --i) {
+            if (removed[i]) continue;
+            if (codes[i].op == OP_LABEL) {
+                labelRun[codes[i].result] = run;
+                continue;
+            }
+            if (isBranch(codes[i].op)) {
+                auto it = labelRun.find(codes[i].result);
+                if (it != labelRun.end() && it->second == run) {
+                    removed[i] = true;
+                    continue;
+                }
+            }
+            run++;
+        }
+
+        // 4. 没有跳转指向的标签
+        unordered_set<string> targets;
+        for (int i = 0; i < n; ++i) {
+            if (!removed[i] && isBranch(codes[i].op)) targets.insert(codes[i].result);
+        }
+        for (int i = 0; i < n; ++i) {
+            if (!removed[i] && codes[i].op == OP_LABEL && !targets.count(codes[i].result)) removed[i] = true;
+        }
+
+        int count = compactQuads(codes, removed);
+        if (count) func.invalidate();
+        changes += count;
+        if (changes == before) break;
+    }
+    return changes;
+}
+
+/**
+ * dce：基于活跃变量分析删除结果不再被使用的赋值和算术运算
+ * 调用可能有副作用，只丢弃它未被使用的返回值
+ */
+static int deadCode(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    int changes = 0;
+    vector<const string*> uses;
+
+    while (true) {
+        const CFG& cfg = func.getCFG();
+        const Liveness& liveness = func.getLiveness();
+        const VarIndex& vars = liveness.getVars();
+        vector<bool> removed(codes.size(), false);
+
+        for (int b = 0; b < cfg.size(); ++b) {
+            BitSet live = liveness.out(b);
+            for (int i = cfg.block(b).last; i >= cfg.block(b).first; --i) {
+                Quad& q = codes[i];
+                if (const string* d = quadDef(q)) {
+                    int v = vars.id(*d);
+                    if (!live.test(v)) {
+                        if (q.op != OP_CALL) {
+                            removed[i] = true;
+                            continue;
+                        }
+                        q.result.clear();
+                        changes++;
+                    }
+                    live.reset(v);
+                }
+                quadUses(q, uses);
+                for (auto u : uses) live.set(vars.id(*u));
+            }
+        }
+
+        int count = compactQuads(codes, removed);
+        if (!count) break;
+        // 删除的语句可能让更早的定值也变成死代码
+        changes += count;
+        func.invalidate();
+    }
+    return changes;
+}
+
+const vector<FunctionPass>& functionPasses() {
+    static const vector<FunctionPass> passes = {
+        {"constprop", constProp, 0, false},
+        {"simplifycfg", simplifyCFG, 0, false},
+        {"sccp", sparseConstProp, ANALYSIS_CFG | ANALYSIS_DOMINATORS, true},
+        {"gvn", valueNumbering, ANALYSIS_CFG | ANALYSIS_DOMINATORS, true},
+        {"ssadce", sparseDeadCode, 0, true},
+        {"dce", deadCode, 0, false},
+    };
+    return passes;
+}
+
+bool isKnownPass(const string& name) {
+    if (name == "callgraph") return true;
+    for (auto& p : functionPasses()) {
+        if (name == p.name) return true;
+    }
+    return false;
+}
+
+string knownPassNames() {
+    string names;
+    for (auto& p : functionPasses()) names += string(p.name) + ", ";
+    return names + "callgraph";
+}
+
+void PassStatistics::record(const string& pass, int changes, double seconds) {
+    lock_guard<mutex> guard(lock);
+    if (!entries.count(pass)) order.push_back(pass);
+    Entry& e = entries[pass];
+    e.runs++;
+    e.changes += changes;
+    e.seconds += seconds;
+}
+
+void PassStatistics::print(ostream& out) {
+    lock_guard<mutex> guard(lock);
+    out << "Pass statistics:" << endl;
+    out << "  " << left << setw(14) << "pass" << right << setw(10) << "runs" << setw(12) << "changes"
+        << setw(12) << "ms" << endl;
+    for (auto& name : order) {
+        Entry& e = entries[name];
+        out << "  " << left << setw(14) << name << right << setw(10) << e.runs << setw(12) << e.changes
+            << setw(12) << fixed << setprecision(3) << e.seconds * 1000 << endl;
+    }
+}
+
+/**
+ * 按优化级别确定流水线，再应用 -fpass= / -fno-pass=
+ * 遍名的合法性由调用者检查，未知的名字在这里被忽略
+ */
+PassManager::PassManager(const PassOptions& options, PassStatistics* stats)
+    : callGraph(false), maxRounds(1), unconverged(0), verify(options.verify), stats(stats) {
+    set<string> selected;
+    if (options.level >= OPT_O1) selected.insert("callgraph");
+    if (options.level >= OPT_O2) {
+        for (auto& p : functionPasses()) selected.insert(p.name);
+    }
+    if (options.level == OPT_OS) maxRounds = OS_MAX_ROUNDS;
+    for (auto& name : options.enable) selected.insert(name);
+    for (auto& name : options.disable) selected.erase(name);
+
+    for (auto& p : functionPasses()) {
+        if (selected.count(p.name)) passes.push_back(&p);
+    }
+    callGraph = selected.count("callgraph") > 0;
+}
+
+bool PassManager::hasFunctionPasses() const {
+    return !passes.empty();
+}
+
+int PassManager::unconvergedRuns() const {
+    return unconverged;
+}
+
+bool PassManager::hasModulePasses() const {
+    return callGraph;
+}
+
+void PassManager::check(const vector<Quad>& codes, const string& after, bool ssa) const {
+    string error;
+    if (!verifyProgram(codes, error) || (ssa && !verifySSA(codes, error))) {
+        throw runtime_error("invalid IR after " + after + ": " + error);
+    }
+}
+
+/**
+ * 构造或还原 SSA，记入统计（修改数量为插入的 PHI / 复制数量），不计入遍的修改数量
+ */
+void PassManager::convertSSA(FunctionIR& func, bool toSSA) {
+    const char* name = toSSA ? "to-ssa" : "out-of-ssa";
+    int n;
+    auto start = chrono::steady_clock::now();
+    {
+        INSTR_SCOPE_DETAIL("pass", name);
+        n = toSSA ? buildSSA(func) : destroySSA(func);
+    }
+    if (stats) stats->record(name, n, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    if (verify) check(func.codes, name, toSSA);
+}
+
+void PassManager::runPass(const FunctionPass& pass, FunctionIR& func, int& changes) {
+    int n;
+    auto start = chrono::steady_clock::now();
+    {
+        INSTR_SCOPE_DETAIL("pass", pass.name);
+        n = pass.run(func);
+    }
+    if (n) func.invalidate(pass.preserved);
+    if (stats) stats->record(pass.name, n, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    if (verify) check(func.codes, pass.name, func.inSSA);
+    changes += n;
+}
+
+static bool sameCode(const vector<Quad>& a, const vector<Quad>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].op != b[i].op || a[i].arg1 != b[i].arg1 || a[i].arg2 != b[i].arg2 ||
+            a[i].result != b[i].result || a[i].phi != b[i].phi) return false;
+    }
+    return true;
+}
+
+/**
+ * 函数级遍按固定顺序执行；Os 下整条流水线重复执行，直到一轮没有任何修改或一轮前后的代码相同
+ * 连续的 SSA 遍共用一次构造，离开前总是还原为普通的四元式
+ */
+int PassManager::runFunctionPasses(vector<Quad>& codes) {
+    if (verify) check(codes, "lowering");
+    if (passes.empty()) return 0;
+
+    FunctionIR func(move(codes));
+    int total = 0;
+    vector<Quad> before;
+    for (int round = 0; round < maxRounds; ++round) {
+        int changes = 0;
+        if (maxRounds > 1) before = func.codes;
+        for (auto p : passes) {
+            if (p->ssa != func.inSSA) convertSSA(func, p->ssa);
+            runPass(*p, func, changes);
+        }
+        total += changes;
+        if (changes == 0 || maxRounds == 1) break;
+        // SSA 遍的修改在还原后可能又被抵消（复制传播与重新插入的复制），以一轮前后的代码为准
+        if (func.inSSA) convertSSA(func, false);
+        if (sameCode(func.codes, before)) break;
+        if (round == maxRounds - 1) unconverged++;
+    }
+    if (func.inSSA) convertSSA(func, false);
+    codes = move(func.codes);
+    return total;
+}
+
+/**
+ * 调用图遍关闭时仍然建立调用图（只分析不修改），供调试输出使用
+ */
+int PassManager::runModulePasses(vector<Quad>& codes, CallGraph& graph) {
+    if (!callGraph) {
+        graph.build(codes);
+        return 0;
+    }
+    int n;
+    auto start = chrono::steady_clock::now();
+    {
+        INSTR_SCOPE("callgraph");
+        n = graph.run(codes);
+    }
+    if (stats) stats->record("callgraph", n, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    if (verify) check(codes, "callgraph");
+    return n;
+}
+
+string PassManager::describe() const {
+    string s = maxRounds > 1 ? "Os:" : "";
+    string names;
+    for (auto p : passes) names += string(names.empty() ? "" : ",") + p->name;
+    if (callGraph) names += string(names.empty() ? "" : ",") + "callgraph";
+    return s + (names.empty() ? "none" : names);
+}
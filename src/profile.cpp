@@ -0,0 +1,297 @@
+#include "profile.h"
+#include "cfg.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <set>
+
+bool Profile::empty() const {
+    return funcs.empty();
+}
+
+size_t Profile::size() const {
+    return funcs.size();
+}
+
+void Profile::add(FunctionProfile func) {
+    pair<string, uint64_t> key(func.name, func.hash);
+    funcs[key] = move(func);
+}
+
+const FunctionProfile* Profile::find(const string& name, uint64_t hash) const {
+    auto it = funcs.find({name, hash});
+    return it == funcs.end() ? nullptr : &it->second;
+}
+
+bool Profile::hasName(const string& name) const {
+    auto it = funcs.lower_bound({name, 0});
+    return it != funcs.end() && it->first.first == name;
+}
+
+bool Profile::load(const string& path, string& error) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        error = "cannot open profile '" + path + "'";
+        return false;
+    }
+    string line, word;
+    int lineNo = 0;
+    FunctionProfile current;
+    bool inFunc = false;
+    while (getline(in, line)) {
+        lineNo++;
+        istringstream fields(line);
+        if (!(fields >> word)) continue;
+        bool ok = true;
+        if (lineNo == 1) {
+            int version = 0;
+            ok = word == "qprof" && (fields >> version) && version == 1;
+        } else if (word == "function" && !inFunc) {
+            current = FunctionProfile();
+            ok = bool(fields >> current.name >> hex >> current.hash >> dec >> current.entries);
+            inFunc = true;
+        } else if ((word == "block" || word == "branch") && inFunc) {
+            int index;
+            long long count;
+            ok = bool(fields >> index >> count);
+            (word == "block" ? current.blocks : current.taken)[index] = count;
+        } else if (word == "end" && inFunc) {
+            add(move(current));
+            inFunc = false;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            error = path + ":" + to_string(lineNo) + ": malformed profile line";
+            return false;
+        }
+    }
+    if (lineNo == 0 || inFunc) {
+        error = path + ": truncated profile";
+        return false;
+    }
+    return true;
+}
+
+bool Profile::save(const string& path) const {
+    ofstream out(path);
+    out << "qprof 1" << '\n';
+    for (auto& entry : funcs) {
+        const FunctionProfile& f = entry.second;
+        out << "function " << f.name << " " << hex << f.hash << dec << " " << f.entries << '\n';
+        for (auto& b : f.blocks) out << "block " << b.first << " " << b.second << '\n';
+        for (auto& t : f.taken) out << "branch " << t.first << " " << t.second << '\n';
+        out << "end" << '\n';
+    }
+    return bool(out);
+}
+
+uint64_t hashFunction(const vector<Quad>& codes) {
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&](const string& s) {
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        h ^= 0xff; // 分隔符，避免 "ab"+"c" 与 "a"+"bc" 相同
+        h *= 1099511628211ULL;
+    };
+    for (auto& q : codes) {
+        h ^= (uint64_t)q.op;
+        h *= 1099511628211ULL;
+        mix(q.arg1);
+        mix(q.arg2);
+        mix(q.result);
+    }
+    return h;
+}
+
+/**
+ * 块的划分与 CFG 相同：函数入口、标签、跳转或返回之后的四元式
+ */
+void collectProfile(const vector<Quad>& codes, const IRInterpreter& interp, Profile& out) {
+    const vector<long long>& counts = interp.quadCounts();
+    const vector<long long>& taken = interp.takenCounts();
+    size_t begin = 0;
+    while (begin < codes.size()) {
+        size_t end = begin;
+        while (end + 1 < codes.size() && codes[end].op != OP_FUNC_END) end++;
+
+        FunctionProfile f;
+        f.name = codes[begin].result;
+        f.hash = hashFunction(vector<Quad>(codes.begin() + begin, codes.begin() + end + 1));
+        f.entries = counts[begin];
+        for (size_t i = begin; i <= end; ++i) {
+            bool leader = i == begin || codes[i].op == OP_LABEL || isBranch(codes[i - 1].op) ||
+                          codes[i - 1].op == OP_RETURN;
+            if (leader && counts[i] > 0) f.blocks[(int)(i - begin)] = counts[i];
+            if (isBranch(codes[i].op) && codes[i].op != OP_JMP && taken[i] > 0) f.taken[(int)(i - begin)] = taken[i];
+        }
+        out.add(move(f));
+        begin = end + 1;
+    }
+}
+
+/**
+ * Pettis-Hansen 式的自底向上链构造：边按执行次数从大到小处理，
+ * 边的起点是某条链的尾、终点是另一条链的头时把两条链接起来
+ */
+int layoutFunction(vector<Quad>& codes, const FunctionProfile& profile, map<string, long long>& weights) {
+    const string fname = codes.front().result;
+    // FUNC_END 单独处理：直落到函数结尾的块在重排后要跳到它前面
+    vector<Quad> body(codes.begin(), codes.end() - 1);
+    CFG cfg(body);
+    int nb = cfg.size();
+
+    auto countOf = [](const map<int, long long>& m, int i) {
+        auto it = m.find(i);
+        return it == m.end() ? 0LL : it->second;
+    };
+    vector<long long> heat(nb);
+    vector<const string*> uses;
+    for (int b = 0; b < nb; ++b) {
+        heat[b] = countOf(profile.blocks, cfg.block(b).first);
+        for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+            quadUses(body[i], uses);
+            for (auto u : uses) weights[*u] += heat[b];
+            if (const string* d = quadDef(body[i])) weights[*d] += heat[b];
+        }
+    }
+
+    // 每个块原来的直落后继，-2 表示直落到函数结尾，-1 表示没有直落
+    const int EXIT = -2;
+    struct Edge {
+        int from, to;
+        long long count;
+    };
+    vector<Edge> edges;
+    vector<int> fall(nb, -1);
+    for (int b = 0; b < nb; ++b) {
+        const Quad& last = body[cfg.block(b).last];
+        if (last.op != OP_JMP && last.op != OP_RETURN) fall[b] = b + 1 < nb ? b + 1 : EXIT;
+        if (isBranch(last.op)) {
+            long long t = last.op == OP_JMP ? heat[b] : countOf(profile.taken, cfg.block(b).last);
+            edges.push_back({b, cfg.blockOfLabel(last.result), t});
+            if (fall[b] >= 0) edges.push_back({b, fall[b], max(0LL, heat[b] - t)});
+        } else if (fall[b] >= 0) {
+            edges.push_back({b, fall[b], heat[b]});
+        }
+    }
+    stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.count > b.count; });
+
+    vector<int> next(nb, -1), prev(nb, -1), parent(nb);
+    for (int b = 0; b < nb; ++b) parent[b] = b;
+    auto findChain = [&](int b) {
+        while (parent[b] != b) b = parent[b] = parent[parent[b]];
+        return b;
+    };
+    for (auto& e : edges) {
+        if (e.count == 0) break;
+        if (e.to <= 0 || e.from == e.to || next[e.from] >= 0 || prev[e.to] >= 0) continue;
+        int a = findChain(e.from), c = findChain(e.to);
+        if (a == c) continue;
+        next[e.from] = e.to;
+        prev[e.to] = e.from;
+        parent[c] = a;
+    }
+
+    // 入口链在前，其余链按最热的块从热到冷排列，同样热的保持原来的顺序
+    vector<pair<long long, int>> chains;
+    for (int b = 1; b < nb; ++b) {
+        if (prev[b] >= 0) continue;
+        long long hottest = 0;
+        for (int x = b; x >= 0; x = next[x]) hottest = max(hottest, heat[x]);
+        chains.push_back({hottest, b});
+    }
+    stable_sort(chains.begin(), chains.end(),
+                [](const pair<long long, int>& a, const pair<long long, int>& b) { return a.first > b.first; });
+    vector<int> order;
+    for (int x = 0; x >= 0; x = next[x]) order.push_back(x);
+    for (auto& c : chains) {
+        for (int x = c.second; x >= 0; x = next[x]) order.push_back(x);
+    }
+
+    int moved = 0;
+    for (int k = 0; k < nb; ++k) {
+        if (order[k] != k) moved++;
+    }
+    if (moved == 0) return 0;
+
+    // 第一遍：确定每个块尾需要的调整以及需要补标签的块
+    set<string> labels;
+    for (auto& q : body) {
+        if (q.op == OP_LABEL) labels.insert(q.result);
+    }
+    int labelNext = 0;
+    auto freshLabel = [&] {
+        string name;
+        do {
+            name = fname + ".P" + to_string(labelNext++);
+        } while (labels.count(name));
+        labels.insert(name);
+        return name;
+    };
+    vector<string> label(nb);
+    vector<bool> addLabel(nb, false);
+    for (int b = 0; b < nb; ++b) {
+        if (body[cfg.block(b).first].op == OP_LABEL) label[b] = body[cfg.block(b).first].result;
+    }
+    auto need = [&](int b) {
+        if (label[b].empty()) {
+            label[b] = freshLabel();
+            addLabel[b] = true;
+        }
+    };
+
+    struct Fixup {
+        bool dropJump = false;  // 无条件跳转的目标就是下一块
+        bool invert = false;    // 条件取反，跳到原来的直落块
+        int jumpTo = -1;        // 块尾补一条跳转
+    };
+    vector<Fixup> fix(nb);
+    bool needExit = false;
+    for (int k = 0; k < nb; ++k) {
+        int b = order[k];
+        int following = k + 1 < nb ? order[k + 1] : EXIT;
+        const Quad& last = body[cfg.block(b).last];
+        int f = fall[b];
+        if (last.op == OP_JMP) {
+            fix[b].dropJump = cfg.blockOfLabel(last.result) == following;
+        } else if (f != -1 && f != following) {
+            bool invertible = last.op == OP_JEQ || last.op == OP_JNE;
+            if (invertible && f >= 0 && cfg.blockOfLabel(last.result) == following) {
+                fix[b].invert = true;
+                need(f);
+            } else {
+                fix[b].jumpTo = f;
+                if (f >= 0) need(f);
+                else needExit = true;
+            }
+        }
+    }
+    string exitLabel = needExit ? freshLabel() : "";
+
+    // 第二遍：按新顺序输出
+    vector<Quad> out;
+    out.reserve(codes.size() + nb);
+    for (int b : order) {
+        if (addLabel[b]) out.emplace_back(OP_LABEL, "", "", label[b]);
+        for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+            Quad q = body[i];
+            if (i == cfg.block(b).last) {
+                if (fix[b].dropJump) continue;
+                if (fix[b].invert) {
+                    q.op = q.op == OP_JEQ ? OP_JNE : OP_JEQ;
+                    q.result = label[fall[b]];
+                }
+            }
+            out.push_back(move(q));
+        }
+        if (fix[b].jumpTo >= 0) out.emplace_back(OP_JMP, "", "", label[fix[b].jumpTo]);
+        else if (fix[b].jumpTo == EXIT) out.emplace_back(OP_JMP, "", "", exitLabel);
+    }
+    if (needExit) out.emplace_back(OP_LABEL, "", "", exitLabel);
+    out.push_back(codes.back());
+    codes = move(out);
+    return moved;
+}
@@ -0,0 +1,251 @@
+#include "server.h"
+#include "cache.h"
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <cstring>
+#include <cstdint>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+static atomic<bool> stopRequested(false);
+
+static void onSignal(int) {
+    stopRequested = true;
+}
+
+// 完整读取 / 写入 n 个字节，连接断开时返回 false
+static bool readAll(int fd, void* buf, size_t n) {
+    char* p = (char*)buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const void* buf, size_t n) {
+    const char* p = (const char*)buf;
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w <= 0) return false;
+        p += w;
+        n -= w;
+    }
+    return true;
+}
+
+static bool readU32(int fd, uint32_t& v) {
+    unsigned char b[4];
+    if (!readAll(fd, b, 4)) return false;
+    v = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+    return true;
+}
+
+static bool writeU32(int fd, uint32_t v) {
+    unsigned char b[4] = {(unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24)};
+    return writeAll(fd, b, 4);
+}
+
+// 超过上限的长度视为协议错误，不按客户端给出的任意长度分配内存
+static bool readString(int fd, uint32_t len, string& s) {
+    if (len > SERVER_MAX_MESSAGE) {
+        cerr << "Error: Message of " << len << " bytes exceeds the limit of " << SERVER_MAX_MESSAGE << " bytes"
+             << endl;
+        return false;
+    }
+    s.resize(len);
+    return len == 0 || readAll(fd, &s[0], len);
+}
+
+static bool writeString(int fd, const string& s) {
+    return writeU32(fd, (uint32_t)s.size()) && writeAll(fd, s.data(), s.size());
+}
+
+static void reportThroughput(const char* what, long requests, chrono::steady_clock::time_point start) {
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << what << " " << requests << " requests in " << secs << " s";
+    if (secs > 0) cerr << " (" << (long)(requests / secs) << " requests/s)";
+    cerr << endl;
+}
+
+// 两次缓存淘汰之间的秒数
+static const int CACHE_EVICT_INTERVAL = 10;
+
+/**
+ * 处理一个连接上的所有请求
+ * @return 客户端是否请求关闭服务
+ */
+static bool serveConnection(int fd, const CompileOptions& options, ThreadPool& pool, atomic<long>& served) {
+    while (true) {
+        uint32_t len;
+        if (!readU32(fd, len)) return false;
+        if (len == SERVER_STOP) return true;
+
+        string source;
+        if (!readString(fd, len, source)) return false;
+
+        CompileOutput out = compileSource(source, options, &pool);
+        string diag;
+        for (auto& d : out.diagnostics) diag += formatDiagnostic(d) + "\n";
+
+        if (!writeU32(fd, out.success ? 0 : 1) || !writeString(fd, out.assembly) || !writeString(fd, diag)) {
+            return false;
+        }
+        served++;
+    }
+}
+
+int runServer(const string& socketPath, const CompileOptions& options, ThreadPool& pool) {
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (listenFd < 0 || socketPath.size() >= sizeof(addr.sun_path)) {
+        cerr << "Error: Cannot create socket '" << socketPath << "'" << endl;
+        return 1;
+    }
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 64) != 0) {
+        cerr << "Error: Cannot listen on '" << socketPath << "'" << endl;
+        close(listenFd);
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    cerr << "Compile server listening on " << socketPath << " (" << pool.size() << " threads)" << endl;
+
+    atomic<long> served(0);
+    atomic<int> activeConnections(0);
+    set<int> openFds;   // 仍然打开的连接，关闭服务时逐个断开
+    mutex openFdsLock;
+    auto start = chrono::steady_clock::now();
+    auto lastEvict = start;
+
+    // 每个连接一个线程负责收发，编译本身在共享线程池中按函数并行
+    while (!stopRequested) {
+        // 常驻期间定期按容量上限淘汰缓存，而不是只在退出时淘汰
+        if (options.cache && chrono::steady_clock::now() - lastEvict >= chrono::seconds(CACHE_EVICT_INTERVAL)) {
+            options.cache->evict();
+            lastEvict = chrono::steady_clock::now();
+        }
+
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        activeConnections++;
+        {
+            lock_guard<mutex> guard(openFdsLock);
+            openFds.insert(fd);
+        }
+        thread([fd, &options, &pool, &served, &activeConnections, &openFds, &openFdsLock] {
+            if (serveConnection(fd, options, pool, served)) stopRequested = true;
+            {
+                lock_guard<mutex> guard(openFdsLock);
+                openFds.erase(fd);
+            }
+            close(fd);
+            activeConnections--;
+        }).detach();
+    }
+
+    close(listenFd);
+    unlink(socketPath.c_str());
+    // 空闲的客户端可能一直不断开：关闭读写使其阻塞的 read 立即返回，正在编译的请求完成后退出
+    {
+        lock_guard<mutex> guard(openFdsLock);
+        for (int fd : openFds) shutdown(fd, SHUT_RDWR);
+    }
+    while (activeConnections > 0) this_thread::sleep_for(chrono::milliseconds(10));
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << "Served " << served << " requests in " << secs << " s" << endl;
+    return 0;
+}
+
+int runClient(const string& socketPath, const vector<CompileJob>& jobs, bool stopServer) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        cerr << "Error: Cannot connect to '" << socketPath << "'" << endl;
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    int failures = 0;
+    auto start = chrono::steady_clock::now();
+    for (auto& job : jobs) {
+        ifstream file(job.input, ios::binary);
+        if (!file.is_open()) {
+            cerr << "Error: Cannot open file '" << job.input << "'" << endl;
+            failures++;
+            continue;
+        }
+        stringstream buffer;
+        buffer << file.rdbuf();
+
+        uint32_t status, len;
+        string assembly, diag;
+        if (!writeString(fd, buffer.str()) || !readU32(fd, status) ||
+            !readU32(fd, len) || !readString(fd, len, assembly) ||
+            !readU32(fd, len) || !readString(fd, len, diag)) {
+            cerr << "Error: Connection to server lost" << endl;
+            close(fd);
+            return 1;
+        }
+
+        // 诊断信息中没有文件名，逐行补上（有位置时形如 "3:5: error: ..."）
+        istringstream lines(diag);
+        string line;
+        while (getline(lines, line)) {
+            bool hasPosition = !line.empty() && isdigit((unsigned char)line[0]);
+            cerr << job.input << (hasPosition ? ":" : ": ") << line << endl;
+        }
+
+        if (status == 0) {
+            ofstream out(job.output, ios::binary);
+            out << assembly;
+        } else {
+            failures++;
+        }
+    }
+    if (!jobs.empty()) reportThroughput("Compiled", (long)jobs.size(), start);
+
+    if (stopServer) writeU32(fd, SERVER_STOP);
+    close(fd);
+    return failures == 0 ? 0 : 1;
+}
+
+#else
+
+int runServer(const string&, const CompileOptions&, ThreadPool&) {
+    cerr << "Error: Server mode requires Unix domain sockets" << endl;
+    return 1;
+}
+
+int runClient(const string&, const vector<CompileJob>&, bool) {
+    cerr << "Error: Server mode requires Unix domain sockets" << endl;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,922 @@
+#include "ssa.h"
+#include "passes.h"
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+
+// 访问四元式读取的变量（可修改），不含 PHI 的操作数
+template <class F>
+static void forEachUse(Quad& q, F f) {
+    switch (q.op) {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+        case OP_JEQ: case OP_JNE: case OP_JGT: case OP_JLT:
+            if (isVarOperand(q.arg1)) f(q.arg1);
+            if (isVarOperand(q.arg2)) f(q.arg2);
+            break;
+        case OP_ASSIGN: case OP_PARAM: case OP_RETURN:
+            if (isVarOperand(q.arg1)) f(q.arg1);
+            break;
+        default:
+            break;
+    }
+}
+
+// 块的名字：开头的标签，入口块为函数名
+static string blockName(const vector<Quad>& codes, const CFG& cfg, int b) {
+    const Quad& first = codes[cfg.block(b).first];
+    if (first.op == OP_LABEL || first.op == OP_FUNC_BEGIN) return first.result;
+    return "";
+}
+
+static int blockByName(const vector<Quad>& codes, const CFG& cfg, const string& name) {
+    if (name == codes.front().result) return 0;
+    return cfg.blockOfLabel(name);
+}
+
+// PHI 的操作数按前驱块归类：incoming[p] 是来自块 p 的 (PHI 四元式, 操作数下标)
+static vector<vector<pair<int, int>>> phiIncoming(const vector<Quad>& codes, const CFG& cfg) {
+    vector<vector<pair<int, int>>> incoming(cfg.size());
+    for (int i = 0; i < (int)codes.size(); ++i) {
+        if (codes[i].op != OP_PHI) continue;
+        for (int k = 0; k < (int)codes[i].phi.size(); ++k) {
+            int p = blockByName(codes, cfg, codes[i].phi[k].second);
+            if (p >= 0) incoming[p].push_back({i, k});
+        }
+    }
+    return incoming;
+}
+
+// 变量的基本名：x.3 -> x，不带版本号的名字就是它自己
+static string baseName(const string& name) {
+    size_t dot = name.rfind('.');
+    if (dot == string::npos || dot == 0 || dot + 1 == name.size()) return name;
+    for (size_t i = dot + 1; i < name.size(); ++i) {
+        if (!isdigit((unsigned char)name[i])) return name;
+    }
+    return name.substr(0, dot);
+}
+
+// 生成函数内没有用过的标签 <函数名>.B<n>
+static string freshLabel(const string& func, set<string>& labels, int& next) {
+    string name;
+    do {
+        name = func + ".B" + to_string(next++);
+    } while (labels.count(name));
+    labels.insert(name);
+    return name;
+}
+
+int buildSSA(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    const string fname = codes.front().result;
+
+    // 1. 删除不可达的块，SSA 遍只需要考虑从入口能到达的代码
+    {
+        const CFG& cfg = func.getCFG();
+        vector<bool> removed(codes.size(), false);
+        for (int b = 0; b < cfg.size(); ++b) {
+            if (cfg.reachable(b)) continue;
+            for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+                if (codes[i].op != OP_FUNC_END) removed[i] = true;
+            }
+        }
+        if (compactQuads(codes, removed)) func.invalidate();
+    }
+
+    // 2. 每个块以标签开头，PHI 用它标识前驱；删除四元式也不会使块消失
+    {
+        const CFG& cfg = func.getCFG();
+        set<string> labels;
+        for (auto& q : codes) {
+            if (q.op == OP_LABEL) labels.insert(q.result);
+        }
+        int next = 0;
+        vector<Quad> out;
+        out.reserve(codes.size() + cfg.size());
+        for (int b = 0; b < cfg.size(); ++b) {
+            int first = cfg.block(b).first;
+            if (b > 0 && codes[first].op != OP_LABEL) out.emplace_back(OP_LABEL, "", "", freshLabel(fname, labels, next));
+            for (int i = first; i <= cfg.block(b).last; ++i) out.push_back(move(codes[i]));
+        }
+        bool changed = out.size() != codes.size();
+        codes = move(out);
+        if (changed) func.invalidate();
+    }
+
+    const CFG& cfg = func.getCFG();
+    const Liveness& liveness = func.getLiveness();
+    const Dominators& dom = func.getDominators();
+    const VarIndex& vars = liveness.getVars();
+    int nb = cfg.size();
+    int nv = vars.size();
+
+    // 3. 放置 PHI：定值所在块的迭代支配边界，且变量在该块入口活跃（剪枝）
+    vector<vector<int>> defBlocks(nv);
+    for (int b = 0; b < nb; ++b) {
+        for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+            const string* d = quadDef(codes[i]);
+            if (!d) continue;
+            int v = vars.id(*d);
+            if (defBlocks[v].empty() || defBlocks[v].back() != b) defBlocks[v].push_back(b);
+        }
+    }
+
+    struct Phi {
+        int var;
+        string result;
+        vector<string> args; // 与 preds 的顺序对应
+    };
+    vector<vector<Phi>> phis(nb);
+    vector<int> hasPhi(nb, -1), queued(nb, -1);
+    int inserted = 0;
+    for (int v = 0; v < nv; ++v) {
+        vector<int> work = defBlocks[v];
+        for (int b : work) queued[b] = v;
+        while (!work.empty()) {
+            int b = work.back();
+            work.pop_back();
+            for (int d : dom.getFrontier(b)) {
+                if (hasPhi[d] == v || !liveness.in(d).test(v)) continue;
+                hasPhi[d] = v;
+                phis[d].push_back({v, "", vector<string>(cfg.block(d).preds.size())});
+                inserted++;
+                if (queued[d] != v) {
+                    queued[d] = v;
+                    work.push_back(d);
+                }
+            }
+        }
+    }
+
+    // 4. 沿支配树先序改名（显式栈），每个变量维护当前版本的栈
+    //    新版本一律叫 <基本名>.<n>（上一轮合并出的 x.1 的新版本也是 x.<n>），
+    //    编号接在函数里这个基本名已有的最大编号之后，不会与没有改名的入口值重名
+    vector<vector<string>> stacks(nv);
+    vector<string> bases(nv);
+    map<string, long long> counter;
+    for (int v = 0; v < nv; ++v) {
+        const string& name = vars.name(v);
+        bases[v] = baseName(name);
+        long long& c = counter[bases[v]];
+        if (bases[v] != name && name.size() - bases[v].size() <= 10) c = max(c, stoll(name.substr(bases[v].size() + 1)));
+    }
+    auto current = [&](int v) { return stacks[v].empty() ? vars.name(v) : stacks[v].back(); };
+    auto fresh = [&](int v) {
+        stacks[v].push_back(bases[v] + "." + to_string(++counter[bases[v]]));
+        return stacks[v].back();
+    };
+
+    vector<vector<int>> pushed(nb);
+    vector<pair<int, bool>> work = {{0, false}};
+    while (!work.empty()) {
+        auto [b, leaving] = work.back();
+        work.pop_back();
+        if (leaving) {
+            for (int v : pushed[b]) stacks[v].pop_back();
+            continue;
+        }
+
+        for (auto& phi : phis[b]) {
+            phi.result = fresh(phi.var);
+            pushed[b].push_back(phi.var);
+        }
+        for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+            Quad& q = codes[i];
+            forEachUse(q, [&](string& s) { s = current(vars.id(s)); });
+            if (quadDef(q)) {
+                int v = vars.id(q.result);
+                q.result = fresh(v);
+                pushed[b].push_back(v);
+            }
+        }
+        for (int s : cfg.block(b).succs) {
+            const vector<int>& preds = cfg.block(s).preds;
+            int j = (int)(find(preds.begin(), preds.end(), b) - preds.begin());
+            for (auto& phi : phis[s]) phi.args[j] = current(phi.var);
+        }
+
+        work.push_back({b, true});
+        const vector<int>& children = dom.getChildren(b);
+        for (auto it = children.rbegin(); it != children.rend(); ++it) work.push_back({*it, false});
+    }
+
+    // 5. PHI 插在块开头的标签之后
+    vector<string> names(nb);
+    for (int b = 0; b < nb; ++b) names[b] = blockName(codes, cfg, b);
+    vector<Quad> out;
+    out.reserve(codes.size() + inserted);
+    for (int b = 0; b < nb; ++b) {
+        int first = cfg.block(b).first;
+        out.push_back(move(codes[first]));
+        for (auto& phi : phis[b]) {
+            out.emplace_back(OP_PHI, "", "", phi.result);
+            for (size_t j = 0; j < phi.args.size(); ++j) {
+                if (phi.args[j].empty()) phi.args[j] = vars.name(phi.var); // 前驱不可达
+                out.back().phi.push_back({move(phi.args[j]), names[cfg.block(b).preds[j]]});
+            }
+        }
+        for (int i = first + 1; i <= cfg.block(b).last; ++i) out.push_back(move(codes[i]));
+    }
+    codes = move(out);
+    func.inSSA = true;
+    func.invalidate();
+    return inserted;
+}
+
+/**
+ * 把一条边上的并行复制 (dst <- src) 串行化
+ * 先输出目标不再被其他复制读取的复制；只剩环时用一个临时变量保存某个目标的旧值来打破环
+ * 目标与某个未完成复制的源是同一变量的不同版本（x.2 <- 1, y <- x.1）时推迟它：
+ * 先写 x.2 会使两个版本同时活跃，coalesce 只好给它们不同的名字，下一轮又按名字重新排列，来回振荡
+ */
+static int sequentialize(vector<pair<string, string>> copies, vector<Quad>& out, const string& fname,
+                         set<string>& temps, int& nextTemp) {
+    copies.erase(remove_if(copies.begin(), copies.end(),
+                           [](const pair<string, string>& c) { return c.first == c.second; }),
+                 copies.end());
+    int n = (int)copies.size();
+    int emitted = 0;
+    unordered_map<string, int> readers;       // 变量还被多少条未完成的复制读取
+    unordered_map<string, int> baseReaders;   // 同上，按基本名计数
+    unordered_map<string, int> dstIndex;
+    for (int k = 0; k < n; ++k) {
+        dstIndex[copies[k].first] = k;
+        if (!isVarOperand(copies[k].second)) continue;
+        readers[copies[k].second]++;
+        baseReaders[baseName(copies[k].second)]++;
+    }
+    // 写 copies[k] 的目标会不会覆盖其他复制还要读取的同名版本
+    auto clobbers = [&](int k) {
+        const string base = baseName(copies[k].first);
+        auto it = baseReaders.find(base);
+        int others = it == baseReaders.end() ? 0 : it->second;
+        if (isVarOperand(copies[k].second) && baseName(copies[k].second) == base) others--;
+        return others > 0;
+    };
+
+    vector<bool> done(n, false);
+    // ready 是栈，倒序放入使互不相关的复制按原来的顺序输出；
+    // 否则每次构造和还原 SSA 都把它们颠倒一次，Os 的迭代永远到不了不动点
+    vector<int> ready, deferred;
+    for (int k = n - 1; k >= 0; --k) {
+        if (!readers.count(copies[k].first)) ready.push_back(k);
+    }
+    int pending = n;
+    int scan = 0;
+    while (pending > 0) {
+        while (!ready.empty() || !deferred.empty()) {
+            if (ready.empty()) {
+                // 推迟的复制中不再覆盖的重新就绪；全都还会覆盖时（版本之间的环）按原顺序输出第一条
+                vector<int> still;
+                for (int k : deferred) {
+                    if (!done[k] && clobbers(k)) still.push_back(k);
+                }
+                for (auto it = deferred.rbegin(); it != deferred.rend(); ++it) {
+                    if (!done[*it] && !clobbers(*it)) ready.push_back(*it);
+                }
+                if (ready.empty() && !still.empty()) {
+                    ready.push_back(still.front());
+                    still.erase(still.begin());
+                }
+                deferred = move(still);
+                if (ready.empty()) break;
+            }
+            int k = ready.back();
+            ready.pop_back();
+            if (done[k]) continue;
+            if (clobbers(k)) {
+                deferred.push_back(k);
+                continue;
+            }
+            done[k] = true;
+            pending--;
+            out.emplace_back(OP_ASSIGN, copies[k].second, "", copies[k].first);
+            emitted++;
+            const string& src = copies[k].second;
+            if (!isVarOperand(src)) continue;
+            baseReaders[baseName(src)]--;
+            if (--readers[src] > 0) continue;
+            auto it = dstIndex.find(src);
+            if (it != dstIndex.end() && !done[it->second]) ready.push_back(it->second);
+        }
+        if (pending == 0) break;
+
+        // 剩下的复制都在环上
+        while (done[scan]) scan++;
+        string dst = copies[scan].first;
+        string temp;
+        do {
+            temp = "." + fname + ".c" + to_string(nextTemp++);
+        } while (temps.count(temp));
+        temps.insert(temp);
+        out.emplace_back(OP_ASSIGN, dst, "", temp);
+        emitted++;
+        for (int k = 0; k < n; ++k) {
+            if (!done[k] && copies[k].second == dst) copies[k].second = temp;
+        }
+        readers[temp] = readers[dst];
+        readers[dst] = 0;
+        baseReaders[baseName(dst)] -= readers[temp];
+        baseReaders[temp] += readers[temp];
+        ready.push_back(scan);
+    }
+    return emitted;
+}
+
+/**
+ * 合并同一变量的各个版本：在每个定值点，与它同时活跃的同名版本互相干扰
+ * 对每个变量的版本贪心着色，颜色 0 用原名，其余用 x.1、x.2 ...，最后删除自身复制
+ * 不做合并的话每个版本都要占用一个栈槽
+ */
+static void coalesce(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    const CFG& cfg = func.getCFG();
+    const Liveness& liveness = func.getLiveness();
+    const VarIndex& vars = liveness.getVars();
+    int nv = vars.size();
+
+    map<string, int> baseIds;
+    vector<int> baseOf(nv);
+    vector<vector<int>> members;
+    for (int v = 0; v < nv; ++v) {
+        auto res = baseIds.emplace(baseName(vars.name(v)), (int)members.size());
+        if (res.second) members.emplace_back();
+        baseOf[v] = res.first->second;
+        members[baseOf[v]].push_back(v);
+    }
+
+    // 干扰边只在同一基本名的版本之间计算
+    vector<vector<int>> adj(nv);
+    vector<vector<int>> liveOfBase(members.size());
+    vector<int> position(nv, -1);
+    vector<int> touched;
+    auto add = [&](int v) {
+        if (position[v] >= 0 || members[baseOf[v]].size() < 2) return;
+        vector<int>& list = liveOfBase[baseOf[v]];
+        if (list.empty()) touched.push_back(baseOf[v]);
+        position[v] = (int)list.size();
+        list.push_back(v);
+    };
+    auto drop = [&](int v) {
+        if (position[v] < 0) return;
+        vector<int>& list = liveOfBase[baseOf[v]];
+        int last = list.back();
+        list[position[v]] = last;
+        position[last] = position[v];
+        list.pop_back();
+        position[v] = -1;
+    };
+
+    vector<const string*> uses;
+    for (int b = 0; b < cfg.size(); ++b) {
+        liveness.out(b).forEach(add);
+        for (int i = cfg.block(b).last; i >= cfg.block(b).first; --i) {
+            const Quad& q = codes[i];
+            if (const string* d = quadDef(q)) {
+                int v = vars.id(*d);
+                for (int w : liveOfBase[baseOf[v]]) {
+                    if (w == v || (q.op == OP_ASSIGN && vars.name(w) == q.arg1)) continue;
+                    adj[v].push_back(w);
+                    adj[w].push_back(v);
+                }
+                drop(v);
+            }
+            quadUses(q, uses);
+            for (auto u : uses) add(vars.id(*u));
+        }
+        for (int base : touched) {
+            for (int v : liveOfBase[base]) position[v] = -1;
+            liveOfBase[base].clear();
+        }
+        touched.clear();
+    }
+
+    // 贪心着色，不带版本号的原名（入口处的值）优先取得颜色 0
+    // x 组的 x.1 和 x.1 组的原名是同一个名字：每个名字只归一个组，别的组已占用的颜色跳过
+    vector<int> color(nv, -1);
+    map<string, string> rename;
+    map<string, int> owner;
+    for (auto& [base, id] : baseIds) owner[base] = id;
+    for (auto& [base, id] : baseIds) {
+        vector<int>& group = members[id];
+        stable_partition(group.begin(), group.end(), [&](int v) { return vars.name(v) == base; });
+        for (int v : group) {
+            set<int> used;
+            for (int w : adj[v]) {
+                if (color[w] >= 0) used.insert(color[w]);
+            }
+            int c = 0;
+            string name;
+            for (;; c++) {
+                if (used.count(c)) continue;
+                name = c == 0 ? base : base + "." + to_string(c);
+                auto res = owner.emplace(name, id);
+                if (res.first->second == id) break;
+            }
+            color[v] = c;
+            if (name != vars.name(v)) rename[vars.name(v)] = name;
+        }
+    }
+
+    vector<bool> removed(codes.size(), false);
+    auto apply = [&](string& s) {
+        auto it = rename.find(s);
+        if (it != rename.end()) s = it->second;
+    };
+    for (size_t i = 0; i < codes.size(); ++i) {
+        Quad& q = codes[i];
+        forEachUse(q, apply);
+        if (quadDef(q)) apply(q.result);
+        if (q.op == OP_ASSIGN && q.arg1 == q.result) removed[i] = true;
+    }
+    compactQuads(codes, removed);
+    func.invalidate();
+}
+
+/**
+ * 函数内 SSA 名字的编号、定值位置和使用位置
+ * PHI 的操作数单独记录到具体的下标，只有这一个操作数变化时不必重新计算整个 PHI
+ */
+struct SSAIndex {
+    unordered_map<string, int> ids;
+    vector<int> def;                          // 定值的四元式，-1 表示没有定值（入口处的值）
+    vector<vector<int>> uses;                 // 读取它的非 PHI 四元式
+    vector<vector<pair<int, int>>> phiUses;   // 读取它的 (PHI 四元式, 操作数下标)
+
+    int id(const string& name) {
+        auto res = ids.emplace(name, (int)def.size());
+        if (res.second) {
+            def.push_back(-1);
+            uses.emplace_back();
+            phiUses.emplace_back();
+        }
+        return res.first->second;
+    }
+
+    explicit SSAIndex(vector<Quad>& codes) {
+        for (int i = 0; i < (int)codes.size(); ++i) {
+            Quad& q = codes[i];
+            if (const string* d = quadDef(q)) def[id(*d)] = i;
+            forEachUse(q, [&](string& s) { uses[id(s)].push_back(i); });
+            for (int k = 0; k < (int)q.phi.size(); ++k) {
+                if (isVarOperand(q.phi[k].first)) phiUses[id(q.phi[k].first)].push_back({i, k});
+            }
+        }
+    }
+};
+
+/**
+ * 删除结果没有被读取的赋值、运算和 PHI（连锁删除它们的操作数随之失去的定值）
+ * 复制传播把 PHI 的操作数换成常量或代表值后，原来的定值就没有读者了；
+ * 还原 SSA 时不删除它，边上新放的复制加上留下的旧定值，每构造和还原一轮代码就变长一次
+ */
+static int removeUnusedDefs(vector<Quad>& codes) {
+    SSAIndex index(codes);
+    int n = (int)index.def.size();
+    vector<int> readers(n, 0);
+    for (int v = 0; v < n; ++v) readers[v] = (int)(index.uses[v].size() + index.phiUses[v].size());
+
+    vector<bool> removed(codes.size(), false);
+    vector<int> work;
+    auto consider = [&](int v) {
+        int d = index.def[v];
+        if (d < 0 || removed[d] || readers[v] > 0) return;
+        QuadOp op = codes[d].op;
+        if (op == OP_PHI || op == OP_ASSIGN || isArith(op)) work.push_back(d);
+    };
+    for (int v = 0; v < n; ++v) consider(v);
+    while (!work.empty()) {
+        int d = work.back();
+        work.pop_back();
+        if (removed[d]) continue;
+        removed[d] = true;
+        Quad& q = codes[d];
+        auto release = [&](const string& s) {
+            int v = index.id(s);
+            readers[v]--;
+            consider(v);
+        };
+        forEachUse(q, [&](string& s) { release(s); });
+        for (auto& in : q.phi) {
+            if (isVarOperand(in.first)) release(in.first);
+        }
+    }
+    return compactQuads(codes, removed);
+}
+
+int destroySSA(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    const string fname = codes.front().result;
+    if (removeUnusedDefs(codes)) func.invalidate();
+    const CFG& cfg = func.getCFG();
+    int nb = cfg.size();
+
+    // 1. 每条边 (p, s) 上的并行复制
+    map<pair<int, int>, vector<pair<string, string>>> edgeCopies;
+    set<string> labels, temps;
+    for (int b = 0; b < nb; ++b) {
+        for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+            const Quad& q = codes[i];
+            if (q.op == OP_LABEL) labels.insert(q.result);
+            if (q.op != OP_PHI) continue;
+            for (auto& in : q.phi) {
+                int p = blockByName(codes, cfg, in.second);
+                if (p >= 0) edgeCopies[{p, b}].push_back({q.result, in.first});
+            }
+        }
+    }
+
+    // 2. 去掉 PHI，在边上放置复制
+    //    直落或无条件跳转的块只有一个后继，复制放在块尾（跳转之前）
+    //    条件跳转的块：直落边的复制放在跳转之后，跳转边拆分出一个新块放到函数末尾
+    int labelNext = 0, tempNext = 0, copies = 0;
+    vector<Quad> out, tail;
+    out.reserve(codes.size());
+    auto place = [&](int p, int s, vector<Quad>& dst) {
+        auto it = edgeCopies.find({p, s});
+        if (it == edgeCopies.end()) return false;
+        copies += sequentialize(it->second, dst, fname, temps, tempNext);
+        return true;
+    };
+    for (int b = 0; b < nb; ++b) {
+        const BasicBlock& bb = cfg.block(b);
+        const Quad& last = codes[bb.last];
+        bool terminator = last.op == OP_JMP || last.op == OP_FUNC_END;
+        for (int i = bb.first; i <= bb.last; ++i) {
+            if (codes[i].op == OP_PHI || (i == bb.last && terminator)) continue;
+            out.push_back(codes[i]);
+        }
+        int next = b + 1 < nb ? b + 1 : -1;
+        if (last.op == OP_JMP) {
+            place(b, cfg.blockOfLabel(last.result), out);
+            out.push_back(last);
+        } else if (isBranch(last.op)) {
+            int target = cfg.blockOfLabel(last.result);
+            vector<Quad> split;
+            if (place(b, target, split)) {
+                string label = freshLabel(fname, labels, labelNext);
+                tail.emplace_back(OP_LABEL, "", "", label);
+                tail.insert(tail.end(), split.begin(), split.end());
+                tail.emplace_back(OP_JMP, "", "", last.result);
+                out.back().result = label;
+            }
+            if (next >= 0) place(b, next, out);
+        } else if (last.op != OP_RETURN && last.op != OP_FUNC_END && next >= 0) {
+            place(b, next, out);
+        }
+
+        if (last.op == OP_FUNC_END) {
+            // 拆分出的块放在函数末尾，原来直落到函数结尾的代码跳过它们
+            if (!tail.empty()) {
+                if (out.back().op != OP_JMP && out.back().op != OP_RETURN) {
+                    string exit = freshLabel(fname, labels, labelNext);
+                    out.emplace_back(OP_JMP, "", "", exit);
+                    tail.emplace_back(OP_LABEL, "", "", exit);
+                }
+                out.insert(out.end(), tail.begin(), tail.end());
+            }
+            out.push_back(last);
+        }
+    }
+
+    // 3. 删除构造时补上、现在没有跳转指向的标签
+    set<string> targets;
+    for (auto& q : out) {
+        if (isBranch(q.op)) targets.insert(q.result);
+    }
+    string prefix = fname + ".B";
+    vector<bool> removed(out.size(), false);
+    for (size_t i = 0; i < out.size(); ++i) {
+        const Quad& q = out[i];
+        if (q.op == OP_LABEL && q.result.compare(0, prefix.size(), prefix) == 0 && !targets.count(q.result)) {
+            removed[i] = true;
+        }
+    }
+    compactQuads(out, removed);
+
+    codes = move(out);
+    func.inSSA = false;
+    func.invalidate();
+    coalesce(func);
+    return copies;
+}
+
+/**
+ * Wegman-Zadeck 稀疏条件常量传播
+ * 格：TOP（尚未确定）-> 常量 -> BOTTOM（不是常量）；只沿可执行的边传播
+ * 结束后把常量代入使用处，常量定值的运算改写为赋值；分支的折叠留给 constprop / simplifycfg
+ */
+int sparseConstProp(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    const CFG& cfg = func.getCFG();
+    SSAIndex index(codes);
+    int nb = cfg.size();
+    int n = (int)index.def.size();
+
+    enum { TOP, CONST, BOTTOM };
+    vector<int> state(n, TOP), value(n, 0);
+    for (int v = 0; v < n; ++v) {
+        if (index.def[v] < 0) state[v] = BOTTOM; // 入口处的值未知
+    }
+
+    // PHI 的前驱块编号，以及按前驱块归类的 PHI 操作数
+    vector<vector<int>> phiPreds(codes.size());
+    for (size_t i = 0; i < codes.size(); ++i) {
+        for (auto& in : codes[i].phi) phiPreds[i].push_back(blockByName(codes, cfg, in.second));
+    }
+    vector<vector<pair<int, int>>> incoming = phiIncoming(codes, cfg);
+
+    set<pair<int, int>> executableEdges;
+    vector<bool> executable(nb, false);
+    vector<pair<int, int>> flowWork;
+    vector<int> ssaWork;
+
+    // 操作数的格值
+    auto eval = [&](const string& s, int& c) {
+        if (isConstOperand(s)) {
+            c = stoi(s);
+            return (int)CONST;
+        }
+        int v = index.id(s);
+        c = value[v];
+        return state[v];
+    };
+    auto lower = [&](const string& name, int st, int c) {
+        int v = index.id(name);
+        if (state[v] == BOTTOM || (state[v] == st && (st != CONST || value[v] == c))) return;
+        if (state[v] == CONST && st == CONST) st = BOTTOM; // 不同的常量
+        if (st == TOP) return;
+        state[v] = st;
+        value[v] = c;
+        ssaWork.push_back(v);
+    };
+    // PHI 的值是可执行入边上操作数的交汇；格值只会下降，所以每次只并入一个操作数即可
+    auto meetPhi = [&](int i, int k) {
+        if (!executableEdges.count({phiPreds[i][k], cfg.blockOfQuad(i)})) return;
+        int c;
+        int st = eval(codes[i].phi[k].first, c);
+        lower(codes[i].result, st, c);
+    };
+
+    auto visit = [&](int i) {
+        Quad& q = codes[i];
+        int b = cfg.blockOfQuad(i);
+        switch (q.op) {
+            case OP_PHI:
+                for (int k = 0; k < (int)q.phi.size(); ++k) meetPhi(i, k);
+                break;
+            case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: {
+                int a, c2, r;
+                int sa = eval(q.arg1, a), sb = eval(q.arg2, c2);
+                if (q.op == OP_MUL && ((sa == CONST && a == 0) || (sb == CONST && c2 == 0))) lower(q.result, CONST, 0);
+                else if (sa == BOTTOM || sb == BOTTOM) lower(q.result, BOTTOM, 0);
+                else if (sa == TOP || sb == TOP) break;
+                else if (foldArith(q.op, a, c2, r)) lower(q.result, CONST, r);
+                else lower(q.result, BOTTOM, 0);
+                break;
+            }
+            case OP_ASSIGN: {
+                int a;
+                int sa = eval(q.arg1, a);
+                lower(q.result, sa, a);
+                break;
+            }
+            case OP_CALL:
+                if (!q.result.empty()) lower(q.result, BOTTOM, 0);
+                break;
+            default:
+                break;
+        }
+
+        if (i != cfg.block(b).last) return;
+        // 块尾：确定哪些出边可执行
+        int next = b + 1 < nb ? b + 1 : -1;
+        if (q.op == OP_JMP) {
+            flowWork.push_back({b, cfg.blockOfLabel(q.result)});
+        } else if (isBranch(q.op)) {
+            int a, c2;
+            int sa = eval(q.arg1, a), sb = eval(q.arg2, c2);
+            if (sa == TOP || sb == TOP) return;
+            bool known = sa == CONST && sb == CONST;
+            bool taken = known && evalCond(q.op, a, c2);
+            if (!known || taken) flowWork.push_back({b, cfg.blockOfLabel(q.result)});
+            if ((!known || !taken) && next >= 0) flowWork.push_back({b, next});
+        } else if (q.op != OP_RETURN && q.op != OP_FUNC_END && next >= 0) {
+            flowWork.push_back({b, next});
+        }
+    };
+
+    executable[0] = true;
+    for (int i = cfg.block(0).first; i <= cfg.block(0).last; ++i) visit(i);
+    while (!flowWork.empty() || !ssaWork.empty()) {
+        while (!flowWork.empty()) {
+            auto [p, s] = flowWork.back();
+            flowWork.pop_back();
+            if (!executableEdges.insert({p, s}).second) continue;
+            if (!executable[s]) {
+                executable[s] = true;
+                for (int i = cfg.block(s).first; i <= cfg.block(s).last; ++i) visit(i);
+            } else {
+                // 新的可执行边只影响 PHI 中来自 p 的操作数
+                for (auto [i, k] : incoming[p]) {
+                    if (cfg.blockOfQuad(i) == s) meetPhi(i, k);
+                }
+            }
+        }
+        while (!ssaWork.empty()) {
+            int v = ssaWork.back();
+            ssaWork.pop_back();
+            for (int i : index.uses[v]) {
+                if (executable[cfg.blockOfQuad(i)]) visit(i);
+            }
+            for (auto [i, k] : index.phiUses[v]) {
+                if (executable[cfg.blockOfQuad(i)]) meetPhi(i, k);
+            }
+        }
+    }
+
+    // 代入常量
+    int changes = 0;
+    auto constantOf = [&](const string& s, string& c) {
+        auto it = index.ids.find(s);
+        if (it == index.ids.end() || state[it->second] != CONST) return false;
+        c = to_string(value[it->second]);
+        return true;
+    };
+    for (size_t i = 0; i < codes.size(); ++i) {
+        Quad& q = codes[i];
+        if (!executable[cfg.blockOfQuad((int)i)]) continue;
+        bool changed = false;
+        string c;
+        if (q.op == OP_PHI) {
+            for (auto& in : q.phi) {
+                if (isVarOperand(in.first) && constantOf(in.first, c)) { in.first = c; changed = true; }
+            }
+        } else {
+            if (isArith(q.op) && constantOf(q.result, c)) {
+                q.op = OP_ASSIGN;
+                q.arg1 = c;
+                q.arg2.clear();
+                changed = true;
+            }
+            forEachUse(q, [&](string& s) {
+                if (constantOf(s, c)) { s = c; changed = true; }
+            });
+        }
+        if (changed) changes++;
+    }
+    return changes;
+}
+
+// 表达式键（操作符和操作数编号的序列）的哈希
+struct ExprHash {
+    size_t operator()(const vector<int>& key) const {
+        size_t h = 14695981039346656037ull;
+        for (int x : key) h = (h ^ (unsigned)x) * 1099511628211ull;
+        return h;
+    }
+};
+
+/**
+ * 支配树上的全局值编号：相同运算（交换律规范化）的结果在被支配的块中直接复用
+ * 复制和常量赋值顺带做复制传播；操作数相同的 PHI 也视为复制
+ * SSA 名字和常量先编号为整数，值表以编号序列作键
+ * 被替换的定值变成死代码，由 ssadce 删除
+ */
+int valueNumbering(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    const CFG& cfg = func.getCFG();
+    const Dominators& dom = func.getDominators();
+    int nb = cfg.size();
+    int changes = 0;
+
+    unordered_map<string, int> ids;
+    vector<string> names;                        // 编号 -> 名字（变量或常量）
+    vector<int> leader;                          // 编号 -> 代表它的值的编号，-1 表示没有
+    unordered_map<vector<int>, int, ExprHash> table; // 表达式 -> 计算它的 SSA 名字的编号
+    vector<vector<vector<int>>> scoped(nb);      // 每个块加入表中的表达式，离开子树时删除
+    vector<vector<pair<int, int>>> incoming = phiIncoming(codes, cfg);
+
+    auto id = [&](const string& s) {
+        auto res = ids.emplace(s, (int)names.size());
+        if (res.second) {
+            names.push_back(s);
+            leader.push_back(-1);
+        }
+        return res.first->second;
+    };
+    auto look = [&](string& s) {
+        int l = leader[id(s)];
+        if (l < 0) return false;
+        s = names[l];
+        return true;
+    };
+
+    vector<pair<int, bool>> work = {{0, false}};
+    while (!work.empty()) {
+        auto [b, leaving] = work.back();
+        work.pop_back();
+        if (leaving) {
+            for (auto& key : scoped[b]) table.erase(key);
+            continue;
+        }
+
+        for (int i = cfg.block(b).first; i <= cfg.block(b).last; ++i) {
+            Quad& q = codes[i];
+            bool changed = false;
+            forEachUse(q, [&](string& s) { changed |= look(s); });
+            vector<int> key;
+            if (q.op == OP_PHI) {
+                // 除自身外所有操作数相同：PHI 就是这个值
+                const string* same = nullptr;
+                bool unique = true;
+                for (auto& in : q.phi) {
+                    if (in.first == q.result) continue;
+                    if (!same) same = &in.first;
+                    else if (in.first != *same) unique = false;
+                }
+                if (unique && same) {
+                    int v = id(*same);
+                    leader[id(q.result)] = v;
+                } else {
+                    key = {OP_PHI, b};
+                    for (auto& in : q.phi) key.push_back(id(in.first));
+                }
+            } else if (q.op == OP_ASSIGN) {
+                int v = id(q.arg1);
+                leader[id(q.result)] = v;
+            } else if (isArith(q.op)) {
+                int a = id(q.arg1), c = id(q.arg2);
+                if ((q.op == OP_ADD || q.op == OP_MUL) && c < a) swap(a, c);
+                key = {q.op, a, c};
+            }
+            if (!key.empty()) {
+                int r = id(q.result);
+                auto res = table.emplace(key, r);
+                if (res.second) {
+                    scoped[b].push_back(move(key));
+                } else {
+                    leader[r] = res.first->second;
+                    if (q.op != OP_PHI) {
+                        q.op = OP_ASSIGN;
+                        q.arg1 = names[res.first->second];
+                        q.arg2.clear();
+                        changed = true;
+                    }
+                }
+            }
+            if (changed) changes++;
+        }
+
+        // 后继 PHI 中来自本块的操作数
+        for (auto [i, k] : incoming[b]) {
+            if (look(codes[i].phi[k].first)) changes++;
+        }
+
+        work.push_back({b, true});
+        const vector<int>& children = dom.getChildren(b);
+        for (auto it = children.rbegin(); it != children.rend(); ++it) work.push_back({*it, false});
+    }
+    return changes;
+}
+
+/**
+ * 标记-清除：跳转、返回、参数和调用是有用的，有用语句读取的变量的定值也是有用的
+ * 其余的赋值、运算和 PHI（包括只在环上互相引用的 PHI）都被删除
+ */
+int sparseDeadCode(FunctionIR& func) {
+    vector<Quad>& codes = func.codes;
+    SSAIndex index(codes);
+    vector<bool> useful(codes.size(), false);
+    vector<int> work;
+    for (size_t i = 0; i < codes.size(); ++i) {
+        QuadOp op = codes[i].op;
+        if (op != OP_PHI && op != OP_ASSIGN && !isArith(op)) {
+            useful[i] = true;
+            work.push_back((int)i);
+        }
+    }
+
+    auto mark = [&](const string& s) {
+        auto it = index.ids.find(s);
+        if (it == index.ids.end()) return;
+        int d = index.def[it->second];
+        if (d >= 0 && !useful[d]) {
+            useful[d] = true;
+            work.push_back(d);
+        }
+    };
+    while (!work.empty()) {
+        Quad& q = codes[work.back()];
+        work.pop_back();
+        forEachUse(q, [&](string& s) { mark(s); });
+        for (auto& in : q.phi) {
+            if (isVarOperand(in.first)) mark(in.first);
+        }
+    }
+
+    vector<bool> removed(codes.size());
+    for (size_t i = 0; i < codes.size(); ++i) removed[i] = !useful[i];
+    return compactQuads(codes, removed);
+}
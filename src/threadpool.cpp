@@ -0,0 +1,135 @@
+#include "threadpool.h"
+#include <exception>
+
+// 当前线程在线程池中的编号，-1 表示不是工作线程
+static thread_local int workerId = -1;
+static thread_local ThreadPool* workerPool = nullptr;
+
+ThreadPool::ThreadPool(int threadCount) : pending(0), queued(0), nextQueue(0), stopping(false) {
+    if (threadCount <= 0) threadCount = (int)thread::hardware_concurrency();
+    if (threadCount <= 0) threadCount = 1;
+
+    for (int i = 0; i < threadCount; ++i) queues.push_back(make_unique<WorkQueue>());
+    for (int i = 0; i < threadCount; ++i) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+int ThreadPool::size() const {
+    return (int)workers.size();
+}
+
+/**
+ * 提交任务
+ * 工作线程提交的子任务放入自己的队列（局部性更好），外部提交则轮流分发
+ */
+void ThreadPool::submit(function<void()> task) {
+    int id;
+    if (workerPool == this && workerId >= 0) id = workerId;
+    else id = (int)(nextQueue++ % queues.size());
+
+    pending++;
+    {
+        lock_guard<mutex> guard(queues[id]->lock);
+        queues[id]->tasks.push_back(move(task));
+    }
+    {
+        // 在 sleepLock 下更新计数再通知，避免工作线程检查完队列、尚未睡眠时丢失唤醒
+        lock_guard<mutex> guard(sleepLock);
+        queued++;
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::popLocal(int id, function<void()>& task) {
+    WorkQueue& q = *queues[id];
+    lock_guard<mutex> guard(q.lock);
+    if (q.tasks.empty()) return false;
+    task = move(q.tasks.back());
+    q.tasks.pop_back();
+    queued--;
+    return true;
+}
+
+bool ThreadPool::steal(int id, function<void()>& task) {
+    int n = (int)queues.size();
+    for (int k = 1; k < n; ++k) {
+        WorkQueue& q = *queues[(id + k) % n];
+        lock_guard<mutex> guard(q.lock);
+        if (q.tasks.empty()) continue;
+        task = move(q.tasks.front());
+        q.tasks.pop_front();
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::finishTask() {
+    if (--pending == 0) {
+        lock_guard<mutex> guard(sleepLock);
+        allDone.notify_all();
+    }
+}
+
+bool ThreadPool::runOne() {
+    // 外部线程没有自己的队列，借用 0 号队列的位置开始查找
+    int id = (workerPool == this && workerId >= 0) ? workerId : 0;
+    function<void()> task;
+    if (!popLocal(id, task) && !steal(id, task)) return false;
+    task();
+    finishTask();
+    return true;
+}
+
+void ThreadPool::workerLoop(int id) {
+    workerId = id;
+    workerPool = this;
+
+    while (true) {
+        if (runOne()) continue;
+
+        unique_lock<mutex> guard(sleepLock);
+        wakeUp.wait(guard, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+void ThreadPool::parallelFor(int n, const function<void(int)>& body) {
+    if (n <= 0) return;
+    if (n == 1) { body(0); return; }
+
+    // 任务中的异常不能离开任务：在工作线程上会直接 terminate，在调用线程上会在其他任务
+    // 仍引用 remaining / body 时展开栈。记录第一个异常，全部完成后在调用线程上重新抛出
+    atomic<int> remaining(n);
+    exception_ptr firstError;
+    mutex errorLock;
+    for (int i = 0; i < n; ++i) {
+        submit([&, i] {
+            try {
+                body(i);
+            } catch (...) {
+                lock_guard<mutex> guard(errorLock);
+                if (!firstError) firstError = current_exception();
+            }
+            remaining--;
+        });
+    }
+    // 帮助执行任务直到本组全部完成；队列暂时为空时（任务正在其他线程执行）让出 CPU
+    while (remaining > 0) {
+        if (!runOne()) this_thread::yield();
+    }
+    if (firstError) rethrow_exception(firstError);
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(sleepLock);
+    allDone.wait(guard, [this] { return pending == 0; });
+}
@@ -0,0 +1,106 @@
+#include "verifier.h"
+#include "cfg.h"
+#include <set>
+#include <cerrno>
+#include <cstdlib>
+#include <climits>
+
+static string describe(const Quad& q, int index) {
+    return "quad " + to_string(index) + " (" + quadOpName(q.op) + " " + q.arg1 + " " + q.arg2 + " " + q.result + ")";
+}
+
+// 立即数必须在 32 位有符号整数范围内
+static bool validConstant(const string& s) {
+    errno = 0;
+    char* end;
+    long long v = strtoll(s.c_str(), &end, 10);
+    return *end == '\0' && errno == 0 && v >= INT_MIN && v <= INT_MAX;
+}
+
+static bool validOperand(const string& s) {
+    return !s.empty() && (!isConstOperand(s) || validConstant(s));
+}
+
+bool verifyFunction(const vector<Quad>& codes, string& error) {
+    if (codes.empty() || codes.front().op != OP_FUNC_BEGIN || codes.front().result.empty()) {
+        error = "function does not start with a named FUNC_BEGIN";
+        return false;
+    }
+    const string& name = codes.front().result;
+    if (codes.back().op != OP_FUNC_END || codes.back().result != name) {
+        error = "function " + name + " does not end with a matching FUNC_END";
+        return false;
+    }
+
+    set<string> labels;
+    for (size_t i = 0; i < codes.size(); ++i) {
+        if (codes[i].op != OP_LABEL) continue;
+        if (codes[i].result.empty() || !labels.insert(codes[i].result).second) {
+            error = "function " + name + ": " + describe(codes[i], (int)i) + ": empty or duplicate label";
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < codes.size(); ++i) {
+        const Quad& q = codes[i];
+        string problem;
+        if (q.op < OP_ADD || q.op > OP_PHI) {
+            problem = "invalid operator";
+        } else if ((q.op == OP_FUNC_BEGIN || q.op == OP_FUNC_END) && i != 0 && i + 1 != codes.size()) {
+            problem = "function boundary inside a function";
+        } else if (isArith(q.op)) {
+            if (!validOperand(q.arg1) || !validOperand(q.arg2)) problem = "missing or invalid operand";
+            else if (!isVarOperand(q.result)) problem = "result must be a variable";
+        } else if (q.op == OP_ASSIGN) {
+            if (!validOperand(q.arg1) || !q.arg2.empty()) problem = "malformed operands";
+            else if (!isVarOperand(q.result)) problem = "result must be a variable";
+        } else if (isBranch(q.op)) {
+            if (!labels.count(q.result)) problem = "jump to undefined label";
+            else if (q.op != OP_JMP && (!validOperand(q.arg1) || !validOperand(q.arg2))) problem = "missing or invalid operand";
+        } else if (q.op == OP_PARAM) {
+            if (!validOperand(q.arg1)) problem = "missing or invalid operand";
+        } else if (q.op == OP_CALL) {
+            if (q.arg1.empty() || !isConstOperand(q.arg2) || q.arg2[0] == '-') problem = "malformed call";
+            else if (!q.result.empty() && !isVarOperand(q.result)) problem = "result must be a variable";
+        } else if (q.op == OP_RETURN) {
+            if (!q.arg1.empty() && !validOperand(q.arg1)) problem = "invalid return value";
+        } else if (q.op == OP_PHI) {
+            // PHI 只能出现在块开头，值与前驱一一对应
+            QuadOp prev = i > 0 ? codes[i - 1].op : OP_FUNC_END;
+            bool matched = !q.phi.empty() && q.arg1.empty() && q.arg2.empty();
+            for (auto& in : q.phi) matched = matched && validOperand(in.first) && !in.second.empty();
+            if (prev != OP_LABEL && prev != OP_PHI) problem = "PHI not at the start of a block";
+            else if (!matched) problem = "PHI values do not match predecessors";
+            else if (!isVarOperand(q.result)) problem = "result must be a variable";
+        }
+        if (!problem.empty()) {
+            error = "function " + name + ": " + describe(q, (int)i) + ": " + problem;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool verifySSA(const vector<Quad>& codes, string& error) {
+    set<string> defined;
+    for (size_t i = 0; i < codes.size(); ++i) {
+        const string* d = quadDef(codes[i]);
+        if (d && !defined.insert(*d).second) {
+            error = describe(codes[i], (int)i) + ": " + *d + " is assigned more than once";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool verifyProgram(const vector<Quad>& codes, string& error) {
+    set<string> names;
+    for (auto& func : splitFunctions(codes)) {
+        if (!verifyFunction(func, error)) return false;
+        if (!names.insert(func.front().result).second) {
+            error = "duplicate function " + func.front().result;
+            return false;
+        }
+    }
+    return true;
+}
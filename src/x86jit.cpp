@@ -0,0 +1,378 @@
+#include "x86jit.h"
+#include "backend.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define X86JIT_NATIVE 1
+#include <sys/mman.h>
+#endif
+
+// x86-64 寄存器编号（与指令编码一致）
+enum {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R8 = 8, R9, R10, R11, R12, R13, R14, R15
+};
+
+// 生成的代码返回 rax：低 32 位为返回值，以下几位为状态
+static const uint64_t JIT_RETURNED = 1ULL << 32;
+static const uint64_t JIT_OUT_OF_FUEL = 1ULL << 33;
+static const uint64_t JIT_STACK_OVERFLOW = 1ULL << 34;
+
+// 链接时附加的公共出口，名字中的 '$' 不会出现在源程序的标识符里
+static const char* const EXIT_LABEL = "$exit";
+static const char* const FUEL_LABEL = "$fuel";
+static const char* const STACK_LABEL = "$stack";
+
+// 栈帧区的大小与模拟器相同：栈顶在地址 1024，内存下界为 -2MB
+static const int JIT_STACK_BYTES = (2 << 20) + 1024;
+
+// 运行时控制块，rbp 指向它
+struct JitControl {
+    int32_t* frameLimit;  // 被调函数的栈顶低于它时栈溢出
+    void* savedRsp;       // 进入生成的代码之前的 rsp，出口处恢复
+    void* stackTop;       // 生成的代码使用的机器栈（只保存返回地址）
+};
+
+/**
+ * x86-64 指令输出：所有变量运算都是 32 位的，rax / rdx 留给除法和返回值，
+ * rbx 为栈帧基址，r15 为迭代预算，rbp 指向 JitControl
+ * 调用使用原生的 call / ret，返回地址在独立的机器栈上，变量仍在 rbx 的栈帧中
+ */
+class X86Emitter : public TargetEmitter {
+private:
+    JitFunction& fn;
+    vector<uint8_t>& c;
+
+    void byte(uint8_t b) { c.push_back(b); }
+    void imm32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) byte((uint8_t)(v >> (8 * i)));
+    }
+    // REX 前缀（只在用到 r8-r15 或 64 位操作数时输出）
+    void rex(int reg, int rm, bool wide = false) {
+        uint8_t r = 0x40 | (wide ? 8 : 0) | ((reg >> 3) << 2) | (rm >> 3);
+        if (r != 0x40) byte(r);
+    }
+    // op r/m32, r32 形式，两个操作数都是寄存器
+    void regReg(uint8_t opcode, int reg, int rm) {
+        rex(reg, rm);
+        byte(opcode);
+        byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+    // op reg, [rbx + offset]，偏移能放进一个字节时用短格式
+    void frameAccess(uint8_t opcode, int reg, int offset) {
+        rex(reg, RBX);
+        byte(opcode);
+        if (offset >= -128 && offset <= 127) {
+            byte(0x40 | ((reg & 7) << 3) | RBX);
+            byte((uint8_t)offset);
+        } else {
+            byte(0x80 | ((reg & 7) << 3) | RBX);
+            imm32((uint32_t)offset);
+        }
+    }
+    void mov(int dst, int src) { regReg(0x89, src, dst); }
+    void rel32(const string& target) {
+        fn.fixups.push_back({c.size(), target});
+        imm32(0);
+    }
+    // 短跳转的位移在目标确定后回填
+    size_t jcc8(uint8_t opcode) {
+        byte(opcode);
+        byte(0);
+        return c.size() - 1;
+    }
+    void bind8(size_t at) { c[at] = (uint8_t)(c.size() - (at + 1)); }
+    // 向后的跳转才可能形成循环：r15 减一，借位说明预算用尽
+    void fuelCheck(const string& target) {
+        if (!fn.labels.count(target)) return;
+        byte(0x49); byte(0x83); byte(0xEF); byte(0x01); // sub r15, 1
+        byte(0x0F); byte(0x82);                         // jb $fuel
+        rel32(FUEL_LABEL);
+    }
+
+public:
+    explicit X86Emitter(JitFunction& f) : fn(f), c(f.code) {}
+
+    vector<int> allocatableRegs() const override {
+        return {RCX, RSI, RDI, R8, R9, R10, R11, R12, R13, R14};
+    }
+
+    void funcBegin(const string& name) override {
+        fn.labels[name] = c.size();
+        fn.functions.push_back(name);
+    }
+    void label(const string& name) override { fn.labels[name] = c.size(); }
+
+    void loadImm(int reg, int32_t val) override {
+        if (val == 0) {
+            regReg(0x31, reg, reg); // xor reg, reg
+            return;
+        }
+        rex(0, reg);
+        byte(0xB8 + (reg & 7));     // mov reg, imm32
+        imm32((uint32_t)val);
+    }
+
+    void load(int reg, int offset) override { frameAccess(0x8B, reg, offset); }
+    void store(int reg, int offset) override { frameAccess(0x89, reg, offset); }
+
+    void arith(QuadOp op, int rd, int rs, int rt) override {
+        if (op == OP_DIV) {
+            // 与 MIPS 模拟器一致：除数为 0 时商为 0；除数为 -1 时取负，避免 INT_MIN / -1 触发 #DE
+            mov(RAX, rs);
+            regReg(0x85, rt, rt);                            // test rt, rt
+            size_t toZero = jcc8(0x74);                      // jz zero
+            rex(0, rt); byte(0x83); byte(0xF8 | (rt & 7)); byte(0xFF); // cmp rt, -1
+            size_t toDivide = jcc8(0x75);                    // jne divide
+            byte(0xF7); byte(0xD8);                          // neg eax
+            size_t toDone1 = jcc8(0xEB);
+            bind8(toDivide);
+            byte(0x99);                                      // cdq
+            rex(0, rt); byte(0xF7); byte(0xF8 | (rt & 7));   // idiv rt
+            size_t toDone2 = jcc8(0xEB);
+            bind8(toZero);
+            regReg(0x31, RAX, RAX);
+            bind8(toDone1);
+            bind8(toDone2);
+            mov(rd, RAX);
+            return;
+        }
+        uint8_t opcode = op == OP_ADD ? 0x01 : 0x29;
+        bool commutative = op != OP_SUB;
+        auto apply = [&](int dst, int src) {
+            if (op == OP_MUL) {
+                rex(dst, src);
+                byte(0x0F); byte(0xAF);                      // imul dst, src
+                byte(0xC0 | ((dst & 7) << 3) | (src & 7));
+            } else {
+                regReg(opcode, src, dst);                    // add / sub dst, src
+            }
+        };
+        if (rd == rs) {
+            apply(rd, rt);
+        } else if (rd == rt && commutative) {
+            apply(rd, rs);
+        } else if (rd == rt) {
+            mov(RAX, rs);
+            apply(RAX, rt);
+            mov(rd, RAX);
+        } else {
+            mov(rd, rs);
+            apply(rd, rt);
+        }
+    }
+
+    void jump(const string& target) override {
+        fuelCheck(target);
+        byte(0xE9);
+        rel32(target);
+    }
+
+    void branch(QuadOp op, int rs, int rt, const string& target) override {
+        fuelCheck(target);
+        regReg(0x39, rt, rs);                                // cmp rs, rt
+        byte(0x0F);
+        byte(op == OP_JEQ ? 0x84 : 0x85);                    // je / jne
+        rel32(target);
+    }
+
+    void ret(int reg) override {
+        if (reg >= 0) {
+            mov(RAX, reg);
+            byte(0x48); byte(0x0F); byte(0xBA); byte(0xE8); byte(0x20); // bts rax, 32
+        } else {
+            regReg(0x31, RAX, RAX);
+        }
+        byte(0xC3);                                          // ret
+    }
+
+    // 返回地址由 call 压入机器栈，不使用 raOffset
+    void call(const string& name, int frameBytes, int) override {
+        byte(0x48); byte(0x81); byte(0xEB); imm32((uint32_t)frameBytes); // sub rbx, frameBytes
+        byte(0x48); byte(0x3B); byte(0x5D); byte(0x00);      // cmp rbx, [rbp]
+        byte(0x0F); byte(0x82);                              // jb $stack
+        rel32(STACK_LABEL);
+        byte(0xE8);                                          // call name
+        rel32(name);
+        byte(0x48); byte(0x81); byte(0xC3); imm32((uint32_t)frameBytes); // add rbx, frameBytes
+    }
+
+    void result(int reg) override { mov(reg, RAX); }
+};
+
+JitFunction jitCompile(const vector<Quad>& codes, const map<string, long long>* weights) {
+    JitFunction fn;
+    fn.code.reserve(codes.size() * 12);
+    X86Emitter emitter(fn);
+    Lowering lowering(emitter);
+    lowering.setVarWeights(weights);
+    lowering.lower(codes);
+    fn.frameSize = lowering.frameSize();
+    return fn;
+}
+
+X86JIT::X86JIT()
+    : mem(nullptr), memSize(0), codeBytes(0), frameBytes(0), functions(0), maxIterations(1LL << 32),
+      value(0), returned(false), runMillis(0) {}
+
+X86JIT::~X86JIT() {
+#ifdef X86JIT_NATIVE
+    if (mem) munmap(mem, memSize);
+#endif
+}
+
+void X86JIT::setMaxIterations(long long n) {
+    maxIterations = n;
+}
+
+int32_t X86JIT::result() const {
+    return value;
+}
+
+bool X86JIT::hasReturned() const {
+    return returned;
+}
+
+size_t X86JIT::codeSize() const {
+    return codeBytes;
+}
+
+/**
+ * 布局：入口（保存被调用者保存的寄存器，rbx = 栈帧基址，r15 = 迭代预算，rbp = 控制块，
+ * 切换到生成代码的机器栈后调用入口函数）、公共出口、预算用尽和栈溢出的出口，然后是各段机器码
+ */
+bool X86JIT::link(const vector<JitFunction>& parts, string& error) {
+#ifndef X86JIT_NATIVE
+    (void)parts;
+    error = "the JIT can only run on x86-64 Linux";
+    return false;
+#else
+    vector<uint8_t> code = {
+        0x53,                   // push rbx
+        0x55,                   // push rbp
+        0x41, 0x54,             // push r12
+        0x41, 0x55,             // push r13
+        0x41, 0x56,             // push r14
+        0x41, 0x57,             // push r15
+        0x48, 0x89, 0xFB,       // mov rbx, rdi
+        0x49, 0x89, 0xF7,       // mov r15, rsi
+        0x48, 0x89, 0xD5,       // mov rbp, rdx
+        0x48, 0x89, 0x65, 0x08, // mov [rbp + 8], rsp
+        0x48, 0x8B, 0x65, 0x10, // mov rsp, [rbp + 16]
+        0xE8, 0, 0, 0, 0,       // call 入口函数（没有函数时为下一条指令）
+        // $exit:
+        0x48, 0x8B, 0x65, 0x08, // mov rsp, [rbp + 8]
+        0x41, 0x5F,             // pop r15
+        0x41, 0x5E,             // pop r14
+        0x41, 0x5D,             // pop r13
+        0x41, 0x5C,             // pop r12
+        0x5D,                   // pop rbp
+        0x5B,                   // pop rbx
+        0xC3,                   // ret
+        // $fuel:
+        0x48, 0xB8, 0, 0, 0, 0, 2, 0, 0, 0, // mov rax, JIT_OUT_OF_FUEL
+        0xEB, 0xE5,             // jmp $exit
+        // $stack:
+        0x48, 0xB8, 0, 0, 0, 0, 4, 0, 0, 0, // mov rax, JIT_STACK_OVERFLOW
+        0xEB, 0xD9,             // jmp $exit
+    };
+    const size_t entryCall = 27, exitAt = 32;
+    map<string, size_t> labels;
+    vector<pair<size_t, string>> fixups;
+    labels[EXIT_LABEL] = exitAt;
+    labels[FUEL_LABEL] = exitAt + 15;
+    labels[STACK_LABEL] = exitAt + 27;
+    frameBytes = 0;
+    functions = 0;
+    vector<string> names;
+    for (auto& part : parts) {
+        size_t base = code.size();
+        for (auto& l : part.labels) {
+            if (!labels.emplace(l.first, base + l.second).second) {
+                error = "duplicate label '" + l.first + "'";
+                return false;
+            }
+        }
+        for (auto& f : part.fixups) fixups.push_back({base + f.first, f.second});
+        code.insert(code.end(), part.code.begin(), part.code.end());
+        frameBytes = max(frameBytes, part.frameSize);
+        names.insert(names.end(), part.functions.begin(), part.functions.end());
+        functions++;
+    }
+    // 没有函数时不调用，以无值返回结束
+    if (names.empty()) {
+        code[entryCall] = 0x31; code[entryCall + 1] = 0xC0; // xor eax, eax
+        code[entryCall + 2] = code[entryCall + 3] = code[entryCall + 4] = 0x90; // nop
+    } else {
+        fixups.push_back({entryCall + 1, entryFunction(names)});
+    }
+
+    for (auto& f : fixups) {
+        auto it = labels.find(f.second);
+        if (it == labels.end()) {
+            error = "jump to undefined label '" + f.second + "'";
+            return false;
+        }
+        int32_t rel = (int32_t)((long long)it->second - (long long)(f.first + 4));
+        memcpy(&code[f.first], &rel, 4);
+    }
+
+    // 先以可写方式映射并复制，再改为只读可执行，任何时刻都不同时可写和可执行
+    if (mem) munmap(mem, memSize);
+    memSize = code.size();
+    mem = mmap(nullptr, memSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        mem = nullptr;
+        error = string("mmap failed: ") + strerror(errno);
+        return false;
+    }
+    memcpy(mem, code.data(), code.size());
+    if (mprotect(mem, memSize, PROT_READ | PROT_EXEC) != 0) {
+        error = string("mprotect failed: ") + strerror(errno);
+        return false;
+    }
+    codeBytes = code.size();
+    return true;
+#endif
+}
+
+bool X86JIT::run(string& error) {
+    if (!mem) {
+        error = "program is not linked";
+        return false;
+    }
+    // 与模拟器的内存一样初始全为 0，栈帧从高地址向下使用
+    // 低端留出一个最大的栈帧（含实参区），栈顶不低于 frameLimit 时被调函数的访问都在范围内
+    // 每层调用的栈帧至少有保存返回地址的 4 字节，机器栈每层 8 字节，按两倍准备
+    vector<int32_t> frame((JIT_STACK_BYTES + frameBytes) / 4 + 1, 0);
+    unique_ptr<uint64_t[]> machineStack(new uint64_t[JIT_STACK_BYTES / 4 + 64]);
+    JitControl control = {frame.data() + frameBytes / 4 + 1, nullptr, machineStack.get() + JIT_STACK_BYTES / 4 + 64};
+    auto entry = (uint64_t (*)(int32_t*, long long, JitControl*))mem;
+
+    auto start = chrono::steady_clock::now();
+    uint64_t status = entry(frame.data() + frame.size(), maxIterations, &control);
+    runMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    if (status & JIT_OUT_OF_FUEL) {
+        error = "iteration limit of " + to_string(maxIterations) + " backward jumps exceeded";
+        return false;
+    }
+    if (status & JIT_STACK_OVERFLOW) {
+        error = "stack overflow: call frames exceed " + to_string(JIT_STACK_BYTES) + " bytes";
+        return false;
+    }
+    value = (int32_t)(uint32_t)status;
+    returned = (status & JIT_RETURNED) != 0;
+    return true;
+}
+
+void X86JIT::printReport(ostream& out) const {
+    if (returned) out << "Result: " << value << '\n';
+    else out << "Result: (no return value)" << '\n';
+    out << "Machine code: " << codeBytes << " bytes, " << functions << " functions" << '\n';
+    out << "Run time: " << runMillis << " ms" << '\n';
+}
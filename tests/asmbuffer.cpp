@@ -0,0 +1,41 @@
+#include "test.h"
+#include "asmbuffer.h"
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+// 与 ostream 的 << 格式相同（整数不受本地化影响）
+TEST(asm_buffer_formats_like_ostream) {
+    AsmBuffer buf;
+    ostringstream ref;
+    for (int v : {0, 7, -1, 32767, -32768, 65536, INT_MAX, INT_MIN}) {
+        buf << "\taddi $t0, $zero, " << v << '\n';
+        ref << "\taddi $t0, $zero, " << v << '\n';
+    }
+    buf << string("main:") << '\n';
+    ref << "main:" << '\n';
+    CHECK_EQ(buf.str(), ref.str());
+    CHECK_EQ(buf.size(), ref.str().size());
+}
+
+TEST(asm_buffer_append_take_write) {
+    AsmBuffer a, b;
+    a << "f:\n";
+    b << "\tjr $ra\n";
+    a.append(b);
+    CHECK_EQ(a.str(), string("f:\n\tjr $ra\n"));
+
+    char path[] = "/tmp/compiler-asm-XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    CHECK(a.writeFile(path));
+    ifstream in(path, ios::binary);
+    CHECK_EQ(string(istreambuf_iterator<char>(in), istreambuf_iterator<char>()), a.str());
+    remove(path);
+
+    CHECK_EQ(a.take(), string("f:\n\tjr $ra\n"));
+    CHECK_EQ(a.size(), (size_t)0);
+    CHECK(!a.writeFile("/nonexistent-dir/out.asm"));
+}
@@ -0,0 +1,95 @@
+#include "test.h"
+#include "progen.h"
+#include "mipssim.h"
+#include <filesystem>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+static string makeTempDir() {
+    char path[] = "/tmp/compiler-cache-XXXXXX";
+    return mkdtemp(path) ? path : "";
+}
+
+static string stats(CompileCache& cache) {
+    ostringstream out;
+    cache.printStats(out);
+    return out.str();
+}
+
+static CompileOutput compileCached(const string& source, CompileCache* cache, OptLevel level = OPT_O1) {
+    CompileOptions options;
+    options.passes.level = level;
+    options.cache = cache;
+    return compileSource(source, options);
+}
+
+// 条目按记号哈希和配置区分，配置不同时不命中
+TEST(cache_store_and_lookup) {
+    string dir = makeTempDir();
+    CompileCache cache(dir, 1 << 20);
+    CacheKey key = CompileCache::makeKey(42, "config-a");
+    cache.store(key, "f:\n  jr $ra\n", {"g", "h"});
+    string text;
+    vector<string> callees;
+    CHECK(cache.lookup(key, text, callees));
+    CHECK_EQ(text, string("f:\n  jr $ra\n"));
+    CHECK(callees == (vector<string>{"g", "h"}));
+    CHECK(!cache.lookup(CompileCache::makeKey(42, "config-b"), text, callees));
+    CHECK(!cache.lookup(CompileCache::makeKey(43, "config-a"), text, callees));
+    fs::remove_all(dir);
+}
+
+static int simulate(const string& assembly) {
+    MipsSimulator sim;
+    string error;
+    if (!sim.assemble(assembly, error) || !sim.run(error)) {
+        testFailure(__FILE__, __LINE__, "simulation failed: " + error);
+        return 0;
+    }
+    return sim.result();
+}
+
+// 缓存模式下只删除不可达函数（不做过程间常量传播）：第二次编译全部命中，输出与第一次相同；
+// 只修改一个函数时只有它重新生成（不可达的 unused 从不生成，每次都未命中），
+// 输出与用空缓存编译修改后的程序相同
+TEST(cache_reuses_unchanged_functions) {
+    string source = generateProgram(SHAPE_FUNCS, 11, 4 << 10) + "int unused() { return 5; }\n";
+    int expected = EXECUTE(source, OPT_O0);
+    for (OptLevel level : {OPT_O1, OPT_O2}) {
+        string dir = makeTempDir();
+        CompileCache cache(dir, 64 << 20);
+        string first = compileCached(source, &cache, level).assembly;
+        CHECK(compileCached(source, &cache, level).assembly == first);
+        CHECK(stats(cache).find(" 0 hits") == string::npos);
+        CHECK(first.find("unused:") == string::npos);
+        CHECK_EQ(simulate(first), expected);
+
+        // 改动 f1 的返回值
+        string changed = source;
+        size_t at = changed.find("return", changed.find("int f1()"));
+        changed.insert(at + 7, "1 + ");
+        CompileCache warm(dir, 64 << 20);
+        string incremental = compileCached(changed, &warm, level).assembly;
+        CHECK(stats(warm).find(" 1 stored") != string::npos);
+        string coldDir = makeTempDir();
+        CompileCache cold(coldDir, 64 << 20);
+        CHECK(incremental == compileCached(changed, &cold, level).assembly);
+        CHECK_EQ(simulate(incremental), expected + 1);
+        fs::remove_all(dir);
+        fs::remove_all(coldDir);
+    }
+}
+
+// 超过容量上限时删除条目
+TEST(cache_evicts_over_limit) {
+    string dir = makeTempDir();
+    CompileCache cache(dir, 512);
+    for (int i = 0; i < 20; ++i) cache.store(CompileCache::makeKey(i, "c"), string(100, 'x'), {});
+    cache.evict();
+    unsigned long long total = 0;
+    for (auto& e : fs::directory_iterator(dir)) total += e.file_size();
+    CHECK(total <= 512);
+    CHECK(stats(cache).find(" 0 evicted") == string::npos);
+    fs::remove_all(dir);
+}
@@ -0,0 +1,102 @@
+#include "test.h"
+#include <algorithm>
+
+// 只生成中间代码，返回优化后各个函数的名字
+static vector<string> emittedFunctions(const string& source, OptLevel level) {
+    CompileOptions options;
+    options.emitAsm = false;
+    options.emitIR = true;
+    options.passes.level = level;
+    CompileOutput out = compileSource(source, options);
+    CHECK(out.success);
+    vector<string> names;
+    for (auto& q : out.ir)
+        if (q.op == OP_FUNC_BEGIN) names.push_back(q.result);
+    return names;
+}
+
+static string firstError(const string& source) {
+    CompileOptions options;
+    options.emitAsm = false;
+    options.emitIR = true;
+    CompileOutput out = compileSource(source, options);
+    CHECK(!out.success);
+    return out.diagnostics.empty() ? string() : out.diagnostics[0].message;
+}
+
+static const char* callProgram =
+    "int add(int a, int b) {\n"
+    "    return a + b;\n"
+    "}\n"
+    "int fact(int n) {\n"
+    "    if (n) {\n"
+    "        return n * fact(n - 1);\n"
+    "    }\n"
+    "    return 1;\n"
+    "}\n"
+    "int fib(int n) {\n"
+    "    if (n) {\n"
+    "        if (n - 1) {\n"
+    "            return fib(n - 1) + fib(n - 2);\n"
+    "        }\n"
+    "        return 1;\n"
+    "    }\n"
+    "    return 0;\n"
+    "}\n"
+    "void bump(int x) {\n"
+    "    x = x + 1;\n"
+    "}\n"
+    "int main() {\n"
+    "    int s;\n"
+    "    s = add(fact(5), add(2, 3) * fib(15));\n"
+    "    bump(s);\n"
+    "    s = s + add(1, add(2, add(3, 4)));\n"
+    "    return s;\n"
+    "}\n";
+
+// 递归、嵌套调用和作为语句的调用在三种执行方式和各个优化级别下结果相同
+TEST(calls_agree_across_engines) {
+    CHECK_EQ(EXECUTE(callProgram, OPT_O0), 3180);
+    CHECK_EQ(EXECUTE(callProgram, OPT_O2), 3180);
+    CHECK_EQ(EXECUTE(callProgram, OPT_OS), 3180);
+}
+
+// main 调用到的函数（包括只被其他函数调用的）都要保留，没有调用者的函数被删除
+TEST(reachable_helpers_are_kept) {
+    string source =
+        "int leaf(int x) { return x * 3; }\n"
+        "int helper(int x) { return leaf(x) + 1; }\n"
+        "int unused(int x) { return x; }\n"
+        "int main() { return helper(4); }\n";
+    CHECK(emittedFunctions(source, OPT_O0) == (vector<string>{"leaf", "helper", "unused", "main"}));
+    vector<string> kept = emittedFunctions(source, OPT_O2);
+    CHECK(find(kept.begin(), kept.end(), "unused") == kept.end());
+    CHECK(find(kept.begin(), kept.end(), "main") != kept.end());
+    CHECK_EQ(EXECUTE(source, OPT_O2), 13);
+}
+
+// 所有调用点传入同一常量的参数在被调函数中替换为常量，结果不变
+TEST(constant_arguments_propagate) {
+    string source =
+        "int scale(int x, int k) { return x * k; }\n"
+        "int main() { return scale(3, 7) + scale(4, 7); }\n";
+    CompileOptions options;
+    options.emitAsm = false;
+    options.emitIR = true;
+    options.passes.level = OPT_O2;
+    CompileOutput out = compileSource(source, options);
+    CHECK(out.success);
+    bool folded = false;
+    for (auto& q : out.ir) folded |= q.op == OP_MUL && (q.arg1 == "7" || q.arg2 == "7");
+    CHECK(folded);
+    CHECK_EQ(EXECUTE(source, OPT_O0), 49);
+    CHECK_EQ(EXECUTE(source, OPT_O2), 49);
+    CHECK_EQ(EXECUTE(source, OPT_OS), 49);
+}
+
+TEST(call_errors_are_reported) {
+    CHECK(firstError("int main() { return g(1); }\n").find("undefined function 'g'") != string::npos);
+    CHECK(firstError("int f(int a) { return a; }\nint main() { return f(1, 2); }\n").find("takes 1 argument") !=
+          string::npos);
+    CHECK(firstError("int f(int a, int a) { return a; }\n").find("duplicate parameter") != string::npos);
+}
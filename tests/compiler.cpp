@@ -0,0 +1,57 @@
+#include "test.h"
+#include "progen.h"
+
+// 各个函数在线程池上并行生成中间代码和汇编，结果按源代码顺序拼接，与串行编译完全相同
+TEST(function_parallel_matches_serial) {
+    ThreadPool pool(4);
+    for (OptLevel level : {OPT_O0, OPT_O2, OPT_OS}) {
+        for (int s = 0; s < SHAPE_COUNT; ++s) {
+            string source = generateProgram((ProgramShape)s, 7, 8 << 10);
+            CompileOptions options;
+            options.passes.level = level;
+            CompileOutput serial = compileSource(source, options);
+            CompileOutput parallel = compileSource(source, options, &pool);
+            CHECK(serial.success && parallel.success);
+            CHECK(!serial.assembly.empty());
+            CHECK(serial.assembly == parallel.assembly);
+        }
+    }
+}
+
+// 多个函数都有错误时，报告的总是源代码中第一个
+TEST(function_parallel_reports_first_error) {
+    string source;
+    for (int i = 0; i < 20; ++i) source += "int f" + to_string(i) + "() { return g" + to_string(i) + "(); }\n";
+    ThreadPool pool(4);
+    CompileOutput serial = compileSource(source);
+    CompileOutput parallel = compileSource(source, CompileOptions(), &pool);
+    CHECK(!serial.success && !parallel.success);
+    CHECK(!serial.diagnostics.empty() && !parallel.diagnostics.empty());
+    CHECK_EQ(parallel.diagnostics[0].message, serial.diagnostics[0].message);
+    CHECK(serial.diagnostics[0].message.find("'g0'") != string::npos);
+}
+
+// 嵌入接口不向 cout / cerr 输出，错误只作为结构化诊断返回（行列号从 1 开始）
+TEST(compile_source_is_silent) {
+    ostringstream captured;
+    streambuf* savedOut = cout.rdbuf(captured.rdbuf());
+    streambuf* savedErr = cerr.rdbuf(captured.rdbuf());
+    CompileOptions options;
+    options.interpret = true;
+    options.dumpIR = true;
+    CompileOutput good = compileSource("int main() { return 6 * 7; }\n", options);
+    CompileOutput bad = compileSource("int main() {\n    return 1 +;\n}\n", options);
+    cout.rdbuf(savedOut);
+    cerr.rdbuf(savedErr);
+
+    CHECK_EQ(captured.str(), string());
+    CHECK(good.success && good.interpreted);
+    CHECK_EQ(good.interpResult, 42);
+    CHECK(!good.log.empty());
+    CHECK(!bad.success);
+    CHECK_EQ(bad.diagnostics.size(), (size_t)1);
+    if (!bad.diagnostics.empty()) {
+        CHECK_EQ(bad.diagnostics[0].severity, Diagnostic::ERROR);
+        CHECK_EQ(bad.diagnostics[0].line, 2);
+    }
+}
@@ -0,0 +1,161 @@
+#include "test.h"
+#include "driver.h"
+#include "progen.h"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+// 每个用例使用自己的临时目录
+static string makeTempDir() {
+    char path[] = "/tmp/compiler-test-XXXXXX";
+    return mkdtemp(path) ? path : "";
+}
+
+static void writeText(const string& path, const string& text) {
+    ofstream out(path, ios::binary);
+    out << text;
+}
+
+static string readText(const string& path) {
+    ifstream in(path, ios::binary);
+    stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+// 目录中的文件数（不含 . 和 ..）
+static int countFiles(const string& dir) {
+    int n = 0;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* e = readdir(d)) n += string(e->d_name) != "." && string(e->d_name) != "..";
+        closedir(d);
+    }
+    return n;
+}
+
+static void removeDir(const string& dir) {
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* e = readdir(d)) {
+            string name = e->d_name;
+            if (name != "." && name != "..") unlink((dir + "/" + name).c_str());
+        }
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+static CompileResult compileStreamed(const string& dir, const string& source) {
+    writeText(dir + "/in.c", source);
+    CompileOptions options;
+    options.quiet = true;
+    options.stream = true;
+    return compileFile({dir + "/in.c", dir + "/out.asm"}, options);
+}
+
+// 第二个函数的语法错误不能留下只有第一个函数的汇编，也不能留下临时文件
+TEST(streaming_error_leaves_no_output) {
+    string dir = makeTempDir();
+    CompileResult r = compileStreamed(dir, "int f() { return 1; }\nint g() { return 2 +; }\n");
+    CHECK(!r.success);
+    CHECK(r.diagnostics.find("2:21: error") != string::npos);
+    CHECK_EQ(countFiles(dir), 1);
+    removeDir(dir);
+}
+
+TEST(streaming_empty_input_creates_no_output) {
+    string dir = makeTempDir();
+    CompileResult r = compileStreamed(dir, "");
+    CHECK(!r.success);
+    CHECK_EQ(countFiles(dir), 1);
+    removeDir(dir);
+}
+
+// 出错时不覆盖上一次成功编译的输出
+TEST(streaming_error_keeps_previous_output) {
+    string dir = makeTempDir();
+    CHECK(compileStreamed(dir, "int f() { return 1; }\n").success);
+    string previous = readText(dir + "/out.asm");
+    CHECK(previous.find("f:") != string::npos);
+    CHECK(!compileStreamed(dir, "int f() { return 1 }\n").success);
+    CHECK_EQ(readText(dir + "/out.asm"), previous);
+    CHECK_EQ(countFiles(dir), 2);
+    removeDir(dir);
+}
+
+// 流式编译与整个文件编译在 O0 下生成相同的汇编
+TEST(streaming_matches_whole_file) {
+    string dir = makeTempDir();
+    string source = "int f() { int x = 3; while (x) { x = x - 1; } return x; }\nint g() { return 7; }\n";
+    CHECK(compileStreamed(dir, source).success);
+    string streamed = readText(dir + "/out.asm");
+    CompileOptions options;
+    options.quiet = true;
+    options.passes.level = OPT_O0;
+    CHECK(compileFile({dir + "/in.c", dir + "/whole.asm"}, options).success);
+    CHECK_EQ(streamed, readText(dir + "/whole.asm"));
+    removeDir(dir);
+}
+
+// 多个文件在线程池上并发编译（文件内的函数同样并行）时，输出与逐个串行编译相同
+TEST(parallel_files_match_serial) {
+    string dir = makeTempDir();
+    const int files = 6;
+    for (int i = 0; i < files; ++i)
+        writeText(dir + "/in" + to_string(i) + ".c", generateProgram((ProgramShape)i, 40 + i, 8 << 10));
+    CompileOptions options;
+    options.quiet = true;
+    options.passes.level = OPT_O2;
+    for (int i = 0; i < files; ++i) {
+        string in = dir + "/in" + to_string(i) + ".c";
+        CHECK(compileFile({in, dir + "/serial" + to_string(i) + ".asm"}, options).success);
+    }
+    ThreadPool pool(4);
+    vector<CompileResult> results(files);
+    for (int i = 0; i < files; ++i) {
+        pool.submit([&, i] {
+            string in = dir + "/in" + to_string(i) + ".c";
+            results[i] = compileFile({in, dir + "/parallel" + to_string(i) + ".asm"}, options, &pool);
+        });
+    }
+    pool.wait();
+    for (int i = 0; i < files; ++i) {
+        CHECK(results[i].success);
+        string serial = readText(dir + "/serial" + to_string(i) + ".asm");
+        CHECK(!serial.empty());
+        CHECK(serial == readText(dir + "/parallel" + to_string(i) + ".asm"));
+    }
+    removeDir(dir);
+}
+
+// --emit 选择的阶段：只要求 ast / ir 时不格式化后面的阶段，也不写输出文件
+TEST(emit_stages_select_output) {
+    string dir = makeTempDir();
+    writeText(dir + "/in.c", "int main() { int x = 2; return x * 21; }\n");
+    CompileOptions options;
+    options.quiet = true;
+    options.emitAsm = false;
+    options.dumpAST = true;
+    CompileResult ast = compileFile({dir + "/in.c", dir + "/out.asm"}, options);
+    CHECK(ast.success);
+    CHECK(ast.log.find("Function: int main()") != string::npos);
+    CHECK(ast.log.find("Intermediate Code") == string::npos);
+    CHECK_EQ(countFiles(dir), 1);
+
+    options.dumpAST = false;
+    options.dumpIR = true;
+    CompileResult ir = compileFile({dir + "/in.c", dir + "/out.asm"}, options);
+    CHECK(ir.success);
+    CHECK(ir.log.find("Function: int main()") == string::npos);
+    CHECK(ir.log.find("MUL") != string::npos || ir.log.find("RETURN") != string::npos);
+    CHECK_EQ(countFiles(dir), 1);
+
+    options.dumpIR = false;
+    options.emitAsm = true;
+    CompileResult full = compileFile({dir + "/in.c", dir + "/out.asm"}, options);
+    CHECK(full.success);
+    CHECK_EQ(full.log, string());
+    CHECK(readText(dir + "/out.asm").find("main:") != string::npos);
+    removeDir(dir);
+}
@@ -0,0 +1,44 @@
+#include "test.h"
+#include "instrument.h"
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+static string readText(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+// 插桩构建中编译之后报告各阶段、计数器和最慢的函数，并写出 Chrome trace；
+// 默认构建中没有任何记录，报告提示重新构建，trace 不写出
+TEST(instrument_report_and_trace) {
+    CompileOutput out = compileSource("int helper(int x) { return x + 1; }\nint main() { return helper(41); }\n");
+    CHECK(out.success);
+
+    ostringstream report;
+    instrPrintReport(report);
+    char path[] = "/tmp/compiler-trace-XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    bool traced = instrWriteTrace(path);
+    string trace = readText(path);
+    remove(path);
+
+    if (!instrumentEnabled()) {
+        CHECK(report.str().find("INSTRUMENT=1") != string::npos);
+        CHECK(!traced);
+        return;
+    }
+    CHECK(report.str().find("parse") != string::npos);
+    CHECK(report.str().find("codegen") != string::npos);
+    CHECK(report.str().find("tokens lexed") != string::npos);
+    CHECK(report.str().find("Slowest functions:") != string::npos);
+    CHECK(traced);
+    CHECK_EQ(trace.compare(0, 16, "{\"traceEvents\": "), 0);
+    // 报告只列出最慢的 10 个函数（全部用例一起执行时不一定有这里的函数），trace 中有每一次记录
+    CHECK(trace.find("\"name\": \"codegen helper\"") != string::npos);
+    CHECK(trace.find("\"name\": \"codegen main\"") != string::npos);
+    CHECK(trace.find("\"name\": \"counters\"") != string::npos);
+}
@@ -0,0 +1,51 @@
+#include "test.h"
+#include "myparser.h"
+
+// 只运行前端（不做优化），返回中间代码中出现的不同临时变量个数
+static int countTemps(const string& source) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    ASTNode* root = parser.parse();
+    InterCodeGenerator gen;
+    gen.generate(root);
+    freeAST(root);
+    set<string> temps;
+    for (auto& q : gen.getCodes()) {
+        for (const string* s : {&q.arg1, &q.arg2, &q.result})
+            if (s->compare(0, 2, ".t") == 0) temps.insert(*s);
+    }
+    return (int)temps.size();
+}
+
+// 右深的表达式 (a * b) + ((a * b) + (...))：先算较重的右子树，临时变量的个数不随深度增长
+TEST(sethi_ullman_bounds_temps) {
+    string expr = "a";
+    for (int i = 0; i < 200; ++i) expr = "(a * b) + (" + expr + ")";
+    string source = "int main() { int a = 2; int b = 3; int x; x = " + expr + "; return x; }\n";
+    CHECK(countTemps(source) <= 3);
+    CHECK_EQ(EXECUTE(source, OPT_O0), 2 + 200 * 6);
+}
+
+// 平衡的满二叉树需要的临时变量与深度相当，且已死亡的临时变量被复用
+TEST(balanced_tree_reuses_temps) {
+    string expr = "a";
+    for (int i = 0; i < 6; ++i) expr = "(" + expr + " - " + expr + " * b)";
+    string source = "int main() { int a = 1; int b = 0; return " + expr + "; }\n";
+    int temps = countTemps(source);
+    CHECK(temps >= 2 && temps <= 8);
+    CHECK_EQ(EXECUTE(source, OPT_O0), 1);
+}
+
+// 临时变量不能与名为 t0 / t1 的用户变量共用名字
+TEST(temps_do_not_shadow_user_variables) {
+    string source =
+        "int main() {\n"
+        "    int a = 5;\n"
+        "    int t0 = 2;\n"
+        "    int t1 = 9;\n"
+        "    a = (a + t0) * (t1 - a) + t0 * t1;\n"
+        "    return a;\n"
+        "}\n";
+    CHECK_EQ(EXECUTE(source, OPT_O0), 46);
+    CHECK_EQ(EXECUTE(source, OPT_O2), 46);
+}
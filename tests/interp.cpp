@@ -0,0 +1,116 @@
+#include "test.h"
+#include "interp.h"
+
+static bool runQuads(IRInterpreter& interp, const vector<Quad>& codes, string& error, const string& entry = "") {
+    return interp.load(codes, error) && interp.run(error, entry);
+}
+
+// 与模拟器相同的语义：补码回绕、除数为 0 得 0、未赋值的变量为 0、执行到函数尾返回 0
+TEST(interp_semantics) {
+    string error;
+    IRInterpreter a;
+    CHECK(runQuads(a, {{OP_FUNC_BEGIN, "", "", "main"},
+                       {OP_ADD, "2147483647", "1", "x"},
+                       {OP_DIV, "x", "0", "y"},
+                       {OP_ADD, "x", "y", "z"},
+                       {OP_SUB, "z", "u", "z"},
+                       {OP_RETURN, "z", "", ""},
+                       {OP_FUNC_END, "", "", "main"}},
+                   error));
+    CHECK_EQ(a.result(), INT32_MIN);
+    CHECK(a.hasReturned());
+
+    IRInterpreter b;
+    CHECK(runQuads(b, {{OP_FUNC_BEGIN, "", "", "main"}, {OP_ASSIGN, "5", "", "x"}, {OP_FUNC_END, "", "", "main"}},
+                   error));
+    CHECK_EQ(b.result(), 0);
+    CHECK(!b.hasReturned());
+}
+
+// 循环执行 5 次：四元式、条件跳转和基本块的计数
+TEST(interp_counts) {
+    vector<Quad> codes = {
+        {OP_FUNC_BEGIN, "", "", "main"},   // 0
+        {OP_ASSIGN, "5", "", "i"},         // 1
+        {OP_ASSIGN, "0", "", "s"},         // 2
+        {OP_LABEL, "", "", "main.L0"},     // 3
+        {OP_JEQ, "i", "0", "main.L1"},     // 4
+        {OP_ADD, "s", "i", "s"},           // 5
+        {OP_SUB, "i", "1", "i"},           // 6
+        {OP_JMP, "", "", "main.L0"},       // 7
+        {OP_LABEL, "", "", "main.L1"},     // 8
+        {OP_RETURN, "s", "", ""},          // 9
+        {OP_FUNC_END, "", "", "main"},     // 10
+    };
+    IRInterpreter interp;
+    string error;
+    CHECK(runQuads(interp, codes, error));
+    CHECK_EQ(interp.result(), 15);
+    CHECK_EQ(interp.quadCounts()[1], 1LL);
+    CHECK_EQ(interp.quadCounts()[4], 6LL);
+    CHECK_EQ(interp.quadCounts()[5], 5LL);
+    CHECK_EQ(interp.quadCounts()[9], 1LL);
+    CHECK_EQ(interp.takenCounts()[4], 1LL);
+    CHECK_EQ(interp.takenCounts()[5], 0LL);
+    bool sawLoop = false;
+    for (auto& b : interp.blockCounts()) {
+        if (b.name == "main.L0") {
+            sawLoop = true;
+            CHECK_EQ(b.first, 3);
+            CHECK_EQ(b.count, 6LL);
+        }
+    }
+    CHECK(sawLoop);
+}
+
+// 调用：实参按顺序进入被调函数的形参；也可以直接从 sub 开始执行，这时形参为 0
+TEST(interp_calls_and_entry) {
+    vector<Quad> codes = {
+        {OP_FUNC_BEGIN, "a,b", "", "sub"},
+        {OP_SUB, "a", "b", ".t0"},
+        {OP_RETURN, ".t0", "", ""},
+        {OP_FUNC_END, "", "", "sub"},
+        {OP_FUNC_BEGIN, "", "", "main"},
+        {OP_PARAM, "10", "", ""},
+        {OP_PARAM, "3", "", ""},
+        {OP_CALL, "sub", "2", "r"},
+        {OP_RETURN, "r", "", ""},
+        {OP_FUNC_END, "", "", "main"},
+    };
+    IRInterpreter interp;
+    string error;
+    CHECK(runQuads(interp, codes, error));
+    CHECK_EQ(interp.result(), 7);
+    IRInterpreter direct;
+    CHECK(runQuads(direct, codes, error, "sub"));
+    CHECK_EQ(direct.result(), 0);
+}
+
+TEST(interp_reports_errors) {
+    string error;
+    IRInterpreter label;
+    CHECK(!label.load({{OP_FUNC_BEGIN, "", "", "main"}, {OP_JMP, "", "", "nowhere"}, {OP_FUNC_END, "", "", "main"}},
+                      error));
+    CHECK(error.find("nowhere") != string::npos);
+
+    IRInterpreter callee;
+    CHECK(!callee.load({{OP_FUNC_BEGIN, "", "", "main"}, {OP_CALL, "g", "0", "r"}, {OP_FUNC_END, "", "", "main"}},
+                       error));
+
+    IRInterpreter spin;
+    spin.setMaxSteps(1000);
+    CHECK(!runQuads(spin,
+                    {{OP_FUNC_BEGIN, "", "", "main"},
+                     {OP_LABEL, "", "", "main.L0"},
+                     {OP_JMP, "", "", "main.L0"},
+                     {OP_FUNC_END, "", "", "main"}},
+                    error));
+    CHECK(!error.empty());
+
+    IRInterpreter deep;
+    deep.setMaxDepth(100);
+    CHECK(!runQuads(deep,
+                    {{OP_FUNC_BEGIN, "", "", "main"}, {OP_CALL, "main", "0", "r"}, {OP_FUNC_END, "", "", "main"}},
+                    error));
+    CHECK(!error.empty());
+}
@@ -0,0 +1,124 @@
+#include "test.h"
+#include "driver.h"
+#include "irfile.h"
+#include "mipssim.h"
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+static string makeTempDir() {
+    char path[] = "/tmp/compiler-ir-XXXXXX";
+    return mkdtemp(path) ? path : "";
+}
+
+static string readBytes(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static void writeBytes(const string& path, const string& bytes) {
+    ofstream out(path, ios::binary);
+    out << bytes;
+}
+
+static const char* irProgram =
+    "int twice(int x) { return x + x; }\n"
+    "int sum(int a, int b, int c) { int s = a; while (c) { s = s + b; c = c - 1; } return s; }\n"
+    "int main() { int k = 3; return sum(twice(k), k, 4) + twice(sum(1, 2, k)); }\n";
+
+static vector<Quad> frontEnd(const string& source, OptLevel level) {
+    CompileOptions options;
+    options.emitAsm = false;
+    options.emitIR = true;
+    options.passes.level = level;
+    CompileOutput out = compileSource(source, options);
+    CHECK(out.success);
+    return out.ir;
+}
+
+static bool sameQuads(const vector<Quad>& a, const vector<Quad>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].op != b[i].op || a[i].arg1 != b[i].arg1 || a[i].arg2 != b[i].arg2 || a[i].result != b[i].result)
+            return false;
+    }
+    return true;
+}
+
+// 写入再读出得到相同的四元式（包括 FUNC_BEGIN 中的形参列表），按函数读取与整体读取一致
+TEST(ir_file_round_trip) {
+    string dir = makeTempDir();
+    for (OptLevel level : {OPT_O0, OPT_O2}) {
+        vector<Quad> codes = frontEnd(irProgram, level);
+        CHECK(writeIRFile(dir + "/p.qir", codes));
+        IRFile ir;
+        string error;
+        CHECK(ir.open(dir + "/p.qir", error));
+        CHECK(sameQuads(ir.allQuads(), codes));
+        vector<vector<Quad>> parts = splitFunctions(codes);
+        CHECK_EQ(ir.functionCount(), (int)parts.size());
+        for (int i = 0; i < ir.functionCount() && i < (int)parts.size(); ++i) {
+            CHECK_EQ(ir.functionName(i), parts[i].front().result);
+            CHECK(sameQuads(ir.functionQuads(i), parts[i]));
+        }
+    }
+    fs::remove_all(dir);
+}
+
+// --emit-ir 之后 --from-ir 生成的汇编与直接编译相同
+TEST(ir_file_backend_matches_direct) {
+    string dir = makeTempDir();
+    writeBytes(dir + "/p.c", irProgram);
+    CompileOptions options;
+    options.quiet = true;
+    options.passes.level = OPT_O2;
+    CHECK(compileFile({dir + "/p.c", dir + "/direct.asm"}, options).success);
+    options.emitIR = true;
+    CHECK(compileFile({dir + "/p.c", dir + "/p.qir"}, options).success);
+    options.emitIR = false;
+    options.fromIR = true;
+    CHECK(compileFile({dir + "/p.qir", dir + "/backend.asm"}, options).success);
+    string direct = readBytes(dir + "/direct.asm");
+    CHECK(!direct.empty());
+    CHECK(direct == readBytes(dir + "/backend.asm"));
+
+    MipsSimulator sim;
+    string error;
+    CHECK(sim.assemble(direct, error) && sim.run(error));
+    CHECK_EQ(sim.result(), EXECUTE(irProgram, OPT_O0));
+    fs::remove_all(dir);
+}
+
+// 截断、魔数错误、越界的字符串编号都在 open 时拒绝，而不是在访问时越界
+TEST(ir_file_rejects_malformed) {
+    string dir = makeTempDir();
+    CHECK(writeIRFile(dir + "/p.qir", frontEnd(irProgram, OPT_O0)));
+    string good = readBytes(dir + "/p.qir");
+    IRFileHeader header;
+    memcpy(&header, good.data(), sizeof(header));
+
+    vector<string> bad;
+    bad.push_back(good.substr(0, 10));
+    bad.push_back(good.substr(0, good.size() - 4));
+    bad.push_back("XQIR" + good.substr(4));
+    string outOfRange = good;
+    uint32_t id = header.stringCount + 7;
+    memcpy(&outOfRange[good.size() - sizeof(IRQuadRecord) + 4], &id, 4);
+    bad.push_back(outOfRange);
+    string badOp = good;
+    uint32_t op = 1000;
+    memcpy(&badOp[good.size() - sizeof(IRQuadRecord)], &op, 4);
+    bad.push_back(badOp);
+
+    for (size_t i = 0; i < bad.size(); ++i) {
+        writeBytes(dir + "/bad.qir", bad[i]);
+        IRFile ir;
+        string error;
+        CHECK(!ir.open(dir + "/bad.qir", error));
+        CHECK(!error.empty());
+    }
+    fs::remove_all(dir);
+}
@@ -0,0 +1,81 @@
+#include "test.h"
+#include "mipssim.h"
+#include <iostream>
+#include <cstring>
+
+using namespace std;
+
+static int failures = 0;
+
+vector<TestCase>& testRegistry() {
+    static vector<TestCase> tests;
+    return tests;
+}
+
+void testFailure(const char* file, int line, const string& message) {
+    cerr << file << ":" << line << ": check failed: " << message << endl;
+    failures++;
+}
+
+Execution execute(const string& source, OptLevel level, const vector<string>& passes) {
+    Execution e;
+    CompileOptions options;
+    options.quiet = true;
+    options.interpret = true;
+    options.passes.level = level;
+    options.passes.enable = passes;
+    options.passes.verify = true;
+    CompileOutput out = compileSource(source, options);
+    for (auto& d : out.diagnostics) {
+        if (e.error.empty()) e.error = formatDiagnostic(d);
+    }
+    if (!out.success || !e.error.empty()) return e;
+    e.interp = out.interpResult;
+
+    MipsSimulator sim;
+    if (!sim.assemble(out.assembly, e.error) || !sim.run(e.error)) return e;
+    e.sim = sim.result();
+
+    options.interpret = false;
+    options.run = true;
+    out = compileSource(source, options);
+    if (!out.success || !out.ran) {
+        e.error = out.diagnostics.empty() ? "JIT did not run" : formatDiagnostic(out.diagnostics[0]);
+        return e;
+    }
+    e.jit = out.runResult;
+    e.ok = true;
+    return e;
+}
+
+int executeAgreed(const char* file, int line, const string& source, OptLevel level) {
+    Execution e = execute(source, level);
+    if (!e.ok) {
+        testFailure(file, line, "execution failed: " + e.error);
+        return 0;
+    }
+    if (e.interp != e.sim || e.interp != e.jit) {
+        testFailure(file, line, "interpreter " + to_string(e.interp) + ", simulator " + to_string(e.sim) +
+                                    ", JIT " + to_string(e.jit));
+        return 0;
+    }
+    return e.interp;
+}
+
+/**
+ * 执行全部用例，或名字包含某个参数的用例
+ */
+int main(int argc, char* argv[]) {
+    int run = 0;
+    for (auto& t : testRegistry()) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) selected |= strstr(t.name, argv[i]) != nullptr;
+        if (!selected) continue;
+        int before = failures;
+        t.run();
+        run++;
+        cout << (failures == before ? "[ OK ] " : "[FAIL] ") << t.name << endl;
+    }
+    cout << run << " test(s), " << failures << " failed check(s)" << endl;
+    return failures == 0 ? 0 : 1;
+}
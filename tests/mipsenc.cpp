@@ -0,0 +1,74 @@
+#include "test.h"
+#include "mipssim.h"
+#include "progen.h"
+
+static CompileOutput compileAs(const string& source, OutputFormat format, OptLevel level = OPT_O2) {
+    CompileOptions options;
+    options.format = format;
+    options.passes.level = level;
+    CompileOutput out = compileSource(source, options);
+    CHECK(out.success);
+    return out;
+}
+
+// 直接编码的机器码与汇编文本在模拟器上逐条对应：结果、动态指令数和周期数都相同
+// （模拟器的汇编器没有偏移范围限制，松弛后的分支多一次冲刷，此时不比较周期数）
+static void checkSameAsAsm(const string& source, OptLevel level, bool sameCycles = true) {
+    CompileOutput text = compileAs(source, FORMAT_ASM, level);
+    CompileOutput bin = compileAs(source, FORMAT_BIN, level);
+    MipsSimulator a, b;
+    string error;
+    CHECK(a.assemble(text.assembly, error) && a.run(error));
+    CHECK(b.load(bin.object.text, error) && b.run(error));
+    CHECK_EQ(b.result(), a.result());
+    CHECK_EQ(b.getStats().instructions, a.getStats().instructions);
+    if (sameCycles) CHECK_EQ(b.getStats().cycles, a.getStats().cycles);
+}
+
+TEST(encoder_matches_assembler) {
+    checkSameAsAsm("int f(int a, int b) { if (a) { return f(a - 1, b * 2) + b; } return 0; }\n"
+                   "int main() { return f(10, 3) / (0 - 7); }\n",
+                   OPT_O0);
+    for (int s = 0; s < SHAPE_COUNT; ++s) {
+        string source = generateProgram((ProgramShape)s, 21, 4 << 10);
+        checkSameAsAsm(source, OPT_O0);
+        checkSameAsAsm(source, OPT_O2);
+    }
+}
+
+// if 的主体超过 beq 的 16 位偏移时改写为反向分支加 j，结果不变
+TEST(encoder_relaxes_long_branches) {
+    string source = "int main() {\n    int x = 1;\n    int y = 0;\n    if (x) {\n";
+    for (int i = 0; i < 12000; ++i) source += "        y = y + x;\n";
+    source += "    }\n    return y;\n}\n";
+    CompileOutput bin = compileAs(source, FORMAT_BIN, OPT_O0);
+    CHECK(bin.object.relaxedBranches > 0);
+    checkSameAsAsm(source, OPT_O0, false);
+}
+
+static uint32_t bigEndian(const string& s, size_t at) {
+    return (uint32_t)(unsigned char)s[at] << 24 | (uint32_t)(unsigned char)s[at + 1] << 16 |
+           (uint32_t)(unsigned char)s[at + 2] << 8 | (uint32_t)(unsigned char)s[at + 3];
+}
+
+// ELF32 大端可重定位目标文件，符号表中有每个函数；裸映像是 .text 的大端序字
+TEST(encoder_elf_and_raw_layout) {
+    CompileOutput out = compileAs("int helper(int x) { return x * 2; }\nint main() { return helper(21); }\n",
+                                  FORMAT_ELF, OPT_O0);
+    string elf = mipsElfObject(out.object);
+    CHECK(elf.size() > 52);
+    CHECK_EQ(elf.compare(0, 4, "\x7f" "ELF"), 0);
+    CHECK_EQ((int)elf[4], 1);   // ELFCLASS32
+    CHECK_EQ((int)elf[5], 2);   // ELFDATA2MSB
+    CHECK_EQ((int)elf[17], 1);  // ET_REL
+    CHECK_EQ((int)elf[19], 8);  // EM_MIPS
+    CHECK(elf.find(string("helper") + '\0') != string::npos);
+    CHECK(elf.find(string("main") + '\0') != string::npos);
+    CHECK(!out.object.jumpRelocs.empty());
+
+    string raw = mipsRawImage(out.object);
+    CHECK_EQ(raw.size(), out.object.text.size() * 4);
+    bool same = true;
+    for (size_t i = 0; i < out.object.text.size(); ++i) same &= bigEndian(raw, i * 4) == out.object.text[i];
+    CHECK(same);
+}
@@ -0,0 +1,81 @@
+#include "test.h"
+#include "mipssim.h"
+
+static MipsSimulator runAsm(const string& body, bool expectOk = true, string* error = nullptr) {
+    MipsSimulator sim;
+    string e;
+    bool ok = sim.assemble(".data\n.text\n" + body + "Program_End:\n\tj Program_End\n", e) && sim.run(e);
+    CHECK_EQ(ok, expectOk);
+    if (error) *error = e;
+    return sim;
+}
+
+// 补码回绕、除数为 0、负数除法向 0 截断
+TEST(sim_arithmetic) {
+    CHECK_EQ(runAsm("\tlui $t0, 32767\n\tori $t0, $t0, 65535\n\taddi $v0, $t0, 1\n").result(), INT32_MIN);
+    CHECK_EQ(runAsm("\taddi $t0, $zero, 7\n\tdiv $t0, $zero\n\tmflo $v0\n").result(), 0);
+    CHECK_EQ(runAsm("\taddi $t0, $zero, -7\n\taddi $t1, $zero, 2\n\tdiv $t0, $t1\n\tmflo $v0\n").result(), -3);
+    CHECK_EQ(runAsm("\taddi $t0, $zero, -7\n\taddi $t1, $zero, 2\n\tdiv $t0, $t1\n\tmfhi $v0\n").result(), -1);
+    CHECK_EQ(runAsm("\tori $t0, $zero, 46341\n\tmult $t0, $t0\n\tmflo $v0\n").result(), (int32_t)(46341u * 46341u));
+    CHECK_EQ(runAsm("\taddi $zero, $zero, 5\n\tadd $v0, $zero, $zero\n").result(), 0);
+}
+
+// jal / jr 与栈上的保存和恢复
+TEST(sim_call_and_return) {
+    string body =
+        "\taddi $sp, $zero, 1024\n"
+        "\taddi $a0, $zero, 5\n"
+        "\tjal square\n"
+        "\tj Program_End\n"
+        "square:\n"
+        "\tsw $a0, -4($sp)\n"
+        "\tlw $t0, -4($sp)\n"
+        "\tmult $t0, $t0\n"
+        "\tmflo $v0\n"
+        "\tjr $ra\n";
+    CHECK_EQ(runAsm(body).result(), 25);
+}
+
+// 一个执行 3 次的循环：动态指令数、访存、分支和 load-use 停顿
+TEST(sim_counters) {
+    string body =
+        "\taddi $sp, $zero, 1024\n"
+        "\taddi $t0, $zero, 3\n"
+        "\taddi $v0, $zero, 0\n"
+        "loop:\n"
+        "\tbeq $t0, $zero, Program_End\n"
+        "\tsw $t0, -4($sp)\n"
+        "\tlw $t1, -4($sp)\n"
+        "\tadd $v0, $v0, $t1\n"
+        "\taddi $t0, $t0, -1\n"
+        "\tj loop\n";
+    MipsSimulator sim = runAsm(body);
+    const SimStats& s = sim.getStats();
+    CHECK_EQ(sim.result(), 6);
+    CHECK_EQ(s.instructions, 3LL + 3 * 6 + 1);
+    CHECK_EQ(s.opCounts[MOP_BEQ], 4LL);
+    CHECK_EQ(s.loads, 3LL);
+    CHECK_EQ(s.stores, 3LL);
+    CHECK_EQ(s.branches, 4LL);
+    CHECK_EQ(s.takenBranches, 1LL);
+    CHECK_EQ(s.jumps, 3LL);
+    CHECK_EQ(s.loadUseStalls, 3LL);
+    CHECK(s.cycles >= s.instructions + s.loadUseStalls + s.branchStalls + s.flushStalls);
+}
+
+TEST(sim_reports_errors) {
+    string error;
+    MipsSimulator sim;
+    CHECK(!sim.assemble(".text\n\taddi $t0, $zero, 1\n\tfrob $t0\n", error));
+    CHECK(error.find("line 3") != string::npos);
+    CHECK(!sim.assemble(".text\n\tj nowhere\n", error));
+
+    runAsm("\taddi $t0, $zero, 0\n\tlui $t0, 32767\n\tlw $v0, 0($t0)\n", false, &error);
+    CHECK(!error.empty());
+
+    MipsSimulator loop;
+    CHECK(loop.assemble(".text\nspin:\n\taddi $t0, $t0, 1\n\tj spin\n", error));
+    loop.setMaxSteps(1000);
+    CHECK(!loop.run(error));
+    CHECK(!error.empty());
+}
@@ -0,0 +1,140 @@
+#include "test.h"
+#include "myparser.h"
+#include "progen.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 统计尚未释放的堆分配，检查语法错误之后没有留下语法树结点
+// 插桩构建（make INSTRUMENT=1）已经替换了全局 operator new，此时不统计
+static atomic<long> liveAllocations(0);
+
+#ifndef COMPILER_INSTRUMENT
+void* operator new(size_t n) {
+    liveAllocations++;
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    liveAllocations--;
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+#endif
+
+static bool parseFails(const string& source) {
+    try {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        freeAST(parser.parse());
+    } catch (const SyntaxError&) {
+        return true;
+    }
+    return false;
+}
+
+// 在每个位置截断一个含嵌套 if / else / while / 块和括号表达式的程序，
+// 出错时显式栈上已经建立的结点都要释放（--server 长期运行）
+TEST(syntax_error_frees_partial_ast) {
+    string source =
+        "int f() { int a = (1 + 2) * (3 - (4 / 5)); }\n"
+        "int h(int p, int q) { h(p, (q + f()) * h(1, 2)); return f(); }\n"
+        "int g() {\n"
+        "    int x = 1;\n"
+        "    while (x) {\n"
+        "        if ((x + 1) * 2) { x = x - 1; } else { if (x) x = 0; else { x = (x + 3) * 4; } }\n"
+        "    }\n"
+        "    return (x + (2 * (3 + x)));\n"
+        "}\n";
+    CHECK(!parseFails(source));
+    int failures = 0;
+    for (size_t cut = 1; cut < source.size(); ++cut) {
+        long before = liveAllocations;
+        string truncated = source.substr(0, cut) + " ;";
+        bool failed = parseFails(truncated);
+        truncated.clear();
+        truncated.shrink_to_fit();
+        if (failed) failures++;
+        CHECK_EQ(liveAllocations - before, 0L);
+    }
+    CHECK(failures > 100);
+}
+
+// 嵌套深度远超调用栈能承受的递归深度：解析、生成中间代码和执行都不能溢出
+TEST(deep_nesting_does_not_overflow) {
+    const int depth = 100000;
+    const int blocks = 10000;
+    string source = "int main() {\n    int x = 1;\n    int y = 0;\n    y = ";
+    source.append(depth, '(');
+    source += "x";
+    for (int i = 0; i < depth; ++i) source += " + 1)";
+    source += ";\n";
+    for (int i = 0; i < blocks; ++i) source += i % 2 ? "while (x) {" : "if (x) {";
+    source += "y = y + 1; x = 0;";
+    source.append(blocks, '}');
+    source += "\n    return y;\n}\n";
+    CHECK_EQ(EXECUTE(source, OPT_O0), depth + 2);
+}
+
+// 语法树的打印同样不递归
+TEST(deep_ast_prints) {
+    const int depth = 5000;
+    string source = "int main() { return ";
+    source.append(depth, '(');
+    source += "1";
+    for (int i = 0; i < depth; ++i) source += " * 2)";
+    source += "; }\n";
+    CompileOptions options;
+    options.emitAsm = false;
+    options.dumpAST = true;
+    CompileOutput out = compileSource(source, options);
+    CHECK(out.success);
+    CHECK(out.log.find("Function: int main()") != string::npos);
+    size_t ops = 0;
+    for (size_t p = out.log.find("Op: *"); p != string::npos; p = out.log.find("Op: *", p + 1)) ops++;
+    CHECK_EQ(ops, (size_t)depth);
+}
+
+// 较大的文件按顶层花括号切分后并行解析：语法树、记号哈希与串行解析相同
+TEST(parallel_parse_matches_serial) {
+    string source = generateProgram(SHAPE_MIXED, 9, 600 << 10);
+    ThreadPool pool(4);
+    ASTNode* serial = parseProgram(source, nullptr);
+    ASTNode* parallel = parseProgram(source, &pool);
+    ostringstream a, b;
+    printAST(serial, a);
+    printAST(parallel, b);
+    CHECK(a.str() == b.str());
+    auto& fs = ((ProgramNode*)serial)->elements;
+    auto& fp = ((ProgramNode*)parallel)->elements;
+    CHECK_EQ(fs.size(), fp.size());
+    bool sameHashes = fs.size() == fp.size();
+    for (size_t i = 0; sameHashes && i < fs.size(); ++i)
+        sameHashes = ((FuncDef*)fs[i])->tokenHash == ((FuncDef*)fp[i])->tokenHash;
+    CHECK(sameHashes);
+    freeAST(serial);
+    freeAST(parallel);
+}
+
+// 后面某一段中的语法错误报告的位置与串行解析相同
+TEST(parallel_parse_error_position) {
+    string source = generateProgram(SHAPE_FUNCS, 9, 400 << 10);
+    int lines = 1;
+    for (char c : source) lines += c == '\n';
+    source += "int broken() {\n    return 1 +;\n}\n";
+    ThreadPool pool(4);
+    CompileOutput serial = compileSource(source);
+    CompileOutput parallel = compileSource(source, CompileOptions(), &pool);
+    CHECK(!serial.success && !parallel.success);
+    CHECK(!serial.diagnostics.empty() && !parallel.diagnostics.empty());
+    if (serial.diagnostics.empty() || parallel.diagnostics.empty()) return;
+    CHECK_EQ(serial.diagnostics[0].line, lines + 1);
+    CHECK_EQ(parallel.diagnostics[0].line, serial.diagnostics[0].line);
+    CHECK_EQ(parallel.diagnostics[0].column, serial.diagnostics[0].column);
+    CHECK_EQ(parallel.diagnostics[0].message, serial.diagnostics[0].message);
+}
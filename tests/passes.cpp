@@ -0,0 +1,102 @@
+#include "test.h"
+#include "verifier.h"
+
+static string pipeline(OptLevel level, const vector<string>& enable = {}, const vector<string>& disable = {}) {
+    PassOptions options;
+    options.level = level;
+    options.enable = enable;
+    options.disable = disable;
+    return PassManager(options).describe();
+}
+
+// 优化级别决定流水线，-fpass= / -fno-pass= 在此基础上增删，顺序保持固定
+TEST(pass_pipeline_per_level) {
+    CHECK_EQ(pipeline(OPT_O0), string("none"));
+    CHECK_EQ(pipeline(OPT_O1), string("callgraph"));
+    CHECK_EQ(pipeline(OPT_O2), string("constprop,simplifycfg,sccp,gvn,ssadce,dce,callgraph"));
+    CHECK_EQ(pipeline(OPT_OS), string("Os:constprop,simplifycfg,sccp,gvn,ssadce,dce,callgraph"));
+    CHECK_EQ(pipeline(OPT_O2, {}, {"sccp", "callgraph"}), string("constprop,simplifycfg,gvn,ssadce,dce"));
+    CHECK_EQ(pipeline(OPT_O0, {"dce", "constprop"}), string("constprop,dce"));
+    CHECK(isKnownPass("gvn"));
+    CHECK(isKnownPass("callgraph"));
+    CHECK(!isKnownPass("inline"));
+}
+
+// 每个遍都记录在统计中，顺序为第一次执行的顺序
+TEST(pass_statistics_record_every_pass) {
+    PassStatistics stats;
+    CompileOptions options;
+    options.passes.level = OPT_O2;
+    options.passStats = &stats;
+    CHECK(compileSource("int main() { int x = 4; int y; y = x * 2; while (x) { x = x - 1; } return y; }\n", options)
+              .success);
+    ostringstream out;
+    stats.print(out);
+    string text = out.str();
+    size_t last = 0;
+    for (const char* pass : {"constprop", "simplifycfg", "sccp", "gvn", "ssadce", "dce", "callgraph"}) {
+        size_t at = text.find(string("  ") + pass + " ");
+        CHECK(at != string::npos && at >= last);
+        if (at != string::npos) last = at;
+    }
+}
+
+// O0 不修改前端生成的中间代码，O2 / Os 把常量程序折叠为一条返回
+TEST(pass_levels_change_ir) {
+    string source = "int main() { int x = 4; int y; y = x * 2 + 1; return y; }\n";
+    size_t sizes[3];
+    OptLevel levels[3] = {OPT_O0, OPT_O2, OPT_OS};
+    for (int i = 0; i < 3; ++i) {
+        CompileOptions options;
+        options.emitAsm = false;
+        options.emitIR = true;
+        options.passes.level = levels[i];
+        options.passes.verify = true;
+        CompileOutput out = compileSource(source, options);
+        CHECK(out.success);
+        sizes[i] = out.ir.size();
+        if (i > 0) {
+            bool folded = false;
+            for (auto& q : out.ir) folded |= q.op == OP_RETURN && q.arg1 == "9";
+            CHECK(folded);
+        }
+    }
+    CHECK(sizes[1] < sizes[0]);
+    CHECK(sizes[2] <= sizes[1]);
+}
+
+// 校验器发现函数边界、标签和 SSA 单一定值的错误
+TEST(verifier_rejects_malformed_ir) {
+    string error;
+    vector<Quad> good = {{OP_FUNC_BEGIN, "", "", "f"},
+                         {OP_LABEL, "", "", "f.L0"},
+                         {OP_JEQ, "x", "0", "f.L0"},
+                         {OP_RETURN, "x", "", ""},
+                         {OP_FUNC_END, "", "", "f"}};
+    CHECK(verifyFunction(good, error));
+    CHECK(verifySSA(good, error));
+
+    vector<Quad> badLabel = good;
+    badLabel[2].result = "f.L9";
+    CHECK(!verifyFunction(badLabel, error));
+    CHECK(!error.empty());
+
+    vector<Quad> duplicateLabel = good;
+    duplicateLabel.insert(duplicateLabel.begin() + 2, Quad(OP_LABEL, "", "", "f.L0"));
+    CHECK(!verifyFunction(duplicateLabel, error));
+
+    vector<Quad> noEnd(good.begin(), good.end() - 1);
+    CHECK(!verifyFunction(noEnd, error));
+
+    vector<Quad> twice = good;
+    twice.insert(twice.end(), good.begin(), good.end());
+    CHECK(!verifyProgram(twice, error));
+
+    vector<Quad> redefined = {{OP_FUNC_BEGIN, "", "", "f"},
+                              {OP_ASSIGN, "1", "", "x"},
+                              {OP_ASSIGN, "2", "", "x"},
+                              {OP_RETURN, "x", "", ""},
+                              {OP_FUNC_END, "", "", "f"}};
+    CHECK(verifyFunction(redefined, error));
+    CHECK(!verifySSA(redefined, error));
+}
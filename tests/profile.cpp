@@ -0,0 +1,100 @@
+#include "test.h"
+#include "mipssim.h"
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+// 循环中的 if 几乎总是走 else 分支，main 调用 hot 3 次
+static const char* pgoProgram =
+    "int hot(int n) {\n"
+    "    int s = 0;\n"
+    "    while (n) {\n"
+    "        if (n - 500) { s = s + 1; } else { s = s * 3; }\n"
+    "        n = n - 1;\n"
+    "    }\n"
+    "    return s;\n"
+    "}\n"
+    "int main() { return hot(1000) + hot(10) + hot(1); }\n";
+
+static CompileOutput compileWithProfile(const string& source, bool generate, const Profile* use) {
+    CompileOptions options;
+    options.passes.level = OPT_O1;
+    if (generate) options.profileGenerate = "unused.qprof";
+    options.profileUse = use;
+    return compileSource(source, options);
+}
+
+static string tempPath() {
+    char path[] = "/tmp/compiler-profile-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    return path;
+}
+
+// 生成的计数：每个函数的调用次数和块的执行次数
+TEST(profile_generate_counts) {
+    CompileOutput out = compileWithProfile(pgoProgram, true, nullptr);
+    CHECK(out.success);
+    CHECK_EQ(out.profile.size(), (size_t)2);
+    CHECK(out.profile.hasName("hot"));
+    // 按本次编译的中间代码计算哈希查找
+    CompileOptions options;
+    options.passes.level = OPT_O1;
+    options.emitAsm = false;
+    options.emitIR = true;
+    int found = 0;
+    long long hottest = 0;
+    for (auto& part : splitFunctions(compileSource(pgoProgram, options).ir)) {
+        const string& name = part.front().result;
+        const FunctionProfile* fp = out.profile.find(name, hashFunction(part));
+        CHECK(fp != nullptr);
+        if (!fp) continue;
+        found++;
+        CHECK_EQ(fp->entries, name == "hot" ? 3LL : 1LL);
+        for (auto& b : fp->blocks) hottest = max(hottest, b.second);
+    }
+    CHECK_EQ(found, 2);
+    CHECK(hottest >= 1011);
+}
+
+TEST(profile_save_and_load) {
+    CompileOutput out = compileWithProfile(pgoProgram, true, nullptr);
+    string path = tempPath();
+    CHECK(out.profile.save(path));
+    Profile loaded;
+    string error;
+    CHECK(loaded.load(path, error));
+    CHECK_EQ(loaded.size(), out.profile.size());
+    {
+        ofstream(path) << "qprof 1\nfunction hot 12 3\nblock x 5\n";
+    }
+    Profile bad;
+    CHECK(!bad.load(path, error));
+    CHECK(error.find("malformed") != string::npos);
+    remove(path.c_str());
+}
+
+// 使用计数后块的顺序改变，结果不变；函数修改后计数被忽略并给出警告
+TEST(profile_use_keeps_semantics) {
+    Profile profile = compileWithProfile(pgoProgram, true, nullptr).profile;
+    CompileOutput plain = compileWithProfile(pgoProgram, false, nullptr);
+    CompileOutput guided = compileWithProfile(pgoProgram, false, &profile);
+    CHECK(plain.success && guided.success);
+    CHECK(guided.diagnostics.empty());
+    CHECK(plain.assembly != guided.assembly);
+
+    MipsSimulator a, b;
+    string error;
+    CHECK(a.assemble(plain.assembly, error) && a.run(error));
+    CHECK(b.assemble(guided.assembly, error) && b.run(error));
+    CHECK_EQ(b.result(), a.result());
+    CHECK_EQ(a.result(), EXECUTE(pgoProgram, OPT_O0));
+
+    string changed = pgoProgram;
+    changed.replace(changed.find("s * 3"), 5, "s * 4");
+    CompileOutput stale = compileWithProfile(changed, false, &profile);
+    CHECK(stale.success);
+    CHECK(!stale.diagnostics.empty() && stale.diagnostics[0].severity == Diagnostic::WARNING);
+    CHECK(!stale.diagnostics.empty() && stale.diagnostics[0].message.find("'hot'") != string::npos);
+}
@@ -0,0 +1,40 @@
+#include "test.h"
+#include "progen.h"
+
+// 同一个种子和大小生成相同的程序，不同的种子生成不同的程序
+TEST(progen_is_deterministic) {
+    for (int s = 0; s < SHAPE_COUNT; ++s) {
+        CHECK(generateProgram((ProgramShape)s, 5, 4 << 10) == generateProgram((ProgramShape)s, 5, 4 << 10));
+        CHECK(generateProgram((ProgramShape)s, 5, 4 << 10) != generateProgram((ProgramShape)s, 6, 4 << 10));
+    }
+}
+
+// main 调用每个函数，调用图优化之后所有函数都还在
+TEST(progen_main_reaches_every_function) {
+    string source = generateProgram(SHAPE_FUNCS, 3, 8 << 10);
+    CompileOptions options;
+    options.emitAsm = false;
+    options.emitIR = true;
+    options.passes.level = OPT_O0;
+    CompileOutput out = compileSource(source, options);
+    CHECK(out.success);
+    int functions = 0, calls = 0;
+    for (auto& q : out.ir) {
+        functions += q.op == OP_FUNC_BEGIN;
+        calls += q.op == OP_CALL;
+    }
+    CHECK(functions > 10);
+    CHECK_EQ(calls, functions - 1);
+}
+
+// 较大的程序：解释器、模拟器和 JIT 在 O0 与 O2 / Os 下结果都相同
+TEST(progen_engines_agree_across_levels) {
+    for (int s = 0; s < SHAPE_COUNT; ++s) {
+        for (uint64_t seed = 1; seed <= 2; ++seed) {
+            string source = generateProgram((ProgramShape)s, seed, 8 << 10);
+            int expected = EXECUTE(source, OPT_O0);
+            CHECK_EQ(EXECUTE(source, OPT_O2), expected);
+            CHECK_EQ(EXECUTE(source, OPT_OS), expected);
+        }
+    }
+}
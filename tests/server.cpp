@@ -0,0 +1,64 @@
+#include "test.h"
+#include "server.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+static string makeTempDir() {
+    char path[] = "/tmp/compiler-server-XXXXXX";
+    return mkdtemp(path) ? path : "";
+}
+
+static string readText(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+// 一个连接上依次编译多个文件：成功的输出与直接编译相同，失败的报告带文件名的诊断且不写输出；
+// 关闭请求之后服务正常退出
+TEST(server_compiles_and_stops) {
+    string dir = makeTempDir();
+    string socketPath = dir + "/s";
+    ofstream(dir + "/good.c") << "int f(int x) { return x * 3; }\nint main() { return f(5) + 1; }\n";
+    ofstream(dir + "/bad.c") << "int main() { return 1 +; }\n";
+
+    CompileOptions options;
+    options.quiet = true;
+    options.passes.level = OPT_O2;
+    CHECK(compileFile({dir + "/good.c", dir + "/direct.asm"}, options).success);
+
+    // 服务和客户端都向 cerr 报告状态，测试期间收集起来
+    ostringstream messages;
+    streambuf* saved = cerr.rdbuf(messages.rdbuf());
+    ThreadPool pool(2);
+    int serverStatus = -1;
+    thread server([&] { serverStatus = runServer(socketPath, options, pool); });
+    bool connected = false;
+    for (int i = 0; i < 500 && !connected; ++i) {
+        if (fs::exists(socketPath)) connected = runClient(socketPath, {}, false) == 0;
+        if (!connected) this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    int clientStatus = -1;
+    if (connected) {
+        clientStatus = runClient(socketPath,
+                                 {{dir + "/good.c", dir + "/good.asm"}, {dir + "/bad.c", dir + "/bad.asm"}}, true);
+    } else {
+        runClient(socketPath, {}, true);
+    }
+    server.join();
+    cerr.rdbuf(saved);
+
+    CHECK(connected);
+    CHECK_EQ(clientStatus, 1);
+    CHECK_EQ(serverStatus, 0);
+    string direct = readText(dir + "/direct.asm");
+    CHECK(!direct.empty());
+    CHECK(readText(dir + "/good.asm") == direct);
+    CHECK(!fs::exists(dir + "/bad.asm"));
+    CHECK(messages.str().find(dir + "/bad.c:1:") != string::npos);
+    fs::remove_all(dir);
+}
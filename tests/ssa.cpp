@@ -0,0 +1,99 @@
+#include "test.h"
+#include "progen.h"
+#include "ssa.h"
+#include "verifier.h"
+
+// 两轮 SSA 之后 x 组的颜色 1 和 x.1 组的原名曾经合并成同一个 x.1
+TEST(coalesce_names_unique_across_groups) {
+    string source = generateProgram(SHAPE_IDENTS, 14, 64 << 10);
+    int expected = EXECUTE(source, OPT_O0);
+    CHECK_EQ(expected, 942082518);
+    CHECK_EQ(EXECUTE(source, OPT_O2), expected);
+    CHECK_EQ(EXECUTE(source, OPT_OS), expected);
+}
+
+// 各种形状的小程序在 O0 与 O2 / Os 下结果相同
+TEST(optimized_matches_unoptimized) {
+    for (int s = 0; s < SHAPE_COUNT; ++s) {
+        for (uint64_t seed = 1; seed <= 8; ++seed) {
+            string source = generateProgram((ProgramShape)s, seed, 2 << 10);
+            int expected = EXECUTE(source, OPT_O0);
+            CHECK_EQ(EXECUTE(source, OPT_O2), expected);
+            CHECK_EQ(EXECUTE(source, OPT_OS), expected);
+        }
+    }
+}
+
+// 没有实际修改的一轮构造、还原 SSA 要得到相同的代码，否则 Os 到不了不动点；
+// 单独执行 gvn / sccp 时没有 DCE 清理被复制传播替换掉的定值
+TEST(os_reaches_fixpoint) {
+    string source =
+        "int main() {\n"
+        "    int x;\n"
+        "    int y;\n"
+        "    int z;\n"
+        "    x = 10;\n"
+        "    y = 0;\n"
+        "    z = 0;\n"
+        "    while (x) {\n"
+        "        y = y + x;\n"
+        "        z = x;\n"
+        "        x = x - 1;\n"
+        "    }\n"
+        "    return y + z;\n"
+        "}\n";
+    for (auto passes : {vector<string>{"gvn"}, {"sccp"}, {"sccp", "gvn"}, {}}) {
+        Execution e = execute(source, OPT_OS, passes);
+        CHECK_EQ(e.error, string());
+        CHECK_EQ(e.interp, 56);
+        CHECK_EQ(e.jit, 56);
+    }
+}
+
+// 只做 gvn 时输出的代码中没有重复的复制
+TEST(gvn_adds_no_copies) {
+    CompileOptions options;
+    options.emitAsm = false;
+    options.emitIR = true;
+    options.passes.enable = {"gvn"};
+    CompileOutput out = compileSource("int main() { int x; int y; x = 3; y = 0; while (x) { y = y + x; x = x - 1; } return y; }",
+                                      options);
+    CHECK(out.success);
+    int assigns = 0;
+    for (auto& q : out.ir) assigns += q.op == OP_ASSIGN;
+    CHECK_EQ(assigns, 4);
+}
+
+// 构造后每个变量只有一个定值，循环头插入 PHI；还原后不剩 PHI，并且能通过普通的校验
+TEST(ssa_build_and_destroy) {
+    string source =
+        "int main() {\n"
+        "    int i = 5;\n"
+        "    int s = 0;\n"
+        "    while (i) {\n"
+        "        if (i - 2) { s = s + i; } else { s = s * 2; }\n"
+        "        i = i - 1;\n"
+        "    }\n"
+        "    return s;\n"
+        "}\n";
+    CompileOptions options;
+    options.emitAsm = false;
+    options.emitIR = true;
+    options.passes.level = OPT_O0;
+    CompileOutput out = compileSource(source, options);
+    CHECK(out.success);
+
+    FunctionIR func(out.ir);
+    int phis = buildSSA(func);
+    CHECK(phis >= 2);
+    string error;
+    CHECK(verifySSA(func.codes, error));
+    CHECK(verifyFunction(func.codes, error));
+
+    destroySSA(func);
+    int remaining = 0;
+    for (auto& q : func.codes) remaining += q.op == OP_PHI;
+    CHECK_EQ(remaining, 0);
+    CHECK(verifyFunction(func.codes, error));
+    CHECK_EQ(EXECUTE(source, OPT_O2), 25);
+}
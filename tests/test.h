@@ -0,0 +1,62 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include "compiler.h"
+#include <string>
+#include <vector>
+#include <sstream>
+
+using namespace std;
+
+// 回归测试的最小框架：TEST 定义的用例在静态初始化时登记，由 tests/main.cpp 依次执行
+// CHECK 失败时记录位置和表达式，继续执行同一用例中其余的检查
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+vector<TestCase>& testRegistry();
+void testFailure(const char* file, int line, const string& message);
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) { testRegistry().push_back({name, run}); }
+};
+
+#define TEST(name)                                                 \
+    static void test_##name();                                     \
+    static TestRegistrar registrar_##name(#name, test_##name);     \
+    static void test_##name()
+
+#define CHECK(cond)                                                \
+    do {                                                           \
+        if (!(cond)) testFailure(__FILE__, __LINE__, #cond);       \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                             \
+    do {                                                           \
+        auto va_ = (a);                                            \
+        auto vb_ = (b);                                            \
+        if (!(va_ == vb_)) {                                       \
+            ostringstream os_;                                     \
+            os_ << #a " == " #b " (" << va_ << " vs " << vb_ << ")"; \
+            testFailure(__FILE__, __LINE__, os_.str());            \
+        }                                                          \
+    } while (0)
+
+// 在给定的优化级别编译源程序，再分别用解释器、MIPS 模拟器和 x86-64 JIT 执行
+struct Execution {
+    bool ok = false;        // 编译和三种执行都成功
+    string error;           // 第一个错误或警告
+    int interp = 0;
+    int sim = 0;
+    int jit = 0;
+};
+
+Execution execute(const string& source, OptLevel level, const vector<string>& passes = {});
+
+// 三种执行的结果一致时返回解释器的结果，否则记录失败并返回 0
+int executeAgreed(const char* file, int line, const string& source, OptLevel level);
+#define EXECUTE(source, level) executeAgreed(__FILE__, __LINE__, source, level)
+
+#endif
@@ -0,0 +1,48 @@
+#include "test.h"
+#include "threadpool.h"
+#include <stdexcept>
+
+// 每个下标恰好执行一次
+TEST(parallel_for_runs_each_index_once) {
+    ThreadPool pool(4);
+    vector<atomic<int>> hits(10000);
+    pool.parallelFor((int)hits.size(), [&](int i) { hits[i]++; });
+    int wrong = 0;
+    for (auto& h : hits) wrong += h != 1;
+    CHECK_EQ(wrong, 0);
+}
+
+// 池内任务中嵌套调用 parallelFor 不会死锁（文件级任务中再按函数并行）
+TEST(nested_parallel_for) {
+    ThreadPool pool(2);
+    atomic<int> total(0);
+    pool.parallelFor(8, [&](int) { pool.parallelFor(100, [&](int j) { total += j; }); });
+    CHECK_EQ(total.load(), 8 * 4950);
+
+    atomic<int> submitted(0);
+    for (int i = 0; i < 8; ++i) {
+        pool.submit([&] { pool.parallelFor(10, [&](int) { submitted++; }); });
+    }
+    pool.wait();
+    CHECK_EQ(submitted.load(), 80);
+}
+
+// 异常在调用线程上重新抛出，其余任务照常完成，线程池之后仍然可用
+TEST(parallel_for_rethrows) {
+    ThreadPool pool(3);
+    atomic<int> done(0);
+    bool caught = false;
+    try {
+        pool.parallelFor(50, [&](int i) {
+            if (i == 17) throw runtime_error("task 17");
+            done++;
+        });
+    } catch (const runtime_error& e) {
+        caught = string(e.what()) == "task 17";
+    }
+    CHECK(caught);
+    CHECK_EQ(done.load(), 49);
+    atomic<int> after(0);
+    pool.parallelFor(10, [&](int) { after++; });
+    CHECK_EQ(after.load(), 10);
+}
@@ -0,0 +1,74 @@
+#include "test.h"
+#include "x86jit.h"
+
+static vector<Quad> frontEnd(const string& source) {
+    CompileOptions options;
+    options.emitAsm = false;
+    options.emitIR = true;
+    options.passes.level = OPT_O0;
+    CompileOutput out = compileSource(source, options);
+    CHECK(out.success);
+    return out.ir;
+}
+
+// 每个函数单独翻译后链接，与 compileSource 中的用法相同
+static bool jitRun(X86JIT& jit, const string& source, string& error) {
+    vector<JitFunction> parts;
+    for (auto& f : splitFunctions(frontEnd(source))) parts.push_back(jitCompile(f));
+    return jit.link(parts, error) && jit.run(error);
+}
+
+// 补码回绕、除数为 0、INT_MIN / -1 与解释器和模拟器一致
+TEST(jit_arithmetic_edges) {
+    CHECK_EQ(EXECUTE("int main() { int x = 2147483647; return x + 1; }\n", OPT_O0), INT32_MIN);
+    CHECK_EQ(EXECUTE("int main() { int x = 7; int z = 0; return x / z; }\n", OPT_O0), 0);
+    CHECK_EQ(EXECUTE("int main() { int x = 0 - 2147483647 - 1; int m = 0 - 1; return x / m; }\n", OPT_O0),
+             INT32_MIN);
+    CHECK_EQ(EXECUTE("int main() { int x = 0 - 7; return x / 2; }\n", OPT_O0), -3);
+    CHECK_EQ(EXECUTE("int main() { int x = 46341; return x * x; }\n", OPT_O0), (int32_t)(46341u * 46341u));
+}
+
+// 迭代预算用尽时报告错误而不是死循环，之后同一段机器码可以再次执行
+TEST(jit_iteration_budget) {
+    X86JIT jit;
+    jit.setMaxIterations(1000);
+    string error;
+    CHECK(!jitRun(jit, "int main() { int x = 1; while (x) { x = x + 1; } return x; }\n", error));
+    CHECK(!error.empty());
+
+    X86JIT bounded;
+    bounded.setMaxIterations(1000);
+    CHECK(jitRun(bounded, "int main() { int x = 999; int s = 0; while (x) { s = s + x; x = x - 1; } return s; }\n",
+                 error));
+    CHECK_EQ(bounded.result(), 499500);
+    CHECK(bounded.run(error));
+    CHECK_EQ(bounded.result(), 499500);
+}
+
+// 无限递归耗尽栈帧区时报告栈溢出，深但有限的递归正常返回
+TEST(jit_stack_overflow) {
+    X86JIT jit;
+    string error;
+    CHECK(!jitRun(jit, "int f(int n) { return f(n + 1) + 1; }\nint main() { return f(0); }\n", error));
+    CHECK(error.find("stack") != string::npos);
+
+    X86JIT deep;
+    CHECK(jitRun(deep, "int f(int n) { if (n) { return f(n - 1) + 2; } return 0; }\nint main() { return f(20000); }\n",
+                 error));
+    CHECK_EQ(deep.result(), 40000);
+    CHECK(deep.hasReturned());
+}
+
+TEST(jit_link_errors) {
+    string error;
+    X86JIT dup;
+    JitFunction f = jitCompile(frontEnd("int main() { return 1; }\n"));
+    CHECK(!dup.link({f, f}, error));
+    CHECK(!error.empty());
+
+    X86JIT missing;
+    JitFunction g = jitCompile(frontEnd("int main() { return 1; }\n"));
+    g.fixups.push_back({0, "nowhere"});
+    CHECK(!missing.link({g}, error));
+    CHECK(error.find("nowhere") != string::npos);
+}